@@ -0,0 +1,119 @@
+/** @file AdmissionActor.hpp
+ * @brief Single writer admission actor API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for an actor style admission loop.  Instead
+ * of many client threads locking a shared State, a single (optionally
+ * pinned) owner thread owns the State.  Clients push their resource
+ * requests and releases into a lock free multi producer single
+ * consumer queue and get back a future.  The owner drains the queue
+ * in batches, runs the Resource Allocation Denial admission for each
+ * item and completes its future.
+ */
+#ifndef ADMISSION_ACTOR_HPP
+#define ADMISSION_ACTOR_HPP
+#include "State.hpp"
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace std;
+
+/// @brief The maximum number of queued items the owner thread
+///   handles before checking if it has been asked to stop.
+const int ADMISSION_BATCH_SIZE = 64;
+
+/// @brief Kinds of items clients can submit to the admission actor.
+enum AdmissionType
+{
+  /// Request resources, the future is true if granted
+  REQUEST_RESOURCES,
+  /// Release resources, the future is always true
+  RELEASE_RESOURCES
+};
+
+/** @struct AdmissionItem
+ * @brief An item queued for the admission actor
+ *
+ * A request or release submitted by a client.  Items are linked
+ * directly into the queue (an intrusive queue), so the queue needs
+ * no nodes of its own and pushing an item never allocates.  The
+ * item itself and its promise are allocated when it is submitted.
+ */
+struct AdmissionItem
+{
+  /// @brief The next item in the queue.
+  atomic<AdmissionItem*> next;
+  /// @brief Request or release.
+  AdmissionType type;
+  /// @brief The process making the request or release.
+  int process;
+  /// @brief The number of each resource requested or released.
+  int resources[MAX_RESOURCES];
+  /// @brief Completed by the owner thread with the admission result.
+  promise<bool> result;
+};
+
+/** @class AdmissionQueue
+ * @brief Lock free multi producer single consumer queue
+ *
+ * An intrusive MPSC queue of AdmissionItems (after Dmitry Vyukov's
+ * design).  Producers link an item in with a single atomic exchange
+ * of the head, the single consumer takes items from the tail.  A
+ * stub item keeps the queue from ever being truly empty.
+ */
+class AdmissionQueue
+{
+private:
+  /// @brief The most recently pushed item, where producers push.
+  atomic<AdmissionItem*> head;
+  /// @brief The oldest item, where the consumer pops.
+  AdmissionItem* tail;
+  /// @brief The stub item.
+  AdmissionItem stub;
+
+public:
+  AdmissionQueue();
+  void push(AdmissionItem* item);
+  AdmissionItem* pop();
+  bool isEmpty() const;
+};
+
+/** @class AdmissionActor
+ * @brief Single writer admission loop
+ *
+ * Owns a State and a thread that is the only thread to ever touch
+ * it.  Clients on any thread submit requests and releases, and wait
+ * on the returned futures for the results.
+ */
+class AdmissionActor
+{
+private:
+  /// @brief The state, only touched by the owner thread once started.
+  State state;
+  /// @brief The queue of submitted items.
+  AdmissionQueue queue;
+  /// @brief Set to ask the owner thread to stop.
+  atomic<bool> stopping;
+  /// @brief The number of submits between checking stopping and
+  ///   pushing their item.
+  atomic<int> pendingSubmits;
+  /// @brief The owner thread.
+  thread owner;
+
+  void run();
+  future<bool> submit(AdmissionType type, int process, const int resources[]);
+
+public:
+  AdmissionActor(const State& state, int cpu = -1);
+  ~AdmissionActor();
+  future<bool> submitRequest(int process, const int request[]);
+  future<bool> submitRelease(int process, const int release[]);
+  State stop();
+};
+
+#endif // ADMISSION_ACTOR_HPP
@@ -0,0 +1,87 @@
+/** @file CompactState.hpp
+ * @brief Compact claim/allocation state API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the CompactState class, an alternative
+ * memory layout of a State for when memory is the bottleneck.  A
+ * State keeps claim, allocation and need matrices, but the need is
+ * always claim - allocation, so a third of that memory is redundant.
+ * A CompactState keeps only the claims and allocations, with the
+ * claim and allocation of each process next to each other in one
+ * row, and computes needs on the fly inside the needs test kernel.
+ */
+#ifndef COMPACT_STATE_HPP
+#define COMPACT_STATE_HPP
+#include "State.hpp"
+#include <iosfwd>
+#include <vector>
+
+using namespace std;
+
+struct ResourceKernels;
+
+/** @class CompactState
+ * @brief Compact claim/allocation state
+ *
+ * A state with the same safety checks as State, but without a need
+ * matrix.  Row p of the compact matrix holds the numResources
+ * claims of process p followed by its numResources allocations, so
+ * testing and then releasing a process streams through one
+ * contiguous row.  A compact state is loaded from an already loaded
+ * State, after which its allocations can be replaced by streaming
+ * allocation snapshots as for a State.
+ */
+class CompactState
+{
+private:
+  /// @brief The number of resources in the system.
+  int numResources;
+
+  /// @brief The number of processes in the system.
+  int numProcesses;
+
+  /// @brief The claim and allocation matrix, each row holds the
+  ///   claims of a process followed by its allocations.
+  int rows[MAX_PROCESSES][2 * MAX_RESOURCES];
+
+  /// @brief The total resource vector.
+  int resourceTotal[MAX_RESOURCES];
+
+  /// @brief The available resources vector.
+  int resourceAvailable[MAX_RESOURCES];
+
+  /// @brief The vector kernels for this state's number of resources.
+  const ResourceKernels* kernels;
+
+  void inferAvailable();
+
+public:
+  CompactState();
+  explicit CompactState(const State& state);
+
+  // accessor methods
+  int getNumResources() const;
+  int getNumProcesses() const;
+  int getClaim(int process, int resource) const;
+  int getAllocation(int process, int resource) const;
+  int getNeed(int process, int resource) const;
+  int getResourceAvailable(int resource) const;
+
+  // methods to load the compact state
+  void loadState(const State& state);
+  bool loadAllocationSnapshot(istream& snapshots);
+
+  // Resource Allocation Denial methods, used to determine
+  // if current state is safe or not
+  bool needsAreMet(int process, const int currentAvailable[]) const;
+  int findCandidateProcess(const bool completed[], const int currentAvailable[]) const;
+  void releaseAllocatedResources(int process, int currentAvailable[]) const;
+  bool isSafe() const;
+  bool isSafe(vector<int>& safeSequence) const;
+};
+
+#endif // COMPACT_STATE_HPP
@@ -0,0 +1,113 @@
+/** @file ExternalSafety.hpp
+ * @brief Out-of-core safety evaluation API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for checking the safety of states with more
+ * processes than fit in memory.  Such a state is kept in an external
+ * state file of need and allocation rows, and only the available
+ * vector and one completed bit per process are held in memory.
+ *
+ * The external state file format is
+ *
+ * header:   magic "SIMX", numResources (4 byte little endian),
+ *           numProcesses (8 byte little endian), then the total and
+ *           available resource vectors (4 byte little endian each)
+ * rows:     one row per process, its need then its allocation of
+ *           each resource, as 4 byte ints in host byte order so
+ *           blocks of rows can be read straight into memory
+ *
+ * The checker streams the rows in large sequential blocks.  Each
+ * pass over the file completes every process that can run against
+ * the available vector at the time its row is reached, and passes
+ * repeat until one completes nothing more.  While one block is being
+ * checked the next one is read in the background into a second
+ * buffer, so the reading overlaps the checking.
+ */
+#ifndef EXTERNAL_SAFETY_HPP
+#define EXTERNAL_SAFETY_HPP
+#include "State.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// @brief default number of rows read per block
+const size_t DEFAULT_EXTERNAL_BLOCK_ROWS = size_t(1) << 16;
+
+/** @class ExternalStateWriter
+ * @brief Write an external state file one process at a time
+ *
+ * The rows of a state are appended one at a time, so a state of any
+ * size can be written without holding it in memory.  The number of
+ * processes and the available vector are only known once every row
+ * has been appended, and are filled into the header on close.
+ */
+class ExternalStateWriter
+{
+private:
+  /// @brief The external state file being written.
+  ofstream file;
+  /// @brief The total resource vector of the state.
+  vector<int> resourceTotal;
+  /// @brief The sum of the allocations appended of each resource.
+  vector<int64_t> allocationSum;
+  /// @brief The number of processes appended.
+  int64_t numProcesses;
+  /// @brief Set once the header has been completed.
+  bool closed;
+
+  bool finishHeader();
+
+public:
+  ExternalStateWriter(string filename, const vector<int>& total);
+  ~ExternalStateWriter();
+  void appendProcess(const int claim[], const int allocation[]);
+  void close();
+  int64_t getNumProcesses() const;
+};
+
+/** @class ExternalSafetyChecker
+ * @brief Out-of-core Banker's algorithm over an external state file
+ */
+class ExternalSafetyChecker
+{
+private:
+  /// @brief The descriptor of the external state file.
+  int fd;
+  /// @brief The number of resources of the state.
+  int numResources;
+  /// @brief The number of processes of the state.
+  int64_t numProcesses;
+  /// @brief The total resource vector of the state.
+  vector<int> resourceTotal;
+  /// @brief The available resource vector of the state.
+  vector<int> resourceAvailable;
+  /// @brief The number of rows read per block.
+  size_t blockRows;
+  /// @brief The number of passes the last check made over the rows.
+  int numPasses;
+
+  size_t readBlock(int64_t block, int rows[]) const;
+
+public:
+  ExternalSafetyChecker(string filename, size_t blockRows = DEFAULT_EXTERNAL_BLOCK_ROWS);
+  ~ExternalSafetyChecker();
+  ExternalSafetyChecker(const ExternalSafetyChecker&) = delete;
+  ExternalSafetyChecker& operator=(const ExternalSafetyChecker&) = delete;
+  int getNumResources() const;
+  int64_t getNumProcesses() const;
+  int getResourceAvailable(int resource) const;
+  int getNumPasses() const;
+  bool isSafe();
+};
+
+// write an in memory state as an external state file
+void writeExternalState(const State& state, string filename);
+
+#endif // EXTERNAL_SAFETY_HPP
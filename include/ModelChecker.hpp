@@ -0,0 +1,176 @@
+/** @file ModelChecker.hpp
+ * @brief Explicit state model checker API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for an explicit state model checker of
+ * request/release protocols.  Each process follows a bounded script
+ * of resource requests and releases.  The checker explores every
+ * interleaving of the scripts breadth first, and reports a shortest
+ * counterexample trace if some interleaving reaches a deadlock, a
+ * state where no process can take its next step but not all of
+ * them have finished.
+ *
+ * A global state is fully determined by the program counter of each
+ * process, so states are packed into a single 64 bit word of program
+ * counters.  The visited set is a lock free open addressing hash
+ * table of packed states, which also records the parent of each
+ * state for rebuilding traces, and each BFS frontier is expanded by
+ * several threads in parallel.
+ */
+#ifndef MODEL_CHECKER_HPP
+#define MODEL_CHECKER_HPP
+#include "State.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// @brief default number of slots of the visited set, each slot
+///   takes 16 bytes
+const size_t DEFAULT_VISITED_CAPACITY = size_t(1) << 20;
+
+/// @brief number of frontier states a thread takes at a time
+const size_t FRONTIER_CHUNK_SIZE = 256;
+
+/// @brief The kinds of steps of a process script.
+enum ScriptStepType
+{
+  /// Request resources, blocks until they can be granted
+  REQUEST_STEP,
+  /// Release resources, never blocks
+  RELEASE_STEP
+};
+
+/** @struct ScriptStep
+ * @brief One step of a process script
+ */
+struct ScriptStep
+{
+  /// @brief Request or release.
+  ScriptStepType type;
+  /// @brief The number of each resource requested or released.
+  vector<int> resources;
+};
+
+/** @struct ProcessScript
+ * @brief The bounded scripts of all processes of a protocol
+ *
+ * When a process has taken the last step of its script it finishes,
+ * and releases anything it still holds.
+ */
+struct ProcessScript
+{
+  /// @brief The total resource vector of the system.
+  vector<int> total;
+  /// @brief The steps of the script of each process.
+  vector<vector<ScriptStep>> steps;
+};
+
+/** @struct ModelCheckResult
+ * @brief The outcome of model checking a protocol
+ */
+struct ModelCheckResult
+{
+  /// @brief The number of distinct reachable states explored.
+  long numStates;
+  /// @brief The number of transitions explored.
+  long numTransitions;
+  /// @brief The number of BFS levels explored.
+  int depth;
+  /// @brief Whether a reachable deadlock was found.
+  bool deadlockFound;
+  /// @brief The processes stepped, in order, from the initial state
+  ///   to the deadlock, a shortest such trace.
+  vector<int> trace;
+  /// @brief The program counter of each process in the deadlock.
+  vector<int> deadlockCounters;
+};
+
+/** @class VisitedSet
+ * @brief Lock free set of packed states
+ *
+ * Open addressing hash table with linear probing.  A state is
+ * claimed by a single compare and swap of its slot's key, so any
+ * number of threads can insert concurrently, and exactly one of them
+ * succeeds for each state.  Keys are stored plus one so that an all
+ * zero slot is empty.  The parent of each state is written by the
+ * thread that inserted it, and must only be read once the inserting
+ * threads have been joined.
+ */
+class VisitedSet
+{
+private:
+  /// @brief The number of slots, a power of two.
+  size_t capacity;
+  /// @brief The packed state plus one held by each slot, or 0.
+  unique_ptr<atomic<uint64_t>[]> keys;
+  /// @brief The parent state of the state held by each slot.
+  unique_ptr<uint64_t[]> parents;
+  /// @brief The number of states inserted.
+  atomic<size_t> numKeys;
+
+  size_t findSlot(uint64_t key) const;
+
+public:
+  VisitedSet(size_t capacity);
+  bool insert(uint64_t key, uint64_t parent);
+  bool contains(uint64_t key) const;
+  uint64_t getParent(uint64_t key) const;
+  size_t size() const;
+};
+
+/** @class ModelChecker
+ * @brief Explicit state model checker
+ *
+ * Explores all interleavings of a process script.  Without deadlock
+ * avoidance a request is granted as soon as the resources are
+ * available.  With Resource Allocation Denial a request is only
+ * granted if the State after granting it is safe, where the claim
+ * of each process is the most of each resource it holds at any point
+ * of its script.
+ */
+class ModelChecker
+{
+private:
+  /// @brief The protocol being checked.
+  ProcessScript script;
+  /// @brief Whether requests are admitted by the Banker's algorithm.
+  bool avoidDeadlock;
+  /// @brief The number of threads expanding each frontier.
+  int numThreads;
+  /// @brief The number of slots of the visited set.
+  size_t visitedCapacity;
+  /// @brief The number of bits of each packed program counter.
+  int counterBits;
+  /// @brief The claim of each process, in row major order.
+  vector<int> claims;
+  /// @brief What each process holds at each program counter, one
+  ///   row of numResources values per step of each script, for
+  ///   process p and counter c at (holdingStart[p] + c) * numResources.
+  vector<int> holdings;
+  /// @brief The start of the holding rows of each process.
+  vector<int> holdingStart;
+
+  int getCounter(uint64_t packed, int process) const;
+  uint64_t setCounter(uint64_t packed, int process, int counter) const;
+  const int* getHolding(int process, int counter) const;
+  bool expand(uint64_t packed, State& state, vector<int>& allocations, vector<uint64_t>& successors) const;
+
+public:
+  ModelChecker(const ProcessScript& script, bool avoidDeadlock, int numThreads = 1,
+    size_t visitedCapacity = DEFAULT_VISITED_CAPACITY);
+  ModelCheckResult check();
+};
+
+// functions to load process scripts and display check results
+ProcessScript loadProcessScript(string filename);
+string modelCheckResultToString(const ModelCheckResult& result);
+
+#endif // MODEL_CHECKER_HPP
@@ -0,0 +1,92 @@
+/** @file NeedSummaryTree.hpp
+ * @brief Minimum need summary tree API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the minimum need summary tree, a skip
+ * structure for the candidate process search of a safety check.  The
+ * process rows are grouped into blocks, and a binary tree over the
+ * blocks keeps the element-wise minimum need of the processes below
+ * each node that have not completed.  A process can only run if its
+ * need fits in the available resources, so if the minimum need of a
+ * node does not fit, no process below it can run and the whole
+ * subtree is skipped.
+ */
+#ifndef NEED_SUMMARY_TREE_HPP
+#define NEED_SUMMARY_TREE_HPP
+#include "State.hpp"
+#include <climits>
+
+/// @brief number of process rows summarized by each leaf of the tree
+const int NEED_BLOCK_SIZE = 4;
+
+/// @brief number of blocks needed for the largest state
+const int NEED_BLOCKS = (MAX_PROCESSES + NEED_BLOCK_SIZE - 1) / NEED_BLOCK_SIZE;
+
+/**
+ * @brief tree leaves
+ *
+ * The number of leaves of a complete binary tree with at least the
+ * given number of blocks, the smallest power of two not less than
+ * the number of blocks.
+ *
+ * @param numBlocks The number of blocks to hold.
+ *
+ * @returns int The number of leaves of the tree.
+ */
+constexpr int needTreeLeaves(int numBlocks)
+{
+  return (numBlocks <= 1) ? 1 : 2 * needTreeLeaves((numBlocks + 1) / 2);
+}
+
+/// @brief number of leaves of the tree, node 1 is the root and the
+///   children of node i are 2i and 2i + 1, so leaves start here
+const int NEED_TREE_LEAVES = needTreeLeaves(NEED_BLOCKS);
+
+/// @brief minimum need of a node with no processes left below it,
+///   which never fits in the available resources
+const int EMPTY_NEED = INT_MAX;
+
+/** @class NeedSummaryTree
+ * @brief Minimum need summary tree
+ *
+ * Skip structure used by a safety check to find candidate processes.
+ * When a process completes we only mark the summaries above it as
+ * dirty, they are recomputed lazily the next time a search visits
+ * them, so completing processes costs nothing for subtrees that are
+ * never searched again.  Like a SafetyWorkspace, a tree is scratch
+ * space for one safety check at a time, and can be reused.
+ */
+class NeedSummaryTree
+{
+private:
+  /// @brief The state being checked.
+  const State* state;
+
+  /// @brief The element-wise minimum need of the processes below
+  ///   each node of the tree that have not completed.
+  int minimumNeed[2 * NEED_TREE_LEAVES][MAX_RESOURCES];
+
+  /// @brief Whether a process below each node has completed since
+  ///   the node's minimum need was last computed.
+  bool dirty[2 * NEED_TREE_LEAVES];
+
+  /// @brief The processes completed so far.
+  bool completed[MAX_PROCESSES];
+
+  void refresh(int node);
+  bool fits(int node, const int currentAvailable[]) const;
+  int search(int node, const int currentAvailable[]);
+
+public:
+  NeedSummaryTree();
+  void reset(const State& state);
+  int findCandidateProcess(const int currentAvailable[]);
+  bool isCompleted(int process) const;
+  void markCompleted(int process);
+};
+
+#endif // NEED_SUMMARY_TREE_HPP
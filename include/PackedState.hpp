@@ -0,0 +1,119 @@
+/** @file PackedState.hpp
+ * @brief Frame-of-reference bit packed state API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the PackedState class, a compressed in
+ * memory layout of the need and allocation matrices.  The values in
+ * a column of these matrices are usually small and close together,
+ * yet a State stores each of them in a 32 bit int.
+ *
+ * A PackedState splits the processes into blocks of
+ * PACKED_BLOCK_ROWS rows.  Within a block each column (one resource)
+ * is stored frame-of-reference encoded: the smallest value of the
+ * column in the block is kept as the base, and every value is stored
+ * as its offset from the base, packed into just as many bits as the
+ * largest offset of the column needs.  A column whose values are all
+ * equal takes no bits at all.
+ *
+ * The needs test works in the packed domain.  Since the base is the
+ * smallest need of the block, a block is skipped without decoding
+ * anything when any base is more than is available, and a column is
+ * known to fit for every process of the block when the available
+ * minus the base covers the largest offset.  Only the remaining
+ * columns have their offsets unpacked, and these are compared with
+ * the available minus the base, rather than decoded back to needs.
+ */
+#ifndef PACKED_STATE_HPP
+#define PACKED_STATE_HPP
+#include "State.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/// @brief the number of processes in each packed block
+const int PACKED_BLOCK_ROWS = 64;
+
+/** @struct PackedColumn
+ * @brief One frame-of-reference encoded column of a block
+ */
+struct PackedColumn
+{
+  /// @brief The smallest value of the column in the block.
+  int base;
+  /// @brief The largest offset from the base in the column.
+  uint32_t maxOffset;
+  /// @brief The number of bits each offset is packed into.
+  int width;
+  /// @brief The index of the first word of the packed offsets.
+  size_t offset;
+};
+
+/** @class PackedState
+ * @brief Frame-of-reference bit packed need and allocation state
+ *
+ * A state with the same safety check as State, keeping its need and
+ * allocation matrices bit packed.  Since it has no fixed size
+ * matrices, a packed state is not limited to MAX_PROCESSES
+ * processes.
+ */
+class PackedState
+{
+private:
+  /// @brief The number of resources in the system.
+  int numResources;
+
+  /// @brief The number of processes in the system.
+  int numProcesses;
+
+  /// @brief The total resource vector.
+  int resourceTotal[MAX_RESOURCES];
+
+  /// @brief The available resources vector.
+  int resourceAvailable[MAX_RESOURCES];
+
+  /// @brief The packed need columns, numResources per block.
+  vector<PackedColumn> needColumns;
+
+  /// @brief The packed allocation columns, numResources per block.
+  vector<PackedColumn> allocationColumns;
+
+  /// @brief The packed offsets of every column.
+  vector<uint64_t> words;
+
+  void packColumns(const vector<int>& values, vector<PackedColumn>& columns);
+  uint32_t unpackOffset(const PackedColumn& column, int row) const;
+  bool blockMayFit(int block, const int currentAvailable[]) const;
+
+public:
+  PackedState();
+  explicit PackedState(const State& state);
+
+  // accessor methods
+  int getNumResources() const;
+  int getNumProcesses() const;
+  int getNeed(int process, int resource) const;
+  int getAllocation(int process, int resource) const;
+  int getResourceTotal(int resource) const;
+  int getResourceAvailable(int resource) const;
+  size_t getPackedBytes() const;
+
+  // methods to load the packed state
+  void loadState(const State& state);
+  void loadState(int numProcesses, int numResources, const vector<int>& total, const vector<int>& claims,
+    const vector<int>& allocations);
+
+  // Resource Allocation Denial methods, used to determine
+  // if current state is safe or not
+  bool needsAreMet(int process, const int currentAvailable[]) const;
+  int findCandidateProcess(const vector<bool>& completed, const vector<int>& remaining, const int currentAvailable[]) const;
+  void releaseAllocatedResources(int process, int currentAvailable[]) const;
+  bool isSafe() const;
+  bool isSafe(vector<int>& safeSequence) const;
+};
+
+#endif // PACKED_STATE_HPP
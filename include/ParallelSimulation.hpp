@@ -0,0 +1,227 @@
+/** @file ParallelSimulation.hpp
+ * @brief Parallel discrete event workload simulation API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for a parallel discrete event simulation of a
+ * capacity planning workload.  The system is made up of independent
+ * resource groups, each with its own total resource vector and its
+ * own State, so admission is partitioned by group.  A job runs as a
+ * chain of stages, each stage in some group: the stage is initiated
+ * with its claim, requests the first half of its claim, at the
+ * midpoint of its duration requests the rest, and finishes releasing
+ * everything.  Moving on to the next stage of a job, possibly in
+ * another group, takes a fixed transfer delay.
+ *
+ * Groups are partitioned across threads, and synchronized
+ * conservatively with time windows.  Since no event can affect
+ * another group sooner than the transfer delay, all events earlier
+ * than the next event time plus the transfer delay can be simulated
+ * without hearing from the other groups.  Each group processes its
+ * events in a fixed total order, so the results do not depend on the
+ * number of threads.
+ */
+#ifndef PARALLEL_SIMULATION_HPP
+#define PARALLEL_SIMULATION_HPP
+#include "State.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** @struct WorkloadStage
+ * @brief One stage of a workload job
+ */
+struct WorkloadStage
+{
+  /// @brief The resource group the stage runs in.
+  int group;
+  /// @brief The number of ticks the stage runs once it holds its
+  ///   first half claim.
+  int duration;
+  /// @brief The claim of each resource of the group by the stage.
+  vector<int> claim;
+};
+
+/** @struct WorkloadJob
+ * @brief A job of a workload
+ */
+struct WorkloadJob
+{
+  /// @brief The tick at which the job arrives at its first stage.
+  long arrival;
+  /// @brief The stages of the job, run one after another.
+  vector<WorkloadStage> stages;
+};
+
+/** @struct Workload
+ * @brief A capacity planning workload
+ */
+struct Workload
+{
+  /// @brief The total resource vector of each resource group.
+  vector<vector<int>> groupTotal;
+  /// @brief The number of ticks between a stage finishing and the
+  ///   next stage of its job arriving, the lookahead of the parallel
+  ///   simulation.
+  int transferDelay;
+  /// @brief The jobs of the workload.
+  vector<WorkloadJob> jobs;
+};
+
+/** @struct WorkloadResult
+ * @brief The outcome of simulating a workload
+ */
+struct WorkloadResult
+{
+  /// @brief The number of events simulated.
+  long numEvents;
+  /// @brief The number of time windows simulated.
+  long numWindows;
+  /// @brief The number of jobs that finished their last stage.
+  long numCompleted;
+  /// @brief The tick at which the last stage finished.
+  long makespan;
+  /// @brief The number of ticks stages waited to be initiated,
+  ///   summed over all stages.
+  long totalWait;
+  /// @brief The number of ticks from arrival to finishing the last
+  ///   stage, summed over all jobs.
+  long totalResponse;
+  /// @brief The number of resource requests denied.
+  long numDeniedRequests;
+  /// @brief The fraction of all resources allocated, averaged over
+  ///   the makespan.
+  double utilization;
+};
+
+/// @brief The kinds of workload events, in the order they are handled
+///   when they happen at the same tick, so resources are released
+///   before they are asked for.
+enum WorkloadEventType
+{
+  STAGE_FINISH,
+  STAGE_MIDPOINT,
+  STAGE_ARRIVAL
+};
+
+/** @struct WorkloadEvent
+ * @brief An event of a workload stage
+ */
+struct WorkloadEvent
+{
+  /// @brief The tick the event happens at.
+  long time;
+  /// @brief What happens.
+  WorkloadEventType type;
+  /// @brief The job the event belongs to.
+  int job;
+  /// @brief The stage of the job the event belongs to.
+  int stage;
+
+  bool operator>(const WorkloadEvent& event) const;
+};
+
+/** @struct RunningStage
+ * @brief A stage initiated in a group, one per State process row
+ */
+struct RunningStage
+{
+  /// @brief The job the stage belongs to.
+  int job;
+  /// @brief The stage of the job.
+  int stage;
+  /// @brief Whether the stage is past its midpoint, and so asking for
+  ///   or holding its whole claim.
+  bool secondHalf;
+  /// @brief Whether the last request of the stage was denied, so it
+  ///   has to ask again.
+  bool blocked;
+};
+
+/** @class GroupSimulation
+ * @brief Sequential simulation of one resource group
+ *
+ * Holds the State, pending events and waiting stages of one group.
+ * Only one thread runs a group in a window, and stages moving on to
+ * other groups are handed back rather than scheduled directly.
+ */
+class GroupSimulation
+{
+private:
+  /// @brief The workload being simulated.
+  const Workload* workload;
+  /// @brief The admission policy of the group.
+  AdmissionPolicy policy;
+  /// @brief The processes running in the group.
+  State state;
+  /// @brief The stage running as each process of the state.
+  vector<RunningStage> running;
+  /// @brief The pending events of the group, earliest first.
+  priority_queue<WorkloadEvent, vector<WorkloadEvent>, greater<WorkloadEvent>> events;
+  /// @brief The arrival events of stages waiting to be initiated.
+  deque<WorkloadEvent> waiting;
+  /// @brief The tick of the last event handled.
+  long clock;
+
+  void advanceClock(long time);
+  int findProcess(int job) const;
+  void requestHalf(int process, long time);
+  void dispatch(long time);
+
+public:
+  /// @brief The number of events handled.
+  long numEvents;
+  /// @brief The number of jobs that finished their last stage here.
+  long numCompleted;
+  /// @brief The tick the last stage finished here.
+  long lastFinish;
+  /// @brief The ticks stages waited to be initiated here.
+  long totalWait;
+  /// @brief The response times of jobs that finished here.
+  long totalResponse;
+  /// @brief The number of requests denied here.
+  long numDeniedRequests;
+  /// @brief The allocated resource units integrated over time.
+  long allocatedTime;
+
+  GroupSimulation(const Workload& workload, int group, AdmissionPolicy policy);
+  void schedule(const WorkloadEvent& event);
+  long nextEventTime() const;
+  void run(long windowEnd, vector<WorkloadEvent>& outbox);
+};
+
+/** @class WindowBarrier
+ * @brief Reusable barrier for the threads simulating a window
+ */
+class WindowBarrier
+{
+private:
+  /// @brief The number of threads taking part.
+  int numThreads;
+  /// @brief The number of threads waiting at the barrier.
+  int numWaiting;
+  /// @brief The number of times the barrier has opened.
+  long generation;
+  mutex barrierMutex;
+  condition_variable opened;
+
+public:
+  WindowBarrier(int numThreads);
+  void wait();
+};
+
+// functions to load, generate, simulate and report on workloads
+Workload loadWorkload(string filename);
+Workload generateWorkload(int numGroups, int numResources, int numJobs, unsigned int seed);
+WorkloadResult simulateWorkload(const Workload& workload, AdmissionPolicy policy, int numThreads = 1);
+string workloadResultToString(AdmissionPolicy policy, const WorkloadResult& result);
+
+#endif // PARALLEL_SIMULATION_HPP
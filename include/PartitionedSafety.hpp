@@ -0,0 +1,26 @@
+/** @file PartitionedSafety.hpp
+ * @brief Partitioned multi-process safety check API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for a coordinator/worker version of the
+ * Banker's algorithm safety check.  The process rows of a State are
+ * partitioned into slices, and each slice is owned by a separate
+ * worker process.  Each round the coordinator broadcasts the current
+ * available vector to the workers, every worker completes all of the
+ * processes of its slice it can run, and sends back the resources
+ * they released.  The coordinator merges the released resources
+ * into the available vector, and repeats until no worker can make
+ * any more progress.  Workers talk to the coordinator over Unix
+ * domain sockets, a local stand in for workers on a cluster.
+ */
+#ifndef PARTITIONED_SAFETY_HPP
+#define PARTITIONED_SAFETY_HPP
+#include "State.hpp"
+
+bool partitionedIsSafe(const State& state, int numWorkers);
+
+#endif // PARTITIONED_SAFETY_HPP
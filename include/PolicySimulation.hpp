@@ -0,0 +1,73 @@
+/** @file PolicySimulation.hpp
+ * @brief Admission policy trace simulation API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for simulating a trace of arriving jobs under
+ * a deadlock avoidance admission policy, so that Resource Allocation
+ * Denial (Banker's algorithm) and Process Initiation Denial can be
+ * compared on the same traces.
+ *
+ * Time advances in ticks.  Each tick, processes holding their full
+ * claim finish and release everything, newly arrived jobs queue for
+ * initiation and are started in arrival order as the policy allows,
+ * and every running process then requests one more unit of each
+ * resource it still needs.
+ */
+#ifndef POLICY_SIMULATION_HPP
+#define POLICY_SIMULATION_HPP
+#include "State.hpp"
+#include <string>
+#include <vector>
+using namespace std;
+
+/** @struct TraceJob
+ * @brief A job of a policy trace
+ */
+struct TraceJob
+{
+  /// @brief The tick at which the job arrives and asks to be started.
+  int arrival;
+  /// @brief The claim of each resource by the job's process.
+  vector<int> claim;
+};
+
+/** @struct PolicyTrace
+ * @brief A trace of arriving jobs
+ */
+struct PolicyTrace
+{
+  /// @brief The total resource vector of the system.
+  vector<int> total;
+  /// @brief The jobs of the trace, in order of arrival.
+  vector<TraceJob> jobs;
+};
+
+/** @struct PolicyResult
+ * @brief The outcome of simulating a trace under a policy
+ */
+struct PolicyResult
+{
+  /// @brief The number of ticks until every job had finished.
+  long numTicks;
+  /// @brief The number of jobs finished.
+  long numCompleted;
+  /// @brief The number of ticks a job waited to be started, summed
+  ///   over all jobs.
+  long totalWait;
+  /// @brief The number of resource requests denied.
+  long numDeniedRequests;
+  /// @brief The fraction of all resources allocated, averaged over
+  ///   all ticks.
+  double utilization;
+};
+
+// functions to load, simulate and report on policy traces
+PolicyTrace loadPolicyTrace(string filename);
+PolicyResult simulatePolicy(const PolicyTrace& trace, AdmissionPolicy policy);
+string policyResultToString(AdmissionPolicy policy, const PolicyResult& result);
+
+#endif // POLICY_SIMULATION_HPP
@@ -0,0 +1,118 @@
+/** @file Replication.hpp
+ * @brief Primary/backup State replication API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for primary/backup replication of a live
+ * State by log shipping.  The primary admits resource requests and
+ * releases on its State as usual, and appends each change that was
+ * actually made to a log.  A background shipper thread sends the
+ * log in batches over a (Unix domain) socket to a hot standby, which
+ * applies the changes to its own copy of the State.  Shipping is
+ * asynchronous, so the grant path of the primary never waits on the
+ * standby, and if the primary fails the standby already holds the
+ * state as of the last batch shipped and can take over immediately.
+ *
+ * The log is a sequence of batches, each a 4 byte length followed by
+ * records.  The first record is a full snapshot of the primary's
+ * State ('S' followed by an encoded state), every other record is
+ * the allocation change of one granted request or release ('D'
+ * followed by an encoded state delta).
+ */
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+#include "State.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/** @class ReplicationPrimary
+ * @brief Primary side of State replication
+ *
+ * Wraps the State of the primary, all requests and releases should
+ * be made through the primary so they are replicated.  The methods
+ * may be called from multiple threads.
+ */
+class ReplicationPrimary
+{
+private:
+  /// @brief The replicated state, owned by the caller.
+  State& state;
+
+  /// @brief The socket connected to the standby, owned by the primary.
+  int socket;
+
+  /// @brief Protects the state and the log.
+  mutex logMutex;
+
+  /// @brief Signalled when records are added to the log or we stop.
+  condition_variable logWritten;
+
+  /// @brief Signalled when a batch of the log has been shipped.
+  condition_variable logShipped;
+
+  /// @brief The encoded records not yet shipped.
+  string pendingLog;
+
+  /// @brief The number of records logged so far.
+  uint64_t numLogged;
+
+  /// @brief The number of records shipped so far.
+  uint64_t numShipped;
+
+  /// @brief Set when the primary is shutting down.
+  bool stopping;
+
+  /// @brief Set if shipping to the standby failed.
+  bool failed;
+
+  /// @brief The background thread shipping the log.
+  thread shipper;
+
+  void logDelta(const StateDelta& delta);
+  void shipLog();
+
+public:
+  ReplicationPrimary(State& state, int socket);
+  ~ReplicationPrimary();
+  bool requestResources(int process, const int request[]);
+  void releaseResources(int process, const int release[]);
+  bool flush();
+};
+
+/** @class ReplicationStandby
+ * @brief Standby side of State replication
+ *
+ * Receives the log shipped by a ReplicationPrimary and applies it
+ * to its own State.  A standby is typically run in its own thread
+ * by calling receiveBatch() until it returns false, at which point
+ * the primary has gone away and the standby's state can be used.
+ */
+class ReplicationStandby
+{
+private:
+  /// @brief The standby's copy of the replicated state.
+  State state;
+
+  /// @brief The socket connected to the primary, owned by the standby.
+  int socket;
+
+  /// @brief The number of records applied so far.
+  uint64_t numApplied;
+
+public:
+  explicit ReplicationStandby(int socket);
+  ~ReplicationStandby();
+  bool receiveBatch();
+  const State& getState() const;
+  uint64_t getNumApplied() const;
+};
+
+#endif // REPLICATION_HPP
@@ -0,0 +1,138 @@
+/** @file ResourceKernels.hpp
+ * @brief Width specialized resource vector kernels
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * The inner loops of the Banker's algorithm (comparing a need row
+ * against the available vector, adding an allocation row back into
+ * the available vector and copying resource vectors) all run over
+ * exactly numResources columns.  Most of our states use one of a
+ * few common resource widths, so we instantiate versions of these
+ * loops with a compile time trip count for those widths, and
+ * select a table of them once when a state is loaded.  The loops
+ * themselves are the shared element-wise operations of VectorOps.hpp.
+ */
+#ifndef RESOURCE_KERNELS_HPP
+#define RESOURCE_KERNELS_HPP
+#include "VectorOps.hpp"
+
+/// @brief kernel to test if every need is less than or equal to
+///   the corresponding available resource
+typedef bool (*NeedsMetKernel)(int numResources, const int need[], const int available[]);
+
+/// @brief kernel to test if every need, computed on the fly as
+///   claim - allocation, is less than or equal to the corresponding
+///   available resource
+typedef bool (*ClaimNeedsMetKernel)(int numResources, const int claim[], const int allocation[], const int available[]);
+
+/// @brief kernel to add (accumulate) a source vector into a
+///   destination vector, e.g. dst += src
+typedef void (*AccumulateKernel)(int numResources, const int src[], int dst[]);
+
+/// @brief kernel to copy a source vector into a destination vector
+typedef void (*CopyKernel)(int numResources, const int src[], int dst[]);
+
+/** @struct ResourceKernels
+ * @brief Resource kernel dispatch table
+ *
+ * A table of function pointers to the vector kernels to use
+ * for one particular resource width.  The generic table has
+ * a width of 0 and works for any number of resources.
+ */
+struct ResourceKernels
+{
+  /// @brief The resource width these kernels are specialized
+  ///   for, or 0 for the generic counted loop kernels.
+  int width;
+  /// @brief need <= available test for one process row
+  NeedsMetKernel needsAreMet;
+  /// @brief claim - allocation <= available test for one process row,
+  ///   for layouts that do not store the need
+  ClaimNeedsMetKernel claimNeedsAreMet;
+  /// @brief dst += src, used to release allocations
+  AccumulateKernel accumulate;
+  /// @brief dst = src
+  CopyKernel copy;
+};
+
+/**
+ * @brief fixed width needs are met kernel
+ *
+ * Compare all WIDTH needs against the available resources.  The
+ * vector operations are inline, so with a compile time width the
+ * vector loop of vectorLessEqual() gets a fixed trip count, and for
+ * our widths, all multiples of VECTOR_LANES, no scalar remainder.
+ *
+ * @param numResources Ignored, the width is known at compile time.
+ * @param need The need row of a process.
+ * @param available The currently available resources.
+ *
+ * @returns bool true if every need can be met.
+ */
+template<int WIDTH>
+bool fixedNeedsAreMet(int /* numResources */, const int need[], const int available[])
+{
+  return vectorLessEqual(WIDTH, need, available);
+}
+
+/**
+ * @brief fixed width claim needs are met kernel
+ *
+ * Compare all WIDTH needs against the available resources, where
+ * the needs are computed from the claims and allocations as we go
+ * rather than loaded from a need matrix.
+ *
+ * @param numResources Ignored, the width is known at compile time.
+ * @param claim The claim row of a process.
+ * @param allocation The allocation row of a process.
+ * @param available The currently available resources.
+ *
+ * @returns bool true if every need can be met.
+ */
+template<int WIDTH>
+bool fixedClaimNeedsAreMet(int /* numResources */, const int claim[], const int allocation[], const int available[])
+{
+  return vectorDifferenceLessEqual(WIDTH, claim, allocation, available);
+}
+
+/**
+ * @brief fixed width accumulate kernel
+ *
+ * Add the WIDTH values of src into dst.
+ *
+ * @param numResources Ignored, the width is known at compile time.
+ * @param src The vector to add.
+ * @param dst The vector being accumulated into.
+ */
+template<int WIDTH>
+void fixedAccumulate(int /* numResources */, const int src[], int dst[])
+{
+  vectorAdd(WIDTH, src, dst);
+}
+
+/**
+ * @brief fixed width copy kernel
+ *
+ * Copy the WIDTH values of src into dst.
+ *
+ * @param numResources Ignored, the width is known at compile time.
+ * @param src The vector to copy from.
+ * @param dst The vector to copy into.
+ */
+template<int WIDTH>
+void fixedCopy(int /* numResources */, const int src[], int dst[])
+{
+  vectorCopy(WIDTH, src, dst);
+}
+
+// kernel selection and the generic fallback kernels
+const ResourceKernels* selectResourceKernels(int numResources);
+bool genericNeedsAreMet(int numResources, const int need[], const int available[]);
+bool genericClaimNeedsAreMet(int numResources, const int claim[], const int allocation[], const int available[]);
+void genericAccumulate(int numResources, const int src[], int dst[]);
+void genericCopy(int numResources, const int src[], int dst[]);
+
+#endif // RESOURCE_KERNELS_HPP
@@ -0,0 +1,137 @@
+/** @file SafetyEngine.hpp
+ * @brief Safety engine interface and autotuning selector API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the SafetyEngine interface, implemented by
+ * each of the ways we have of checking if a state is safe, and for
+ * the EngineSelector.  Which engine is fastest depends on the shape
+ * of the state and on the host, so the selector profiles every
+ * engine on representative states of each shape bucket (or loads
+ * the results of an earlier profile from a tuning file), and then
+ * dispatches each state to the fastest engine for its bucket.
+ */
+#ifndef SAFETY_ENGINE_HPP
+#define SAFETY_ENGINE_HPP
+#include "NeedSummaryTree.hpp"
+#include "SafetyWorkspace.hpp"
+#include "State.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// @brief number of buckets for the number of processes and for the
+///   number of resources, a bucket per power of two up to 32
+const int SIZE_BUCKETS = 6;
+
+/// @brief number of buckets for the fraction of nonzero needs
+const int DENSITY_BUCKETS = 4;
+
+/// @brief number of buckets for the width of the claim values, up to
+///   1, 4, 8 and more than 8 bits
+const int VALUE_WIDTH_BUCKETS = 4;
+
+/// @brief total number of shape buckets the selector tunes
+const int SHAPE_BUCKETS = SIZE_BUCKETS * SIZE_BUCKETS * DENSITY_BUCKETS * VALUE_WIDTH_BUCKETS;
+
+/// @brief default number of times each engine is timed on the
+///   representative state of each bucket while tuning
+const int TUNING_REPETITIONS = 32;
+
+/** @class SafetyEngine
+ * @brief Safety check engine interface
+ *
+ * An engine determines if a state is safe, all engines must give
+ * the same verdict as State::isSafe().  An engine may keep scratch
+ * space between checks, so an engine is used by one thread at a time.
+ */
+class SafetyEngine
+{
+public:
+  virtual ~SafetyEngine();
+  virtual string getName() const = 0;
+  virtual bool isSafe(const State& state) = 0;
+};
+
+/** @class ScanSafetyEngine
+ * @brief The plain scan of State::isSafe()
+ */
+class ScanSafetyEngine : public SafetyEngine
+{
+public:
+  string getName() const;
+  bool isSafe(const State& state);
+};
+
+/** @class WorkspaceSafetyEngine
+ * @brief State::isSafe() with a reusable workspace and completed bitmap
+ */
+class WorkspaceSafetyEngine : public SafetyEngine
+{
+private:
+  /// @brief The workspace reused by every check.
+  SafetyWorkspace workspace;
+
+public:
+  string getName() const;
+  bool isSafe(const State& state);
+};
+
+/** @class SummaryTreeSafetyEngine
+ * @brief State::isSafe() with a reusable minimum need summary tree
+ */
+class SummaryTreeSafetyEngine : public SafetyEngine
+{
+private:
+  /// @brief The summary tree reused by every check.
+  NeedSummaryTree tree;
+  /// @brief The safe sequence buffer reused by every check.
+  vector<int> safeSequence;
+
+public:
+  SummaryTreeSafetyEngine();
+  string getName() const;
+  bool isSafe(const State& state);
+};
+
+/** @class EngineSelector
+ * @brief Autotuning safety engine selector
+ *
+ * Holds one of each engine and the fastest engine found for each
+ * shape bucket, a bucket is the (number of processes, number of
+ * resources, need density, claim value width) of a state.  Until the
+ * selector is tuned, or for buckets the tuning file does not cover,
+ * the plain scan is used.
+ */
+class EngineSelector
+{
+private:
+  /// @brief The engines to select from.
+  vector<unique_ptr<SafetyEngine>> engines;
+  /// @brief The index of the engine selected for each shape bucket.
+  int selected[SHAPE_BUCKETS];
+
+  int findEngine(const string& name) const;
+
+public:
+  EngineSelector();
+  int getNumEngines() const;
+  SafetyEngine& getEngine(int engine);
+  void tune(int repetitions = TUNING_REPETITIONS);
+  void loadTuning(string filename);
+  void saveTuning(string filename) const;
+  SafetyEngine& select(const State& state);
+  bool isSafe(const State& state);
+};
+
+// helper functions to bucket states by shape, and to generate a
+// representative state of a bucket for profiling
+int shapeBucket(const State& state);
+State representativeState(int bucket);
+
+#endif // SAFETY_ENGINE_HPP
@@ -0,0 +1,60 @@
+/** @file SafetyWorkspace.hpp
+ * @brief Reusable safety check scratch space API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the scratch space used by the safety
+ * checks.  A safety check needs a working copy of the available
+ * resources, a record of which processes have completed, and the
+ * safe sequence found so far.  Keeping these in a workspace that the
+ * caller owns (typically one per thread) and passes in means repeated
+ * safety checks never allocate memory, and that many threads can
+ * check the same shared const State at once, since the checks only
+ * write to their own workspace.
+ */
+#ifndef SAFETY_WORKSPACE_HPP
+#define SAFETY_WORKSPACE_HPP
+#include "State.hpp"
+#include <cstdint>
+
+/// @brief number of processes tracked by each word of the
+///   completed bitmap
+const int BITMAP_WORD_BITS = 64;
+
+/// @brief number of words in the completed bitmap
+const int BITMAP_WORDS = (MAX_PROCESSES + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+
+/** @class SafetyWorkspace
+ * @brief Safety check scratch space
+ *
+ * Scratch buffers for one safety check at a time.  The available
+ * vector is cache line aligned, and completed processes are kept
+ * in a bitmap so a candidate search can skip over whole words of
+ * completed processes at once.
+ */
+class SafetyWorkspace
+{
+public:
+  /// @brief The resources available so far during the check.
+  alignas(64) int currentAvailable[MAX_RESOURCES];
+
+  /// @brief Bitmap of the processes completed so far, bit p % 64
+  ///   of word p / 64 is set once process p has completed.
+  uint64_t completed[BITMAP_WORDS];
+
+  /// @brief The (partial) safe sequence found by the last check.
+  int sequence[MAX_PROCESSES];
+
+  /// @brief The number of processes in the safe sequence.
+  int sequenceLength;
+
+  SafetyWorkspace();
+  void reset(int numResources, const int available[]);
+  bool isCompleted(int process) const;
+  void markCompleted(int process);
+};
+
+#endif // SAFETY_WORKSPACE_HPP
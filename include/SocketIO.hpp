@@ -0,0 +1,27 @@
+/** @file SocketIO.hpp
+ * @brief Unix domain socket helpers API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for the small set of socket helpers shared
+ * by the modes that ship state information between processes over
+ * Unix domain sockets, e.g. the partitioned safety check and
+ * primary/backup replication.
+ */
+#ifndef SOCKET_IO_HPP
+#define SOCKET_IO_HPP
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+bool writeBytes(int socket, const void* data, size_t numBytes);
+bool readBytes(int socket, void* data, size_t numBytes);
+int listenUnixSocket(const string& path);
+int acceptUnixSocket(int listener);
+int connectUnixSocket(const string& path);
+
+#endif // SOCKET_IO_HPP
@@ -15,10 +15,16 @@
  */
 #ifndef STATE_HPP
 #define STATE_HPP
+#include <iosfwd>
 #include <string>
+#include <vector>
 
 using namespace std;
 
+struct ResourceKernels;
+class SafetyWorkspace;
+class NeedSummaryTree;
+
 // to simplify memory management, we will just statically
 // allocate matrices/vectors that are needed for our
 // claim, allocation, etc.  We will simply check that if
@@ -46,6 +52,129 @@ const int BAD_VALUE = -1;
 ///   valid process id/index
 const int NO_CANDIDATE = -1;
 
+/// @brief The default number of processes listed in each of the
+///   top processes rankings of a state summary.
+const int SUMMARY_TOP_K = 5;
+
+/// @brief The kinds of problems validateState() can find in a
+///   loaded state, which would produce meaningless verdicts.
+enum ViolationType
+{
+  /// A claim, allocation or total resource value is negative
+  NEGATIVE_VALUE,
+  /// A process is allocated more of a resource than it claims,
+  /// so its need is negative
+  ALLOCATION_EXCEEDS_CLAIM,
+  /// More of a resource is allocated than exists in the system,
+  /// so the resource available is negative
+  RESOURCE_OVERSUBSCRIBED
+};
+
+/// @brief The deadlock avoidance policies a State can admit processes
+///   and resource requests under.
+enum AdmissionPolicy
+{
+  /// Resource Allocation Denial (Banker's algorithm), any process whose
+  /// claims fit in the system is started, and each request is only
+  /// granted if the resulting state is safe
+  RESOURCE_ALLOCATION_DENIAL,
+  /// Process Initiation Denial, a process is only started if the claims
+  /// of all processes together fit in the system, then every request
+  /// for available resources can be granted
+  PROCESS_INITIATION_DENIAL
+};
+
+/** @struct StateViolation
+ * @brief A state validation violation
+ *
+ * Describes one violation found by validating a State, and the
+ * coordinates where it was found.  Violations of the resource
+ * vectors have no process, and their process is NO_CANDIDATE.
+ */
+struct StateViolation
+{
+  /// @brief The kind of violation found.
+  ViolationType type;
+  /// @brief The process (row) of the violation, or NO_CANDIDATE
+  ///   if the violation is in a resource vector.
+  int process;
+  /// @brief The resource (column) of the violation.
+  int resource;
+  /// @brief The offending value, e.g. the negative need.
+  int value;
+};
+
+/** @struct CellDelta
+ * @brief A change to one cell of a State
+ *
+ * The change of the claim and allocation of one process for one
+ * resource between two states of the same shape.
+ */
+struct CellDelta
+{
+  /// @brief The process (row) of the changed cell.
+  int process;
+  /// @brief The resource (column) of the changed cell.
+  int resource;
+  /// @brief The change of the claim, new claim - old claim.
+  int claimDelta;
+  /// @brief The change of the allocation, new allocation - old allocation.
+  int allocationDelta;
+};
+
+/** @struct TotalDelta
+ * @brief A change to the total of one resource of a State
+ */
+struct TotalDelta
+{
+  /// @brief The resource whose total changed.
+  int resource;
+  /// @brief The change of the total, new total - old total.
+  int delta;
+};
+
+/** @struct StateDelta
+ * @brief A sparse delta between two states
+ *
+ * The sparse difference between two states of the same shape,
+ * as produced by State::diff().  Only the cells and resource
+ * totals that actually changed are present, in row major order.
+ */
+struct StateDelta
+{
+  /// @brief The changed claim/allocation cells.
+  vector<CellDelta> cells;
+  /// @brief The changed resource totals.
+  vector<TotalDelta> totals;
+};
+
+/** @struct UnsafeCertificate
+ * @brief Why a state is unsafe
+ *
+ * The evidence left behind by a failed safety check.  Once the
+ * Banker's algorithm finds no further process that can complete,
+ * the processes left are blocked, and comparing their needs to the
+ * resources then available shows which resources hold them back.
+ * The certificate of a safe state has no blocked processes.
+ */
+struct UnsafeCertificate
+{
+  /// @brief The resources available when no further process could
+  ///   complete.
+  vector<int> available;
+  /// @brief The processes that could not complete, in increasing order.
+  vector<int> blockedProcesses;
+  /// @brief How many more of each resource each blocked process
+  ///   needs than are available, one row of numResources values
+  ///   per blocked process, in row major order.
+  vector<int> shortfall;
+  /// @brief The number of blocked processes each resource holds back.
+  vector<int> blockedCount;
+  /// @brief The resources holding back at least one blocked process,
+  ///   ranked from the most to the fewest processes held back.
+  vector<int> bottleneckResources;
+};
+
 /** @class State
  * @brief State Class
  *
@@ -105,6 +234,53 @@ private:
   ///   minus those that are currently allocated to processes.
   int resourceAvailable[MAX_RESOURCES];
 
+  /// @brief The claim column sums.  This is a 1-d vector of size
+  ///   numResources that holds the sum of the claims of all
+  ///   processes for each resource type.  Process Initiation Denial
+  ///   only admits a new process if these sums plus its claims fit
+  ///   in the total resources, so they are kept up to date
+  ///   incrementally as processes are initiated and terminated.
+  int claimSum[MAX_RESOURCES];
+
+  /// @brief The table of vector kernels to use for this state's
+  ///   number of resources.  This is selected whenever the state
+  ///   information is (re)inferred, so that the needs test, release
+  ///   and copy loops can run kernels specialized for common widths.
+  const ResourceKernels* kernels;
+
+  /// @brief The number of negative need entries and negative
+  ///   available resources found the last time the state information
+  ///   was inferred.  A valid state has no negative values, a process
+  ///   can not be allocated more than it claims, and we can not
+  ///   allocate more of a resource than exists in the system.
+  int numNegativeValues;
+
+  /// @brief The number of nonzero need entries.  Counted while the
+  ///   state information is inferred and kept up to date as needs
+  ///   change, so a state can be bucketed by shape without a scan.
+  int numNonzeroNeeds;
+
+  /// @brief The largest claim.  Found while the state information
+  ///   is inferred and raised by any larger claim since, it is only
+  ///   lowered again by the next inference.
+  int maxClaim;
+
+  // helper methods used when inferring state information
+  int inferRows(int beginProcess, int endProcess, int allocationSum[], int partialClaimSum[], int claimMax[],
+    int& nonzeroNeeds);
+  void inferAvailable(const int allocationSum[], const int totalClaimSum[], int negativeNeeds, const int claimMax[],
+    int nonzeroNeeds);
+
+  // helper method to finish a safe sequence from a partial one
+  bool completeSafeSequence(int currentAvailable[], bool completed[], vector<int>& safeSequence) const;
+  bool revalidateSafeSequence(const bool affected[], bool availableShrank, vector<int>& safeSequence) const;
+
+  // helper method to gather the evidence of a failed safety check
+  void certifyUnsafe(const int currentAvailable[], const bool completed[], UnsafeCertificate& certificate) const;
+
+  // helper method to search for a candidate using a workspace
+  int findCandidateProcess(const SafetyWorkspace& workspace) const;
+
 public:
   // constructors and destructors
   State();
@@ -113,10 +289,24 @@ public:
   // accessor and mutator methods
   int getNumResources() const;
   int getNumProcesses() const;
+  int getNumNegativeValues() const;
+  int getClaim(int process, int resource) const;
+  int getAllocation(int process, int resource) const;
+  int getNeed(int process, int resource) const;
+  int getResourceTotal(int resource) const;
+  int getResourceAvailable(int resource) const;
+  int getClaimSum(int resource) const;
+  int getNumNonzeroNeeds() const;
+  int getMaxClaim() const;
 
   // methods to load, test, change and manipulate the state
-  void loadState(string filename);
+  void loadState(string filename, bool strict = false);
+  void loadState(int numProcesses, int numResources, const vector<int>& total, const vector<int>& claims,
+    const vector<int>& allocations);
+  bool loadAllocationSnapshot(istream& snapshots);
   void inferStateInformation();
+  void inferStateInformationParallel(int numThreads);
+  vector<StateViolation> validateState(bool strict = false) const;
 
   // Resource Allocation Denial methods, used to determine
   // if current state is safe or not
@@ -124,19 +314,50 @@ public:
   int findCandidateProcess(bool completed[], const int* currentAvailable) const;
   void releaseAllocatedResources(int process, int currentAvailable[]) const;
   bool isSafe() const;
+  bool isSafe(vector<int>& safeSequence) const;
+  bool isSafe(SafetyWorkspace& workspace) const;
+  bool isSafe(vector<int>& safeSequence, UnsafeCertificate& certificate) const;
+  bool isSafe(NeedSummaryTree& tree, vector<int>& safeSequence) const;
+
+  // Resource Allocation Denial admission, grant a request only if
+  // the resulting state is safe, and release of resources
+  bool requestResources(int process, const int request[], AdmissionPolicy policy = RESOURCE_ALLOCATION_DENIAL);
+  void releaseResources(int process, const int release[]);
+
+  // Process Initiation Denial admission, only start a new process
+  // if the claims of all processes together can always be met
+  bool canInitiateProcess(const int processClaim[], AdmissionPolicy policy = PROCESS_INITIATION_DENIAL) const;
+  int initiateProcess(const int processClaim[], AdmissionPolicy policy = PROCESS_INITIATION_DENIAL);
+  void terminateProcess(int process);
+
+  // methods to compare consecutive snapshots of a state, and to
+  // incrementally update a state by their differences
+  StateDelta diff(const State& other) const;
+  void applyDelta(const StateDelta& delta);
+  bool applyDelta(const StateDelta& delta, vector<int>& safeSequence);
+
+  // methods to grow or shrink the total of a resource online
+  void adjustCapacity(int resource, int delta);
+  bool adjustCapacity(int resource, int delta, vector<int>& safeSequence, vector<int>& infeasibleProcesses);
 
-  // methods to convert system state to a string, for debugging
-  // and display purposes
+  // methods to convert system state to a string, or write it out,
+  // for debugging and display purposes
   string tostring() const;
+  string summaryString(int topK = SUMMARY_TOP_K) const;
+  void writeState(int fd, int numThreads) const;
   friend ostream& operator<<(ostream& stream, const State& state);
 };
 
 // helper functions for our State and RAD simulation.  No need for
 // these to be member functions of State as they are generally useful.
-void skipComments(ifstream& simfile);
+void skipComments(istream& simfile);
 void copyVector(int numItems, const int srcVector[], int dstVector[]);
+string violationToString(const StateViolation& violation);
+string certificateToString(const UnsafeCertificate& certificate);
 string vectorToString(int numResources, const int vector[]);
 string matrixToString(int numProcesses, int numResources, const int matrix[][MAX_RESOURCES]);
+string matrixHeaderToString(int numResources);
+string matrixRowsToString(int beginProcess, int endProcess, int numResources, const int matrix[][MAX_RESOURCES]);
 
 #endif // STATE_HPP
 
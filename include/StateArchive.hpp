@@ -0,0 +1,120 @@
+/** @file StateArchive.hpp
+ * @brief State time series archive API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Header include file for our compressed archive of State
+ * snapshots.  Consecutive snapshots of a system usually only differ
+ * in a few cells, so rather than storing every snapshot as a full
+ * simulation file, an archive stores a full keyframe every so many
+ * snapshots, and sparse cell deltas in between.  All values are
+ * stored as zigzag encoded variable length integers (varints), so
+ * small values and small changes only take a byte or two.
+ *
+ * The archive file format is
+ *
+ * header:   magic "SIMA", keyframe interval (4 byte little endian)
+ * records:  one record per snapshot, a record type byte ('K' for
+ *           a keyframe or 'D' for a delta) followed by the encoded
+ *           state or delta
+ * index:    the file offset of each record (8 bytes each)
+ * trailer:  number of snapshots and offset of the index (8 bytes
+ *           each), and the magic "SIMI"
+ *
+ * The fixed size trailer and index entries allow a reader to seek
+ * to any snapshot in O(1), then reconstruct it from the nearest
+ * preceding keyframe and the deltas that follow it.
+ */
+#ifndef STATE_ARCHIVE_HPP
+#define STATE_ARCHIVE_HPP
+#include "State.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// @brief default number of snapshots between two keyframes
+const int DEFAULT_KEYFRAME_INTERVAL = 32;
+
+/** @class StateArchiveWriter
+ * @brief Write State snapshots to an archive
+ *
+ * Appends a series of State snapshots of the same shape to an
+ * archive file.  Every keyframeInterval snapshots a full keyframe
+ * is written, otherwise the delta from the previous snapshot.
+ */
+class StateArchiveWriter
+{
+private:
+  /// @brief The archive file being written.
+  ofstream archive;
+
+  /// @brief The number of snapshots between keyframes.
+  int keyframeInterval;
+
+  /// @brief The file offset of the record of each snapshot written.
+  vector<uint64_t> recordOffsets;
+
+  /// @brief The previous snapshot appended, deltas are computed
+  ///   against this snapshot.
+  State previous;
+
+  /// @brief Set once the index and trailer have been written.
+  bool closed;
+
+  bool finishIndex();
+
+public:
+  StateArchiveWriter(string filename, int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+  ~StateArchiveWriter();
+  void append(const State& state);
+  void close();
+  int getNumSnapshots() const;
+};
+
+/** @class StateArchiveReader
+ * @brief Read State snapshots from an archive
+ *
+ * Reconstructs any snapshot of an archive written by a
+ * StateArchiveWriter directly into a State.
+ */
+class StateArchiveReader
+{
+private:
+  /// @brief The archive file being read.
+  ifstream archive;
+
+  /// @brief The number of snapshots between keyframes.
+  int keyframeInterval;
+
+  /// @brief The number of snapshots in the archive.
+  int numSnapshots;
+
+  /// @brief The file offset of the record index.
+  uint64_t indexOffset;
+
+  uint64_t recordOffset(int snapshot);
+
+public:
+  explicit StateArchiveReader(string filename);
+  int getNumSnapshots() const;
+  void readSnapshot(int snapshot, State& state);
+};
+
+// encoding and decoding of states and deltas, also useful for
+// shipping states between processes
+void writeVarint(string& out, uint64_t value);
+uint64_t readVarint(const char*& in, const char* end);
+uint64_t zigzagEncode(int64_t value);
+int64_t zigzagDecode(uint64_t value);
+void encodeState(string& out, const State& state);
+void decodeState(const char*& in, const char* end, State& state);
+void encodeDelta(string& out, const StateDelta& delta, int numResources);
+void decodeDelta(const char*& in, const char* end, StateDelta& delta, int numResources);
+
+#endif // STATE_ARCHIVE_HPP
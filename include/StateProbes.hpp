@@ -0,0 +1,53 @@
+/** @file StateProbes.hpp
+ * @brief USDT static tracepoints of the State hot paths
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Static tracepoints in loading, inferring, safety checking and
+ * admission, so perf or bpftrace can look inside a running simulator
+ * without rebuilding it, for example
+ *
+ *   bpftrace -e 'usdt:./sim:banker:safety_candidate { @[arg0] = count(); }'
+ *
+ * Every probe of provider "banker" gets the same first four
+ * arguments: the process (or NO_CANDIDATE when no single process is
+ * involved), the number of processes, the number of resources, and
+ * the iteration count of the loop the probe is in.  Result probes
+ * add the outcome as a fifth argument.
+ *
+ * The probes are only compiled in when ENABLE_USDT is defined (make
+ * USDT=1), which needs sys/sdt.h from the systemtap sdt headers.  An
+ * enabled probe is a single nop until a tracer attaches to it.
+ * Without ENABLE_USDT the probes expand to nothing, their arguments
+ * are only evaluated for the compiler's benefit.
+ */
+#ifndef STATE_PROBES_HPP
+#define STATE_PROBES_HPP
+
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+#define STATE_PROBE(name, process, numProcesses, numResources, iteration) \
+  DTRACE_PROBE4(banker, name, process, numProcesses, numResources, iteration)
+#define STATE_PROBE_RESULT(name, process, numProcesses, numResources, iteration, result) \
+  DTRACE_PROBE5(banker, name, process, numProcesses, numResources, iteration, result)
+#else
+#define STATE_PROBE(name, process, numProcesses, numResources, iteration) \
+  do                                                                      \
+  {                                                                       \
+    (void)(process);                                                      \
+    (void)(numProcesses);                                                 \
+    (void)(numResources);                                                 \
+    (void)(iteration);                                                    \
+  } while (false)
+#define STATE_PROBE_RESULT(name, process, numProcesses, numResources, iteration, result) \
+  do                                                                                   \
+  {                                                                                    \
+    STATE_PROBE(name, process, numProcesses, numResources, iteration);                 \
+    (void)(result);                                                                    \
+  } while (false)
+#endif
+
+#endif // STATE_PROBES_HPP
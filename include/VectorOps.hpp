@@ -0,0 +1,385 @@
+/** @file VectorOps.hpp
+ * @brief Element-wise resource vector operations API/Includes
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Every element-wise loop over resource vectors (copying, adding an
+ * allocation row into the available vector, subtracting, comparing,
+ * taking minimums and maximums and summing columns while inferring a
+ * state) is done by one of these operations, so there is a single
+ * place to tune them.  When the compiler targets SSE2 the operations
+ * work VECTOR_LANES values at a time with SSE2 intrinsics, and a
+ * scalar loop handles the remaining values.  Without SSE2 only the
+ * scalar loop runs.
+ *
+ * The vectors are only guaranteed to hold numItems values, with no
+ * particular alignment, so all loads and stores are unaligned and we
+ * never read or write past the last value.
+ *
+ * The operations are defined inline here rather than in a separate
+ * translation unit, so that callers with a compile time number of
+ * items, such as the fixed width kernels of ResourceKernels.hpp, get
+ * loops with a compile time trip count.
+ */
+#ifndef VECTOR_OPS_HPP
+#define VECTOR_OPS_HPP
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+/// @brief the number of int values handled by one vector operation
+const int VECTOR_LANES = 4;
+
+#ifdef __SSE2__
+/**
+ * @brief load lanes
+ *
+ * @param values The first of VECTOR_LANES values to load.
+ *
+ * @returns __m128i The loaded values.
+ */
+inline __m128i loadLanes(const int values[])
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+/**
+ * @brief store lanes
+ *
+ * @param values Where to store the VECTOR_LANES values.
+ * @param lanes The values to store.
+ */
+inline void storeLanes(int values[], __m128i lanes)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values), lanes);
+}
+
+/**
+ * @brief select lanes
+ *
+ * SSE2 has no blend, so pick lanes with masks instead.
+ *
+ * @param mask All ones in the lanes to take from ifSet.
+ * @param ifSet The values of the masked lanes.
+ * @param ifClear The values of the other lanes.
+ *
+ * @returns __m128i The selected values.
+ */
+inline __m128i selectLanes(__m128i mask, __m128i ifSet, __m128i ifClear)
+{
+  return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+}
+
+/**
+ * @brief count set lanes
+ *
+ * @param mask A comparison result, all ones or all zeros in each lane.
+ *
+ * @returns int The number of lanes that are all ones.
+ */
+inline int countSetLanes(__m128i mask)
+{
+  return __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+}
+#endif
+
+/**
+ * @brief vector copy
+ *
+ * dst = src
+ *
+ * @param numItems The number of values to copy.
+ * @param src The vector to copy from.
+ * @param dst The vector to copy into.
+ */
+inline void vectorCopy(int numItems, const int src[], int dst[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    storeLanes(dst + item, loadLanes(src + item));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    dst[item] = src[item];
+  }
+}
+
+/**
+ * @brief vector add
+ *
+ * dst += src, used to release an allocation row into the available
+ * resources.
+ *
+ * @param numItems The number of values to add.
+ * @param src The vector to add.
+ * @param dst The vector being accumulated into.
+ */
+inline void vectorAdd(int numItems, const int src[], int dst[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    storeLanes(dst + item, _mm_add_epi32(loadLanes(dst + item), loadLanes(src + item)));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    dst[item] += src[item];
+  }
+}
+
+/**
+ * @brief vector subtract
+ *
+ * dst = first - second, dst may be either of the inputs.
+ *
+ * @param numItems The number of values to subtract.
+ * @param first The vector to subtract from.
+ * @param second The vector to subtract.
+ * @param dst The vector to hold the differences.
+ */
+inline void vectorSubtract(int numItems, const int first[], const int second[], int dst[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    storeLanes(dst + item, _mm_sub_epi32(loadLanes(first + item), loadLanes(second + item)));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    dst[item] = first[item] - second[item];
+  }
+}
+
+/**
+ * @brief vector minimum
+ *
+ * dst = min(first, second) element-wise, dst may be either input.
+ *
+ * @param numItems The number of values to compare.
+ * @param first The first vector.
+ * @param second The second vector.
+ * @param dst The vector to hold the minimums.
+ */
+inline void vectorMin(int numItems, const int first[], const int second[], int dst[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    __m128i firstLanes = loadLanes(first + item);
+    __m128i secondLanes = loadLanes(second + item);
+    storeLanes(dst + item, selectLanes(_mm_cmpgt_epi32(firstLanes, secondLanes), secondLanes, firstLanes));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    dst[item] = min(first[item], second[item]);
+  }
+}
+
+/**
+ * @brief vector maximum
+ *
+ * dst = max(first, second) element-wise, dst may be either input.
+ *
+ * @param numItems The number of values to compare.
+ * @param first The first vector.
+ * @param second The second vector.
+ * @param dst The vector to hold the maximums.
+ */
+inline void vectorMax(int numItems, const int first[], const int second[], int dst[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    __m128i firstLanes = loadLanes(first + item);
+    __m128i secondLanes = loadLanes(second + item);
+    storeLanes(dst + item, selectLanes(_mm_cmpgt_epi32(firstLanes, secondLanes), firstLanes, secondLanes));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    dst[item] = max(first[item], second[item]);
+  }
+}
+
+/**
+ * @brief vector less or equal
+ *
+ * Test first <= second for every value, the needs are met test.  We
+ * stop at the first group of values that fails.
+ *
+ * @param numItems The number of values to compare.
+ * @param first The vector that must not be larger, e.g. a need row.
+ * @param second The bounding vector, e.g. the available resources.
+ *
+ * @returns bool true if every value of first is at most the value of
+ *   second.
+ */
+inline bool vectorLessEqual(int numItems, const int first[], const int second[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(loadLanes(first + item), loadLanes(second + item))))
+    {
+      return false;
+    }
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    if (first[item] > second[item])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief vector difference less or equal
+ *
+ * Test first - second <= bound for every value, the needs are met
+ * test for layouts that compute the need from the claim and
+ * allocation.
+ *
+ * @param numItems The number of values to compare.
+ * @param first The vector to subtract from, e.g. a claim row.
+ * @param second The vector to subtract, e.g. an allocation row.
+ * @param bound The bounding vector, e.g. the available resources.
+ *
+ * @returns bool true if every difference is at most its bound.
+ */
+inline bool vectorDifferenceLessEqual(int numItems, const int first[], const int second[], const int bound[])
+{
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    __m128i difference = _mm_sub_epi32(loadLanes(first + item), loadLanes(second + item));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(difference, loadLanes(bound + item))))
+    {
+      return false;
+    }
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    if (first[item] - second[item] > bound[item])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief vector count negative
+ *
+ * @param numItems The number of values to look at.
+ * @param values The vector to count the negative values of.
+ *
+ * @returns int The number of negative values.
+ */
+inline int vectorCountNegative(int numItems, const int values[])
+{
+  int numNegative = 0;
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    numNegative += countSetLanes(_mm_cmplt_epi32(loadLanes(values + item), _mm_setzero_si128()));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    numNegative += (values[item] < 0);
+  }
+  return numNegative;
+}
+
+/**
+ * @brief vector count nonzero
+ *
+ * @param numItems The number of values to look at.
+ * @param values The vector to count the nonzero values of.
+ *
+ * @returns int The number of nonzero values.
+ */
+inline int vectorCountNonzero(int numItems, const int values[])
+{
+  int numNonzero = numItems;
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    numNonzero -= countSetLanes(_mm_cmpeq_epi32(loadLanes(values + item), _mm_setzero_si128()));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    numNonzero -= (values[item] == 0);
+  }
+  return numNonzero;
+}
+
+/**
+ * @brief vector infer row
+ *
+ * Infer the need row of one process, need = claim - allocation, and
+ * accumulate its allocations and claims into the column sums, all in
+ * a single pass over the row.
+ *
+ * @param numItems The number of resources of the row.
+ * @param claim The claim row of the process.
+ * @param allocation The allocation row of the process.
+ * @param need Returns the need row of the process.
+ * @param allocationSum The allocation column sums to accumulate into.
+ * @param claimSum The claim column sums to accumulate into.
+ *
+ * @returns int The number of negative needs of the row.
+ */
+inline int vectorInferRow(int numItems, const int claim[], const int allocation[], int need[], int allocationSum[],
+  int claimSum[])
+{
+  int numNegative = 0;
+  int item = 0;
+#ifdef __SSE2__
+  for (; item + VECTOR_LANES <= numItems; item += VECTOR_LANES)
+  {
+    __m128i claimLanes = loadLanes(claim + item);
+    __m128i allocationLanes = loadLanes(allocation + item);
+    __m128i needLanes = _mm_sub_epi32(claimLanes, allocationLanes);
+    storeLanes(need + item, needLanes);
+    storeLanes(allocationSum + item, _mm_add_epi32(loadLanes(allocationSum + item), allocationLanes));
+    storeLanes(claimSum + item, _mm_add_epi32(loadLanes(claimSum + item), claimLanes));
+    numNegative += countSetLanes(_mm_cmplt_epi32(needLanes, _mm_setzero_si128()));
+  }
+#endif
+  for (; item < numItems; item++)
+  {
+    need[item] = claim[item] - allocation[item];
+    allocationSum[item] += allocation[item];
+    claimSum[item] += claim[item];
+    numNegative += (need[item] < 0);
+  }
+  return numNegative;
+}
+
+#endif // VECTOR_OPS_HPP
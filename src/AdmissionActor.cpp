@@ -0,0 +1,300 @@
+/** @file AdmissionActor.cpp
+ * @brief Single writer admission actor implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the lock free admission queue and the admission
+ * actor owner thread.
+ */
+#include "AdmissionActor.hpp"
+#include "SimulatorException.hpp"
+#include <chrono>
+#include <exception>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+
+using namespace std;
+
+/// @brief number of times the owner thread polls an empty queue
+///   before it starts backing off, keeps latency low under load
+static const int IDLE_SPINS = 1000;
+
+/**
+ * @brief queue constructor
+ *
+ * Create an empty queue, holding only the stub item.
+ */
+AdmissionQueue::AdmissionQueue()
+  : head(&stub)
+  , tail(&stub)
+{
+  stub.next.store(nullptr);
+}
+
+/**
+ * @brief push an item
+ *
+ * Push an item onto the queue, may be called by any number of
+ * threads at the same time.  The exchange of the head orders the
+ * producers, the item then becomes visible to the consumer once
+ * the previous head is linked to it.
+ *
+ * @param item The item to push, owned by the queue until popped.
+ */
+void AdmissionQueue::push(AdmissionItem* item)
+{
+  item->next.store(nullptr, memory_order_relaxed);
+  AdmissionItem* previous = head.exchange(item, memory_order_acq_rel);
+  previous->next.store(item, memory_order_release);
+}
+
+/**
+ * @brief pop an item
+ *
+ * Pop the oldest item from the queue, must only be called by the
+ * single consumer thread.  An item is only handed out once its
+ * successor is linked, so no producer is still touching it.
+ *
+ * @returns AdmissionItem* The oldest item, or nullptr if the queue
+ *   is empty or the next item is still being pushed.
+ */
+AdmissionItem* AdmissionQueue::pop()
+{
+  AdmissionItem* oldest = tail;
+  AdmissionItem* next = oldest->next.load(memory_order_acquire);
+
+  // skip over the stub
+  if (oldest == &stub)
+  {
+    if (next == nullptr)
+    {
+      return nullptr;
+    }
+    tail = next;
+    oldest = next;
+    next = next->next.load(memory_order_acquire);
+  }
+
+  if (next != nullptr)
+  {
+    tail = next;
+    return oldest;
+  }
+
+  // the oldest item is the last one, unless a push is in progress
+  // put the stub back behind it so it can be handed out
+  if (oldest != head.load(memory_order_acquire))
+  {
+    return nullptr;
+  }
+  push(&stub);
+  next = oldest->next.load(memory_order_acquire);
+  if (next != nullptr)
+  {
+    tail = next;
+    return oldest;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief check if the queue is empty
+ *
+ * Must only be called by the single consumer thread.  The queue is
+ * truly empty when only the stub is left and no push is in progress,
+ * a push always exchanges the head before linking its item.  An
+ * empty pop() on the other hand may just mean a push is in progress.
+ *
+ * @returns bool true if the queue holds no items.
+ */
+bool AdmissionQueue::isEmpty() const
+{
+  return (tail == &stub) and (head.load(memory_order_acquire) == &stub) and (stub.next.load(memory_order_acquire) == nullptr);
+}
+
+/**
+ * @brief admission actor constructor
+ *
+ * Start an admission actor owning a copy of the given state.
+ *
+ * @param state The initial state, copied into the actor.
+ * @param cpu The cpu to pin the owner thread to, or -1 to leave
+ *   it to the scheduler.
+ */
+AdmissionActor::AdmissionActor(const State& state, int cpu)
+  : state(state)
+  , stopping(false)
+  , pendingSubmits(0)
+{
+  owner = thread(&AdmissionActor::run, this);
+
+  if (cpu >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(owner.native_handle(), sizeof(cpus), &cpus);
+  }
+}
+
+/**
+ * @brief admission actor destructor
+ *
+ * Stop the owner thread if it is still running.
+ */
+AdmissionActor::~AdmissionActor()
+{
+  if (owner.joinable())
+  {
+    stop();
+  }
+}
+
+/**
+ * @brief submit a request
+ *
+ * Submit a resource request, see State::requestResources().
+ *
+ * @param process The process making the request.
+ * @param request The number of each resource requested.
+ *
+ * @returns future<bool> Becomes true if the request was granted and
+ *   false if denied, or holds the SimulatorException if it was invalid.
+ */
+future<bool> AdmissionActor::submitRequest(int process, const int request[])
+{
+  return submit(REQUEST_RESOURCES, process, request);
+}
+
+/**
+ * @brief submit a release
+ *
+ * Submit a release of resources, see State::releaseResources().
+ *
+ * @param process The process releasing resources.
+ * @param release The number of each resource released.
+ *
+ * @returns future<bool> Becomes true once released, or holds the
+ *   SimulatorException if the release was invalid.
+ */
+future<bool> AdmissionActor::submitRelease(int process, const int release[])
+{
+  return submit(RELEASE_RESOURCES, process, release);
+}
+
+/**
+ * @brief submit an item
+ *
+ * Build an item and push it onto the queue for the owner thread.
+ * Once the actor has been asked to stop no more items are queued,
+ * the future fails right away instead.  A submit announces itself in
+ * pendingSubmits before it checks stopping, so the owner thread does
+ * not stop while an item is still being pushed.
+ *
+ * @param type Request or release.
+ * @param process The process making the request or release.
+ * @param resources The number of each resource.
+ *
+ * @returns future<bool> The future result of the item, holds a
+ *   SimulatorException if the actor has been stopped.
+ */
+future<bool> AdmissionActor::submit(AdmissionType type, int process, const int resources[])
+{
+  pendingSubmits.fetch_add(1);
+  if (stopping.load())
+  {
+    pendingSubmits.fetch_sub(1);
+    stringstream msg;
+    msg << "<AdmissionActor::submit> the actor has been stopped" << endl;
+    promise<bool> rejected;
+    rejected.set_exception(make_exception_ptr(SimulatorException(msg.str())));
+    return rejected.get_future();
+  }
+
+  AdmissionItem* item = new AdmissionItem;
+  item->type = type;
+  item->process = process;
+  copyVector(state.getNumResources(), resources, item->resources);
+  future<bool> result = item->result.get_future();
+  queue.push(item);
+  pendingSubmits.fetch_sub(1);
+  return result;
+}
+
+/**
+ * @brief stop the actor
+ *
+ * Ask the owner thread to stop once it has handled everything
+ * already submitted, and wait for it.  Anything submitted from now
+ * on is rejected.
+ *
+ * @returns State The final state owned by the actor.
+ */
+State AdmissionActor::stop()
+{
+  stopping.store(true);
+  owner.join();
+  return state;
+}
+
+/**
+ * @brief owner thread main loop
+ *
+ * Drain the queue in batches, handling each item against the state.
+ * When the queue is empty we spin for a while before backing off to
+ * short sleeps, so a busy actor reacts immediately but an idle one
+ * does not burn a cpu.  Once asked to stop we only exit when no
+ * submit is still pushing and the queue is truly empty, an empty
+ * pop() alone may just be a push in progress.
+ */
+void AdmissionActor::run()
+{
+  int idle = 0;
+  while (true)
+  {
+    int handled = 0;
+    AdmissionItem* item;
+    while (handled < ADMISSION_BATCH_SIZE and (item = queue.pop()) != nullptr)
+    {
+      try
+      {
+        if (item->type == REQUEST_RESOURCES)
+        {
+          item->result.set_value(state.requestResources(item->process, item->resources));
+        }
+        else
+        {
+          state.releaseResources(item->process, item->resources);
+          item->result.set_value(true);
+        }
+      }
+      catch (const SimulatorException&)
+      {
+        item->result.set_exception(current_exception());
+      }
+      delete item;
+      handled++;
+    }
+
+    if (handled > 0)
+    {
+      idle = 0;
+    }
+    else if (stopping.load() and (pendingSubmits.load() == 0) and queue.isEmpty())
+    {
+      break;
+    }
+    else if (++idle > IDLE_SPINS)
+    {
+      this_thread::sleep_for(chrono::microseconds(50));
+    }
+    else
+    {
+      this_thread::yield();
+    }
+  }
+}
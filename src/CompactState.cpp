@@ -0,0 +1,294 @@
+/** @file CompactState.cpp
+ * @brief Compact claim/allocation state implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the CompactState member functions.
+ */
+#include "CompactState.hpp"
+#include "ResourceKernels.hpp"
+#include "SimulatorException.hpp"
+#include "VectorOps.hpp"
+#include <istream>
+#include <sstream>
+
+/**
+ * @brief compact state constructor
+ *
+ * Create an empty compact state, the normal use is to then load it
+ * from a State.
+ */
+CompactState::CompactState()
+{
+  numProcesses = numResources = 0;
+  kernels = selectResourceKernels(numResources);
+}
+
+/**
+ * @brief compact state constructor
+ *
+ * Create a compact copy of a loaded State.
+ *
+ * @param state The state to copy.
+ */
+CompactState::CompactState(const State& state)
+{
+  loadState(state);
+}
+
+/**
+ * @brief number of resource types accessor
+ *
+ * @returns int The number of resource types present in the system.
+ */
+int CompactState::getNumResources() const
+{
+  return numResources;
+}
+
+/**
+ * @brief number of processes accessor
+ *
+ * @returns int The number of processes present in the system.
+ */
+int CompactState::getNumProcesses() const
+{
+  return numProcesses;
+}
+
+/**
+ * @brief claim accessor
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The claim of the process for the resource.
+ */
+int CompactState::getClaim(int process, int resource) const
+{
+  return rows[process][resource];
+}
+
+/**
+ * @brief allocation accessor
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The allocation of the resource to the process.
+ */
+int CompactState::getAllocation(int process, int resource) const
+{
+  return rows[process][numResources + resource];
+}
+
+/**
+ * @brief need accessor
+ *
+ * The need is not stored, it is computed from the claim and
+ * allocation.
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The need of the process for the resource.
+ */
+int CompactState::getNeed(int process, int resource) const
+{
+  return rows[process][resource] - rows[process][numResources + resource];
+}
+
+/**
+ * @brief available resource accessor
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The number of the resource currently available.
+ */
+int CompactState::getResourceAvailable(int resource) const
+{
+  return resourceAvailable[resource];
+}
+
+/**
+ * @brief load from state
+ *
+ * Load the claims, allocations and total resources of a loaded
+ * State into the compact layout.
+ *
+ * @param state The state to copy.
+ */
+void CompactState::loadState(const State& state)
+{
+  numProcesses = state.getNumProcesses();
+  numResources = state.getNumResources();
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      rows[process][resource] = state.getClaim(process, resource);
+      rows[process][numResources + resource] = state.getAllocation(process, resource);
+    }
+  }
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    resourceTotal[resource] = state.getResourceTotal(resource);
+  }
+  inferAvailable();
+}
+
+/**
+ * @brief load allocation snapshot
+ *
+ * Load the next allocation-only snapshot from a stream of them,
+ * replacing the allocations of this state, as
+ * State::loadAllocationSnapshot() does.  Only the allocation half of
+ * each row is written, and only once the whole snapshot has been
+ * read, so a truncated or malformed snapshot leaves the state as it
+ * was.
+ *
+ * @param snapshots The stream of snapshots to read the next one from.
+ *
+ * @returns bool true if a snapshot was loaded, false if the stream
+ *   has no more snapshots.
+ *
+ * @throws SimulatorException is thrown if the stream ends part way
+ *   through a snapshot or holds something other than a number.
+ */
+bool CompactState::loadAllocationSnapshot(istream& snapshots)
+{
+  skipComments(snapshots);
+  snapshots >> ws;
+  if (snapshots.fail() or snapshots.eof())
+  {
+    return false;
+  }
+
+  int snapshot[MAX_PROCESSES][MAX_RESOURCES];
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      if (not(snapshots >> snapshot[process][resource]))
+      {
+        stringstream msg;
+        msg << "<CompactState::loadAllocationSnapshot> truncated or malformed allocation snapshot at"
+            << " process = " << process << " resource = " << resource << endl;
+        throw SimulatorException(msg.str());
+      }
+    }
+  }
+
+  for (int process = 0; process < numProcesses; process++)
+  {
+    vectorCopy(numResources, snapshot[process], rows[process] + numResources);
+  }
+  inferAvailable();
+  return true;
+}
+
+/**
+ * @brief infer available resources
+ *
+ * resourceAvailable = resourceTotal - (sum of current allocations),
+ * and select the vector kernels for this number of resources.
+ */
+void CompactState::inferAvailable()
+{
+  copyVector(numResources, resourceTotal, resourceAvailable);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    vectorSubtract(numResources, resourceAvailable, rows[process] + numResources, resourceAvailable);
+  }
+  kernels = selectResourceKernels(numResources);
+}
+
+/**
+ * @brief Check if a process's resource needs can be met
+ *
+ * The needs are computed from the claim and allocation halves of
+ * the process row inside the kernel.
+ *
+ * @param process The process to check.
+ * @param currentAvailable The currently available resources.
+ *
+ * @returns true if the process's resource needs can be met.
+ */
+bool CompactState::needsAreMet(int process, const int currentAvailable[]) const
+{
+  return kernels->claimNeedsAreMet(numResources, rows[process], rows[process] + numResources, currentAvailable);
+}
+
+/**
+ * @brief Find a candidate process
+ *
+ * @param completed The processes that have already completed.
+ * @param currentAvailable The currently available resources.
+ *
+ * @returns The lowest numbered process that has not completed and
+ *   whose needs can be met, or NO_CANDIDATE if there is none.
+ */
+int CompactState::findCandidateProcess(const bool completed[], const int currentAvailable[]) const
+{
+  for (int process = 0; process < numProcesses; process++)
+  {
+    if (not completed[process] and needsAreMet(process, currentAvailable))
+    {
+      return process;
+    }
+  }
+  return NO_CANDIDATE;
+}
+
+/**
+ * @brief Release the resources allocated to a process
+ *
+ * @param process The process completing.
+ * @param currentAvailable The available resources, updated by
+ *   adding the allocations of the process.
+ */
+void CompactState::releaseAllocatedResources(int process, int currentAvailable[]) const
+{
+  kernels->accumulate(numResources, rows[process] + numResources, currentAvailable);
+}
+
+/**
+ * @brief Check if the state is safe
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool CompactState::isSafe() const
+{
+  vector<int> safeSequence;
+  return isSafe(safeSequence);
+}
+
+/**
+ * @brief Check if the state is safe, with safe sequence
+ *
+ * @param safeSequence Returns the (partial) safe sequence found,
+ *   any previous contents are replaced.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool CompactState::isSafe(vector<int>& safeSequence) const
+{
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  bool completed[MAX_PROCESSES] = {false};
+
+  safeSequence.clear();
+  int candidateProcess = findCandidateProcess(completed, currentAvailable);
+  while (candidateProcess != NO_CANDIDATE)
+  {
+    releaseAllocatedResources(candidateProcess, currentAvailable);
+    completed[candidateProcess] = true;
+    safeSequence.push_back(candidateProcess);
+    candidateProcess = findCandidateProcess(completed, currentAvailable);
+  }
+
+  return static_cast<int>(safeSequence.size()) == numProcesses;
+}
@@ -0,0 +1,493 @@
+/** @file ExternalSafety.cpp
+ * @brief Out-of-core safety evaluation implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of writing external state files, and of the
+ * multi-pass out-of-core safety check with double buffered reads.
+ */
+#include "ExternalSafety.hpp"
+#include "SimulatorException.hpp"
+#include "VectorOps.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief magic number at the start of an external state file
+static const char EXTERNAL_MAGIC[] = "SIMX";
+/// @brief size of the fixed part of the header, magic, numResources
+///   and numProcesses
+static const int EXTERNAL_FIXED_HEADER_SIZE = 16;
+/// @brief offset of numProcesses in the header
+static const int EXTERNAL_NUM_PROCESSES_OFFSET = 8;
+
+/**
+ * @brief write fixed size integer
+ *
+ * Write the low numBytes bytes of value to the stream, in little
+ * endian order, as used for the header.
+ *
+ * @param out The stream to write to.
+ * @param value The value to write.
+ * @param numBytes The number of bytes to write.
+ */
+static void writeFixed(ostream& out, uint64_t value, int numBytes)
+{
+  for (int byte = 0; byte < numBytes; byte++)
+  {
+    out.put(static_cast<char>((value >> (8 * byte)) & 0xff));
+  }
+}
+
+/**
+ * @brief read fixed size integer
+ *
+ * Read a numBytes little endian integer from a buffer.
+ *
+ * @param in The buffer holding the integer.
+ * @param numBytes The number of bytes to read.
+ *
+ * @returns uint64_t The value read.
+ */
+static uint64_t readFixed(const char* in, int numBytes)
+{
+  uint64_t value = 0;
+  for (int byte = 0; byte < numBytes; byte++)
+  {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(in[byte])) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * @brief header size
+ *
+ * @param numResources The number of resources of the state.
+ *
+ * @returns int64_t The size of the header, where the rows start.
+ */
+static int64_t headerSize(int numResources)
+{
+  return EXTERNAL_FIXED_HEADER_SIZE + 2 * 4 * numResources;
+}
+
+/**
+ * @brief external state writer constructor
+ *
+ * Create the external state file and write a header, whose number of
+ * processes and available vector are filled in on close.
+ *
+ * @param filename The name of the external state file to create.
+ * @param total The total resource vector of the state.
+ *
+ * @throws SimulatorException is thrown if the number of resources is
+ *   not supported or the file can not be created.
+ */
+ExternalStateWriter::ExternalStateWriter(string filename, const vector<int>& total)
+  : file(filename, ios::binary | ios::trunc)
+{
+  if ((total.size() < 1) or (total.size() > static_cast<size_t>(MAX_RESOURCES)) or not file.is_open())
+  {
+    stringstream msg;
+    msg << "<ExternalStateWriter> could not create external state file of " << total.size()
+        << " resources: " << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  resourceTotal = total;
+  allocationSum.assign(total.size(), 0);
+  numProcesses = 0;
+  closed = false;
+
+  file.write(EXTERNAL_MAGIC, 4);
+  writeFixed(file, total.size(), 4);
+  writeFixed(file, 0, 8);
+  for (int resource : total)
+  {
+    writeFixed(file, static_cast<uint32_t>(resource), 4);
+  }
+  for (size_t resource = 0; resource < total.size(); resource++)
+  {
+    writeFixed(file, 0, 4);
+  }
+}
+
+/**
+ * @brief external state writer destructor
+ *
+ * Make sure the header is complete even if close() was never called.
+ * A destructor must not throw, so a failure to complete it is only
+ * reported by an explicit close().
+ */
+ExternalStateWriter::~ExternalStateWriter()
+{
+  if (not closed)
+  {
+    finishHeader();
+  }
+}
+
+/**
+ * @brief append process
+ *
+ * Append the row of the next process, its need is inferred from its
+ * claim and allocation.
+ *
+ * @param claim The claim of each resource by the process.
+ * @param allocation The allocation of each resource to the process.
+ *
+ * @throws SimulatorException is thrown if the writer was closed, or
+ *   writing the file has failed.
+ */
+void ExternalStateWriter::appendProcess(const int claim[], const int allocation[])
+{
+  if (closed)
+  {
+    stringstream msg;
+    msg << "<ExternalStateWriter::appendProcess> writer is closed" << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int numResources = resourceTotal.size();
+  int row[2 * MAX_RESOURCES];
+  vectorSubtract(numResources, claim, allocation, row);
+  vectorCopy(numResources, allocation, row + numResources);
+  file.write(reinterpret_cast<const char*>(row), 2 * numResources * sizeof(int));
+  if (file.fail())
+  {
+    stringstream msg;
+    msg << "<ExternalStateWriter::appendProcess> failed writing process " << numProcesses << endl;
+    throw SimulatorException(msg.str());
+  }
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    allocationSum[resource] += allocation[resource];
+  }
+  numProcesses++;
+}
+
+/**
+ * @brief finish header
+ *
+ * Fill the number of processes and the available vector into the
+ * header and close the file, without throwing.
+ *
+ * @returns bool true if the file was written, false if writing it
+ *   failed.
+ */
+bool ExternalStateWriter::finishHeader()
+{
+  closed = true;
+  file.seekp(EXTERNAL_NUM_PROCESSES_OFFSET);
+  writeFixed(file, numProcesses, 8);
+  file.seekp(EXTERNAL_FIXED_HEADER_SIZE + 4 * resourceTotal.size());
+  for (size_t resource = 0; resource < resourceTotal.size(); resource++)
+  {
+    writeFixed(file, static_cast<uint32_t>(resourceTotal[resource] - allocationSum[resource]), 4);
+  }
+  file.close();
+  return not file.fail();
+}
+
+/**
+ * @brief close
+ *
+ * Fill the number of processes and the available vector into the
+ * header and close the file.
+ *
+ * @throws SimulatorException is thrown if writing the file failed.
+ */
+void ExternalStateWriter::close()
+{
+  if (not finishHeader())
+  {
+    stringstream msg;
+    msg << "<ExternalStateWriter::close> failed writing external state file" << endl;
+    throw SimulatorException(msg.str());
+  }
+}
+
+/**
+ * @brief number of processes accessor
+ *
+ * @returns int64_t The number of processes appended so far.
+ */
+int64_t ExternalStateWriter::getNumProcesses() const
+{
+  return numProcesses;
+}
+
+/**
+ * @brief external safety checker constructor
+ *
+ * Open an external state file and read its header.
+ *
+ * @param filename The name of the external state file.
+ * @param blockRows The number of rows to read per block, each of the
+ *   two buffers takes blockRows * 2 * numResources ints.
+ *
+ * @throws SimulatorException is thrown if the file can not be opened,
+ *   is not an external state file, or its size does not match its
+ *   header.
+ */
+ExternalSafetyChecker::ExternalSafetyChecker(string filename, size_t blockRows)
+{
+  this->blockRows = max(blockRows, size_t(1));
+  numPasses = 0;
+  fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    stringstream msg;
+    msg << "<ExternalSafetyChecker> could not open external state file: " << filename << " " << strerror(errno)
+        << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  char header[EXTERNAL_FIXED_HEADER_SIZE + 2 * 4 * MAX_RESOURCES];
+  ssize_t numRead = pread(fd, header, EXTERNAL_FIXED_HEADER_SIZE, 0);
+  numResources = (numRead == EXTERNAL_FIXED_HEADER_SIZE) ? readFixed(header + 4, 4) : 0;
+  numProcesses = (numRead == EXTERNAL_FIXED_HEADER_SIZE) ? readFixed(header + EXTERNAL_NUM_PROCESSES_OFFSET, 8) : 0;
+  bool valid = (numRead == EXTERNAL_FIXED_HEADER_SIZE) and (string(header, 4) == EXTERNAL_MAGIC) and
+               (numResources >= 1) and (numResources <= MAX_RESOURCES) and (numProcesses >= 0);
+  if (valid)
+  {
+    int vectorsSize = headerSize(numResources) - EXTERNAL_FIXED_HEADER_SIZE;
+    valid = pread(fd, header + EXTERNAL_FIXED_HEADER_SIZE, vectorsSize, EXTERNAL_FIXED_HEADER_SIZE) == vectorsSize;
+  }
+  struct stat fileStat;
+  if (valid)
+  {
+    int64_t rowBytes = 2 * sizeof(int) * numResources;
+    valid = (fstat(fd, &fileStat) == 0) and (fileStat.st_size == headerSize(numResources) + numProcesses * rowBytes);
+  }
+  if (not valid)
+  {
+    ::close(fd);
+    stringstream msg;
+    msg << "<ExternalSafetyChecker> not an external state file, or it is truncated: " << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    resourceTotal.push_back(static_cast<int32_t>(readFixed(header + EXTERNAL_FIXED_HEADER_SIZE + 4 * resource, 4)));
+    resourceAvailable.push_back(
+      static_cast<int32_t>(readFixed(header + EXTERNAL_FIXED_HEADER_SIZE + 4 * (numResources + resource), 4)));
+  }
+}
+
+/**
+ * @brief external safety checker destructor
+ */
+ExternalSafetyChecker::~ExternalSafetyChecker()
+{
+  ::close(fd);
+}
+
+/**
+ * @brief read block
+ *
+ * Read the rows of one block.  Uses pread(), so a block can be read
+ * by a background thread without sharing a file position.
+ *
+ * @param block The block to read.
+ * @param rows Returns the rows of the block.
+ *
+ * @returns size_t The number of rows in the block, the last block
+ *   may be short.
+ *
+ * @throws SimulatorException is thrown if the read fails.
+ */
+size_t ExternalSafetyChecker::readBlock(int64_t block, int rows[]) const
+{
+  int64_t firstRow = block * blockRows;
+  size_t numRows = min<int64_t>(blockRows, numProcesses - firstRow);
+  size_t rowBytes = 2 * sizeof(int) * numResources;
+  char* buffer = reinterpret_cast<char*>(rows);
+  size_t numBytes = numRows * rowBytes;
+  off_t offset = headerSize(numResources) + firstRow * rowBytes;
+
+  size_t numRead = 0;
+  while (numRead < numBytes)
+  {
+    ssize_t result = pread(fd, buffer + numRead, numBytes - numRead, offset + numRead);
+    if ((result < 0) and (errno == EINTR))
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      stringstream msg;
+      msg << "<ExternalSafetyChecker::readBlock> failed reading block " << block << " "
+          << ((result < 0) ? strerror(errno) : "unexpected end of file") << endl;
+      throw SimulatorException(msg.str());
+    }
+    numRead += result;
+  }
+  return numRows;
+}
+
+/**
+ * @brief number of resource types accessor
+ *
+ * @returns int The number of resources of the state.
+ */
+int ExternalSafetyChecker::getNumResources() const
+{
+  return numResources;
+}
+
+/**
+ * @brief number of processes accessor
+ *
+ * @returns int64_t The number of processes of the state.
+ */
+int64_t ExternalSafetyChecker::getNumProcesses() const
+{
+  return numProcesses;
+}
+
+/**
+ * @brief resource available accessor
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The available count of the resource in the state.
+ */
+int ExternalSafetyChecker::getResourceAvailable(int resource) const
+{
+  return resourceAvailable[resource];
+}
+
+/**
+ * @brief number of passes accessor
+ *
+ * @returns int The number of passes the last isSafe() made.
+ */
+int ExternalSafetyChecker::getNumPasses() const
+{
+  return numPasses;
+}
+
+/**
+ * @brief Check if the external state is safe
+ *
+ * Out-of-core version of the Banker's algorithm.  Each pass streams
+ * the rows of every block that still has processes that have not
+ * completed, and completes each such process whose need can be met
+ * by what is available when its row comes by.  A block is read in
+ * the background while the previous one is checked.  Passes repeat
+ * until every process has completed, or a pass completes nothing, in
+ * which case the state is unsafe.  Completing processes as soon as
+ * they can run, rather than lowest number first, finds the same
+ * verdict, since releasing resources never stops another process
+ * from running.
+ *
+ * @returns bool true if the state is safe, false otherwise.
+ *
+ * @throws SimulatorException is thrown if reading the file fails.
+ */
+bool ExternalSafetyChecker::isSafe()
+{
+  int currentAvailable[MAX_RESOURCES];
+  vectorCopy(numResources, resourceAvailable.data(), currentAvailable);
+
+  int64_t numBlocks = (numProcesses + blockRows - 1) / blockRows;
+  vector<uint64_t> completed((numProcesses + 63) / 64, 0);
+  vector<int64_t> remaining(numBlocks);
+  for (int64_t block = 0; block < numBlocks; block++)
+  {
+    remaining[block] = min<int64_t>(blockRows, numProcesses - block * blockRows);
+  }
+  vector<int> buffers[2];
+  buffers[0].resize(blockRows * 2 * numResources);
+  buffers[1].resize(blockRows * 2 * numResources);
+
+  int64_t numCompleted = 0;
+  bool progress = true;
+  numPasses = 0;
+  while (progress and (numCompleted < numProcesses))
+  {
+    numPasses++;
+    progress = false;
+    vector<int64_t> blocks;
+    for (int64_t block = 0; block < numBlocks; block++)
+    {
+      if (remaining[block] > 0)
+      {
+        blocks.push_back(block);
+      }
+    }
+
+    future<size_t> nextRead = async(launch::async, &ExternalSafetyChecker::readBlock, this, blocks[0], buffers[0].data());
+    for (size_t index = 0; index < blocks.size(); index++)
+    {
+      size_t numRows = nextRead.get();
+      if (index + 1 < blocks.size())
+      {
+        nextRead = async(launch::async, &ExternalSafetyChecker::readBlock, this, blocks[index + 1],
+          buffers[(index + 1) % 2].data());
+      }
+
+      int64_t block = blocks[index];
+      const int* row = buffers[index % 2].data();
+      for (size_t blockRow = 0; blockRow < numRows; blockRow++, row += 2 * numResources)
+      {
+        int64_t process = block * blockRows + blockRow;
+        uint64_t bit = uint64_t(1) << (process % 64);
+        if ((completed[process / 64] & bit) or not vectorLessEqual(numResources, row, currentAvailable))
+        {
+          continue;
+        }
+        vectorAdd(numResources, row + numResources, currentAvailable);
+        completed[process / 64] |= bit;
+        remaining[block]--;
+        numCompleted++;
+        progress = true;
+      }
+    }
+  }
+
+  return numCompleted == numProcesses;
+}
+
+/**
+ * @brief write external state
+ *
+ * Write an in memory state as an external state file.
+ *
+ * @param state The state to write.
+ * @param filename The name of the external state file to create.
+ *
+ * @throws SimulatorException is thrown if the file can not be written.
+ */
+void writeExternalState(const State& state, string filename)
+{
+  int numResources = state.getNumResources();
+  vector<int> total(numResources);
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    total[resource] = state.getResourceTotal(resource);
+  }
+
+  ExternalStateWriter writer(filename, total);
+  int claim[MAX_RESOURCES];
+  int allocation[MAX_RESOURCES];
+  for (int process = 0; process < state.getNumProcesses(); process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      claim[resource] = state.getClaim(process, resource);
+      allocation[resource] = state.getAllocation(process, resource);
+    }
+    writer.appendProcess(claim, allocation);
+  }
+  writer.close();
+}
@@ -0,0 +1,671 @@
+/** @file ModelChecker.cpp
+ * @brief Explicit state model checker implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the lock free visited set and the parallel
+ * breadth first model checker of request/release protocols.
+ */
+#include "ModelChecker.hpp"
+#include "SimulatorException.hpp"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+/**
+ * @brief mix state
+ *
+ * Scramble the bits of a packed state, so that states differing only
+ * in a few program counters spread out over the visited set.  This
+ * is the splitmix64 finalizer.
+ *
+ * @param key The packed state to hash.
+ *
+ * @returns uint64_t The hash of the state.
+ */
+static uint64_t mixState(uint64_t key)
+{
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ULL;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebULL;
+  key ^= key >> 31;
+  return key;
+}
+
+/**
+ * @brief VisitedSet constructor
+ *
+ * Allocate an empty visited set.  The number of slots is rounded up
+ * to a power of two, and a set can hold up to 7/8 of its slots.
+ *
+ * @param capacity The minimum number of slots of the set.
+ */
+VisitedSet::VisitedSet(size_t capacity)
+{
+  this->capacity = 2;
+  while (this->capacity < capacity)
+  {
+    this->capacity *= 2;
+  }
+  keys.reset(new atomic<uint64_t>[this->capacity]);
+  parents.reset(new uint64_t[this->capacity]);
+  for (size_t slot = 0; slot < this->capacity; slot++)
+  {
+    keys[slot].store(0, memory_order_relaxed);
+  }
+  numKeys.store(0);
+}
+
+/**
+ * @brief find slot
+ *
+ * Find the slot holding a state.
+ *
+ * @param key The packed state to look for.
+ *
+ * @returns size_t The slot holding the state, or capacity if the
+ *   state is not in the set.
+ */
+size_t VisitedSet::findSlot(uint64_t key) const
+{
+  uint64_t stored = key + 1;
+  size_t mask = capacity - 1;
+  size_t slot = mixState(key) & mask;
+  for (size_t probe = 0; probe < capacity; probe++)
+  {
+    uint64_t current = keys[slot].load(memory_order_acquire);
+    if (current == stored)
+    {
+      return slot;
+    }
+    if (current == 0)
+    {
+      return capacity;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return capacity;
+}
+
+/**
+ * @brief insert state
+ *
+ * Add a state to the set if no thread has added it yet.  Safe to
+ * call from any number of threads at once.
+ *
+ * @param key The packed state to add.
+ * @param parent The state it was first reached from.
+ *
+ * @returns bool true if this call added the state, false if it was
+ *   already in the set.
+ *
+ * @throws SimulatorException is thrown if the set is full.
+ */
+bool VisitedSet::insert(uint64_t key, uint64_t parent)
+{
+  uint64_t stored = key + 1;
+  size_t mask = capacity - 1;
+  size_t slot = mixState(key) & mask;
+  for (size_t probe = 0; probe < capacity; probe++)
+  {
+    uint64_t current = keys[slot].load(memory_order_acquire);
+    if (current == stored)
+    {
+      return false;
+    }
+    if (current == 0)
+    {
+      if (keys[slot].compare_exchange_strong(current, stored, memory_order_acq_rel))
+      {
+        parents[slot] = parent;
+        if (numKeys.fetch_add(1, memory_order_relaxed) + 1 > capacity - capacity / 8)
+        {
+          stringstream msg;
+          msg << "<VisitedSet::insert> visited set of " << capacity << " slots is full" << endl;
+          throw SimulatorException(msg.str());
+        }
+        return true;
+      }
+      // another thread claimed the slot first, maybe with our state
+      if (current == stored)
+      {
+        return false;
+      }
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  stringstream msg;
+  msg << "<VisitedSet::insert> visited set of " << capacity << " slots is full" << endl;
+  throw SimulatorException(msg.str());
+}
+
+/**
+ * @brief contains state
+ *
+ * @param key The packed state to look for.
+ *
+ * @returns bool true if the state is in the set.
+ */
+bool VisitedSet::contains(uint64_t key) const
+{
+  return findSlot(key) != capacity;
+}
+
+/**
+ * @brief get parent
+ *
+ * Only valid once the threads inserting states have been joined.
+ *
+ * @param key The packed state to look up.
+ *
+ * @returns uint64_t The state the given state was first reached from.
+ *
+ * @throws SimulatorException is thrown if the state is not in the set.
+ */
+uint64_t VisitedSet::getParent(uint64_t key) const
+{
+  size_t slot = findSlot(key);
+  if (slot == capacity)
+  {
+    stringstream msg;
+    msg << "<VisitedSet::getParent> state " << key << " was never visited" << endl;
+    throw SimulatorException(msg.str());
+  }
+  return parents[slot];
+}
+
+/**
+ * @brief size
+ *
+ * @returns size_t The number of states in the set.
+ */
+size_t VisitedSet::size() const
+{
+  return numKeys.load();
+}
+
+/**
+ * @brief ModelChecker constructor
+ *
+ * Set up the checker of a protocol.  We work out the claim of each
+ * process and what it holds at every point of its script up front,
+ * so that expanding a state never has to replay a script.
+ *
+ * @param script The protocol to check.
+ * @param avoidDeadlock If true requests are admitted by the Banker's
+ *   algorithm, otherwise whenever the resources are available.
+ * @param numThreads The number of threads expanding each frontier.
+ * @param visitedCapacity The number of slots of the visited set,
+ *   which bounds the number of states that can be explored.
+ *
+ * @throws SimulatorException is thrown if the protocol does not fit
+ *   a State, its program counters do not fit in 64 bits, a process
+ *   releases more than it holds or holds more than exists.
+ */
+ModelChecker::ModelChecker(const ProcessScript& script, bool avoidDeadlock, int numThreads, size_t visitedCapacity)
+  : script(script)
+{
+  this->avoidDeadlock = avoidDeadlock;
+  this->numThreads = max(numThreads, 1);
+  this->visitedCapacity = visitedCapacity;
+
+  int numProcesses = script.steps.size();
+  int numResources = script.total.size();
+  if ((numProcesses < 1) or (numProcesses > MAX_PROCESSES) or (numResources < 1) or (numResources > MAX_RESOURCES))
+  {
+    stringstream msg;
+    msg << "<ModelChecker::ModelChecker> invalid shape numProcesses = " << numProcesses
+        << " numResources = " << numResources << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  // each program counter runs from 0 to the length of its script
+  size_t longestScript = 0;
+  for (const vector<ScriptStep>& steps : script.steps)
+  {
+    longestScript = max(longestScript, steps.size());
+  }
+  counterBits = 1;
+  while ((size_t(1) << counterBits) <= longestScript)
+  {
+    counterBits++;
+  }
+  // keep the top bit clear, as the visited set stores states plus one
+  if (numProcesses * counterBits > 63)
+  {
+    stringstream msg;
+    msg << "<ModelChecker::ModelChecker> " << numProcesses << " scripts of up to " << longestScript
+        << " steps do not pack into 63 bits" << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  claims.assign(numProcesses * numResources, 0);
+  holdingStart.resize(numProcesses);
+  holdings.clear();
+  for (int process = 0; process < numProcesses; process++)
+  {
+    const vector<ScriptStep>& steps = script.steps[process];
+    holdingStart[process] = holdings.size() / numResources;
+    vector<int> held(numResources, 0);
+    for (size_t counter = 0; counter <= steps.size(); counter++)
+    {
+      // a finished process has released everything
+      if (counter == steps.size())
+      {
+        held.assign(numResources, 0);
+      }
+      holdings.insert(holdings.end(), held.begin(), held.end());
+      if (counter == steps.size())
+      {
+        break;
+      }
+
+      const ScriptStep& step = steps[counter];
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        held[resource] += (step.type == REQUEST_STEP) ? step.resources[resource] : -step.resources[resource];
+        if ((held[resource] < 0) or (held[resource] > script.total[resource]))
+        {
+          stringstream msg;
+          msg << "<ModelChecker::ModelChecker> P" << process << " step " << counter << " would hold " << held[resource]
+              << " R" << resource << " of " << script.total[resource] << endl;
+          throw SimulatorException(msg.str());
+        }
+        int& claim = claims[process * numResources + resource];
+        claim = max(claim, held[resource]);
+      }
+    }
+  }
+}
+
+/**
+ * @brief get counter
+ *
+ * @param packed A packed state.
+ * @param process The process to unpack.
+ *
+ * @returns int The program counter of the process in the state.
+ */
+int ModelChecker::getCounter(uint64_t packed, int process) const
+{
+  uint64_t mask = (uint64_t(1) << counterBits) - 1;
+  return (packed >> (process * counterBits)) & mask;
+}
+
+/**
+ * @brief set counter
+ *
+ * @param packed A packed state.
+ * @param process The process to change.
+ * @param counter The new program counter of the process.
+ *
+ * @returns uint64_t The packed state with the process counter changed.
+ */
+uint64_t ModelChecker::setCounter(uint64_t packed, int process, int counter) const
+{
+  int shift = process * counterBits;
+  uint64_t mask = ((uint64_t(1) << counterBits) - 1) << shift;
+  return (packed & ~mask) | (uint64_t(counter) << shift);
+}
+
+/**
+ * @brief get holding
+ *
+ * @param process The process to look up.
+ * @param counter A program counter of the process.
+ *
+ * @returns const int* What the process holds of each resource at
+ *   that point of its script.
+ */
+const int* ModelChecker::getHolding(int process, int counter) const
+{
+  return &holdings[(holdingStart[process] + counter) * script.total.size()];
+}
+
+/**
+ * @brief expand state
+ *
+ * Find every state reachable from a state by one process taking its
+ * next step.  Releases can always be taken.  A request can be taken
+ * if the resources are available, and if we are avoiding deadlock
+ * the State after granting it is safe.
+ *
+ * @param packed The state to expand.
+ * @param state Scratch State to rebuild the state in, only used when
+ *   avoiding deadlock.
+ * @param allocations Scratch space for the allocation matrix.
+ * @param successors Returns the successor states.
+ *
+ * @returns bool true if the state is a deadlock, no process can take
+ *   a step but not all of them have finished.
+ */
+bool ModelChecker::expand(uint64_t packed, State& state, vector<int>& allocations, vector<uint64_t>& successors) const
+{
+  int numProcesses = script.steps.size();
+  int numResources = script.total.size();
+  int available[MAX_RESOURCES];
+  copy(script.total.begin(), script.total.end(), available);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    const int* held = getHolding(process, getCounter(packed, process));
+    copy(held, held + numResources, allocations.begin() + process * numResources);
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      available[resource] -= held[resource];
+    }
+  }
+  if (avoidDeadlock)
+  {
+    state.loadState(numProcesses, numResources, script.total, claims, allocations);
+  }
+
+  bool finished = true;
+  for (int process = 0; process < numProcesses; process++)
+  {
+    int counter = getCounter(packed, process);
+    if (counter == static_cast<int>(script.steps[process].size()))
+    {
+      continue;
+    }
+    finished = false;
+
+    const ScriptStep& step = script.steps[process][counter];
+    bool enabled = true;
+    if (step.type == REQUEST_STEP)
+    {
+      const int* request = step.resources.data();
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        enabled = enabled and (request[resource] <= available[resource]);
+      }
+      if (enabled and avoidDeadlock)
+      {
+        enabled = state.requestResources(process, request);
+        if (enabled)
+        {
+          state.releaseResources(process, request);
+        }
+      }
+    }
+    if (enabled)
+    {
+      successors.push_back(setCounter(packed, process, counter + 1));
+    }
+  }
+
+  return (not finished) and successors.empty();
+}
+
+/**
+ * @brief check protocol
+ *
+ * Explore every reachable state of the protocol breadth first, one
+ * level at a time.  The states of a level are handed out to the
+ * threads in chunks, each thread collects the new states it inserted
+ * into the visited set, and those make up the next level.  Since the
+ * search is breadth first, the first deadlock found is reached by a
+ * shortest trace.  Of the deadlocks found on that level we report the
+ * smallest packed state, so the deadlock reported does not depend on
+ * the number of threads, although which of several shortest traces
+ * reaches it can.
+ *
+ * @returns ModelCheckResult The number of states and transitions
+ *   explored, and the deadlock trace if one was found.
+ *
+ * @throws SimulatorException is thrown if the visited set fills up.
+ * @throws system_error is thrown if a search thread can not be
+ *   started, once the threads already started have been joined.
+ */
+ModelCheckResult ModelChecker::check()
+{
+  int numProcesses = script.steps.size();
+  int numResources = script.total.size();
+  const uint64_t NO_DEADLOCK = ~uint64_t(0);
+
+  VisitedSet visited(visitedCapacity);
+  const uint64_t initial = 0;
+  visited.insert(initial, initial);
+
+  ModelCheckResult result;
+  result.numTransitions = 0;
+  result.depth = 0;
+  result.deadlockFound = false;
+
+  vector<uint64_t> frontier(1, initial);
+  uint64_t deadlock = NO_DEADLOCK;
+  while (not frontier.empty() and (deadlock == NO_DEADLOCK))
+  {
+    result.depth++;
+    atomic<size_t> nextChunk(0);
+    atomic<long> numTransitions(0);
+    vector<vector<uint64_t>> nextFrontiers(numThreads);
+    mutex deadlockMutex;
+    exception_ptr failure;
+
+    auto expandFrontier = [&](int threadIndex) {
+      try
+      {
+        State state;
+        vector<int> allocations(numProcesses * numResources);
+        vector<uint64_t> successors;
+        size_t begin;
+        while ((begin = nextChunk.fetch_add(FRONTIER_CHUNK_SIZE)) < frontier.size())
+        {
+          size_t end = min(begin + FRONTIER_CHUNK_SIZE, frontier.size());
+          for (size_t index = begin; index < end; index++)
+          {
+            uint64_t packed = frontier[index];
+            successors.clear();
+            if (expand(packed, state, allocations, successors))
+            {
+              lock_guard<mutex> lock(deadlockMutex);
+              deadlock = min(deadlock, packed);
+            }
+            numTransitions.fetch_add(successors.size(), memory_order_relaxed);
+            for (uint64_t successor : successors)
+            {
+              if (visited.insert(successor, packed))
+              {
+                nextFrontiers[threadIndex].push_back(successor);
+              }
+            }
+          }
+        }
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(deadlockMutex);
+        failure = current_exception();
+      }
+    };
+
+    // should a thread fail to start, join the threads already started
+    // before passing the failure on
+    vector<thread> workers;
+    workers.reserve(numThreads - 1);
+    try
+    {
+      for (int worker = 1; worker < numThreads; worker++)
+      {
+        workers.push_back(thread(expandFrontier, worker));
+      }
+    }
+    catch (...)
+    {
+      for (thread& worker : workers)
+      {
+        worker.join();
+      }
+      throw;
+    }
+    expandFrontier(0);
+    for (thread& worker : workers)
+    {
+      worker.join();
+    }
+    if (failure)
+    {
+      rethrow_exception(failure);
+    }
+
+    result.numTransitions += numTransitions.load();
+    frontier.clear();
+    for (const vector<uint64_t>& nextFrontier : nextFrontiers)
+    {
+      frontier.insert(frontier.end(), nextFrontier.begin(), nextFrontier.end());
+    }
+  }
+  result.numStates = visited.size();
+
+  if (deadlock != NO_DEADLOCK)
+  {
+    result.deadlockFound = true;
+    for (int process = 0; process < numProcesses; process++)
+    {
+      result.deadlockCounters.push_back(getCounter(deadlock, process));
+    }
+
+    // walk the parents back to the initial state, each step moved
+    // exactly one program counter
+    for (uint64_t packed = deadlock; packed != initial;)
+    {
+      uint64_t parent = visited.getParent(packed);
+      int process = 0;
+      while (getCounter(parent, process) == getCounter(packed, process))
+      {
+        process++;
+      }
+      result.trace.push_back(process);
+      packed = parent;
+    }
+    reverse(result.trace.begin(), result.trace.end());
+  }
+
+  return result;
+}
+
+/**
+ * @brief load process script
+ *
+ * Load a protocol from a script file.  Like a simulation file,
+ * comment lines starting with '#' may come before each section.  The
+ * file gives the number of processes and resources, and the total
+ * resource vector.  Then for each process comes its number of steps,
+ * followed by one line per step: '+' for a request or '-' for a
+ * release, then the number of each resource requested or released.
+ *
+ * @param filename The name of the script file to load.
+ *
+ * @returns ProcessScript The loaded protocol.
+ *
+ * @throws SimulatorException is thrown if the file can not be opened
+ *   or is malformed.
+ */
+ProcessScript loadProcessScript(string filename)
+{
+  ifstream scriptfile(filename);
+  if (not scriptfile.is_open())
+  {
+    stringstream msg;
+    msg << "<loadProcessScript> File not found, could not open script file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int numProcesses = 0;
+  int numResources = 0;
+  skipComments(scriptfile);
+  scriptfile >> numProcesses >> numResources;
+  if ((numProcesses < 1) or (numProcesses > MAX_PROCESSES) or (numResources < 1) or (numResources > MAX_RESOURCES))
+  {
+    stringstream msg;
+    msg << "<loadProcessScript> invalid script shape numProcesses = " << numProcesses
+        << " numResources = " << numResources << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  ProcessScript script;
+  script.total.resize(numResources);
+  skipComments(scriptfile);
+  for (int& total : script.total)
+  {
+    scriptfile >> total;
+  }
+
+  script.steps.resize(numProcesses);
+  for (vector<ScriptStep>& steps : script.steps)
+  {
+    int numSteps = 0;
+    skipComments(scriptfile);
+    scriptfile >> numSteps;
+    steps.resize(max(numSteps, 0));
+    for (ScriptStep& step : steps)
+    {
+      char type = '\0';
+      scriptfile >> type;
+      if ((type != '+') and (type != '-'))
+      {
+        stringstream msg;
+        msg << "<loadProcessScript> expected '+' or '-' to start a step, found '" << type << "'" << endl;
+        throw SimulatorException(msg.str());
+      }
+      step.type = (type == '+') ? REQUEST_STEP : RELEASE_STEP;
+      step.resources.resize(numResources);
+      for (int& resource : step.resources)
+      {
+        scriptfile >> resource;
+      }
+    }
+  }
+
+  if (scriptfile.fail())
+  {
+    stringstream msg;
+    msg << "<loadProcessScript> script file " << filename << " is truncated or malformed" << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  return script;
+}
+
+/**
+ * @brief model check result to string
+ *
+ * Display the size of the explored state space, and the deadlock
+ * trace if one was found.
+ *
+ * @param result The result to display.
+ *
+ * @returns string The result as a string.
+ */
+string modelCheckResultToString(const ModelCheckResult& result)
+{
+  stringstream out;
+  out << "explored " << result.numStates << " states, " << result.numTransitions << " transitions, depth "
+      << result.depth << endl;
+  if (not result.deadlockFound)
+  {
+    out << "no reachable deadlock" << endl;
+    return out.str();
+  }
+
+  out << "deadlock reached by trace:";
+  for (int process : result.trace)
+  {
+    out << " P" << process;
+  }
+  out << endl << "program counters at deadlock:";
+  for (int counter : result.deadlockCounters)
+  {
+    out << " " << counter;
+  }
+  out << endl;
+  return out.str();
+}
@@ -0,0 +1,205 @@
+/** @file NeedSummaryTree.cpp
+ * @brief Minimum need summary tree implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the minimum need summary tree member functions.
+ */
+#include "NeedSummaryTree.hpp"
+#include "VectorOps.hpp"
+#include <algorithm>
+
+/**
+ * @brief summary tree constructor
+ *
+ * Create an empty tree, it must be reset() with a state before it
+ * can be searched.
+ */
+NeedSummaryTree::NeedSummaryTree()
+{
+  state = nullptr;
+  for (int node = 0; node < 2 * NEED_TREE_LEAVES; node++)
+  {
+    dirty[node] = false;
+  }
+  for (int process = 0; process < MAX_PROCESSES; process++)
+  {
+    completed[process] = false;
+  }
+}
+
+/**
+ * @brief reset tree
+ *
+ * Prepare the tree for a new safety check of the given state, with
+ * no processes completed.  Every node is marked dirty, so the
+ * summaries are computed as the first search reaches them.
+ *
+ * @param state The state to be checked, it must not change while
+ *   the tree is in use.
+ */
+void NeedSummaryTree::reset(const State& state)
+{
+  this->state = &state;
+  for (int node = 1; node < 2 * NEED_TREE_LEAVES; node++)
+  {
+    dirty[node] = true;
+  }
+  for (int process = 0; process < state.getNumProcesses(); process++)
+  {
+    completed[process] = false;
+  }
+}
+
+/**
+ * @brief refresh node
+ *
+ * Bring the minimum need of a node up to date, if any process below
+ * it has completed since it was computed.  A leaf takes the minimum
+ * over its block of processes that have not completed, an inner
+ * node the minimum of its two children.
+ *
+ * @param node The node to refresh.
+ */
+void NeedSummaryTree::refresh(int node)
+{
+  if (not dirty[node])
+  {
+    return;
+  }
+
+  int numResources = state->getNumResources();
+  int* need = minimumNeed[node];
+  fill(need, need + numResources, EMPTY_NEED);
+
+  if (node >= NEED_TREE_LEAVES)
+  {
+    int begin = (node - NEED_TREE_LEAVES) * NEED_BLOCK_SIZE;
+    int end = min(begin + NEED_BLOCK_SIZE, state->getNumProcesses());
+    for (int process = begin; process < end; process++)
+    {
+      if (completed[process])
+      {
+        continue;
+      }
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        need[resource] = min(need[resource], state->getNeed(process, resource));
+      }
+    }
+  }
+  else
+  {
+    refresh(2 * node);
+    refresh(2 * node + 1);
+    vectorMin(numResources, minimumNeed[2 * node], minimumNeed[2 * node + 1], need);
+  }
+
+  dirty[node] = false;
+}
+
+/**
+ * @brief node fits
+ *
+ * Test if the minimum need of a node fits in the available
+ * resources.  If it does not, no process below the node can run.
+ *
+ * @param node The (refreshed) node to test.
+ * @param currentAvailable The resources currently available.
+ *
+ * @returns bool true if some process below the node might run.
+ */
+bool NeedSummaryTree::fits(int node, const int currentAvailable[]) const
+{
+  return vectorLessEqual(state->getNumResources(), minimumNeed[node], currentAvailable);
+}
+
+/**
+ * @brief search subtree
+ *
+ * Find the lowest numbered runnable process below a node, skipping
+ * every subtree whose minimum need does not fit.
+ *
+ * @param node The root of the subtree to search.
+ * @param currentAvailable The resources currently available.
+ *
+ * @returns int The lowest numbered process below the node that has
+ *   not completed and whose needs can be met, or NO_CANDIDATE.
+ */
+int NeedSummaryTree::search(int node, const int currentAvailable[])
+{
+  refresh(node);
+  if (not fits(node, currentAvailable))
+  {
+    return NO_CANDIDATE;
+  }
+
+  if (node >= NEED_TREE_LEAVES)
+  {
+    int begin = (node - NEED_TREE_LEAVES) * NEED_BLOCK_SIZE;
+    int end = min(begin + NEED_BLOCK_SIZE, state->getNumProcesses());
+    for (int process = begin; process < end; process++)
+    {
+      if (not completed[process] and state->needsAreMet(process, currentAvailable))
+      {
+        return process;
+      }
+    }
+    return NO_CANDIDATE;
+  }
+
+  int candidateProcess = search(2 * node, currentAvailable);
+  if (candidateProcess == NO_CANDIDATE)
+  {
+    candidateProcess = search(2 * node + 1, currentAvailable);
+  }
+  return candidateProcess;
+}
+
+/**
+ * @brief find candidate process
+ *
+ * Find the next process that can run, the same process
+ * State::findCandidateProcess() would find, but skipping blocks of
+ * processes that can not run.
+ *
+ * @param currentAvailable The resources currently available.
+ *
+ * @returns int The lowest numbered process that has not completed
+ *   and whose needs can be met, or NO_CANDIDATE if there is none.
+ */
+int NeedSummaryTree::findCandidateProcess(const int currentAvailable[])
+{
+  return search(1, currentAvailable);
+}
+
+/**
+ * @brief is process completed
+ *
+ * @param process The process to test.
+ *
+ * @returns bool true if the process has completed in this check.
+ */
+bool NeedSummaryTree::isCompleted(int process) const
+{
+  return completed[process];
+}
+
+/**
+ * @brief mark process completed
+ *
+ * Mark a process completed, and the summaries above it dirty.
+ *
+ * @param process The process that has completed in this check.
+ */
+void NeedSummaryTree::markCompleted(int process)
+{
+  completed[process] = true;
+  for (int node = NEED_TREE_LEAVES + process / NEED_BLOCK_SIZE; node >= 1; node /= 2)
+  {
+    dirty[node] = true;
+  }
+}
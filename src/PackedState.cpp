@@ -0,0 +1,456 @@
+/** @file PackedState.cpp
+ * @brief Frame-of-reference bit packed state implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the PackedState member functions.
+ */
+#include "PackedState.hpp"
+#include "SimulatorException.hpp"
+#include "VectorOps.hpp"
+#include <algorithm>
+#include <sstream>
+
+/**
+ * @brief bits needed
+ *
+ * @param value The value to store.
+ *
+ * @returns int The number of bits needed to store the value, 0 for 0.
+ */
+static int bitsNeeded(uint32_t value)
+{
+  int width = 0;
+  while (value != 0)
+  {
+    width++;
+    value >>= 1;
+  }
+  return width;
+}
+
+/**
+ * @brief packed state constructor
+ *
+ * Create an empty packed state, the normal use is to then load it.
+ */
+PackedState::PackedState()
+{
+  numProcesses = numResources = 0;
+}
+
+/**
+ * @brief packed state constructor
+ *
+ * Create a packed copy of a loaded State.
+ *
+ * @param state The state to copy.
+ */
+PackedState::PackedState(const State& state)
+{
+  loadState(state);
+}
+
+/**
+ * @brief number of resource types accessor
+ *
+ * @returns int The number of resource types present in the system.
+ */
+int PackedState::getNumResources() const
+{
+  return numResources;
+}
+
+/**
+ * @brief number of processes accessor
+ *
+ * @returns int The number of processes present in the system.
+ */
+int PackedState::getNumProcesses() const
+{
+  return numProcesses;
+}
+
+/**
+ * @brief need accessor
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The need of the process for the resource, decoded
+ *   from its packed column.
+ */
+int PackedState::getNeed(int process, int resource) const
+{
+  const PackedColumn& column = needColumns[(process / PACKED_BLOCK_ROWS) * numResources + resource];
+  return column.base + static_cast<int>(unpackOffset(column, process % PACKED_BLOCK_ROWS));
+}
+
+/**
+ * @brief allocation accessor
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The allocation of the resource to the process, decoded
+ *   from its packed column.
+ */
+int PackedState::getAllocation(int process, int resource) const
+{
+  const PackedColumn& column = allocationColumns[(process / PACKED_BLOCK_ROWS) * numResources + resource];
+  return column.base + static_cast<int>(unpackOffset(column, process % PACKED_BLOCK_ROWS));
+}
+
+/**
+ * @brief total resource accessor
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The total number of the resource in the system.
+ */
+int PackedState::getResourceTotal(int resource) const
+{
+  return resourceTotal[resource];
+}
+
+/**
+ * @brief available resource accessor
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The number of the resource currently available.
+ */
+int PackedState::getResourceAvailable(int resource) const
+{
+  return resourceAvailable[resource];
+}
+
+/**
+ * @brief packed size accessor
+ *
+ * @returns size_t The number of bytes taken by the packed need and
+ *   allocation matrices, their column headers included.
+ */
+size_t PackedState::getPackedBytes() const
+{
+  return words.size() * sizeof(uint64_t) + (needColumns.size() + allocationColumns.size()) * sizeof(PackedColumn);
+}
+
+/**
+ * @brief load from state
+ *
+ * Pack the needs and allocations of a loaded State.
+ *
+ * @param state The state to copy.
+ */
+void PackedState::loadState(const State& state)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  vector<int> total(numResources);
+  vector<int> claims(numProcesses * numResources);
+  vector<int> allocations(numProcesses * numResources);
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    total[resource] = state.getResourceTotal(resource);
+  }
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      claims[process * numResources + resource] = state.getClaim(process, resource);
+      allocations[process * numResources + resource] = state.getAllocation(process, resource);
+    }
+  }
+  loadState(numProcesses, numResources, total, claims, allocations);
+}
+
+/**
+ * @brief load from vectors
+ *
+ * Load a state given its total resources and its claim and
+ * allocation matrices in row major order, as the State::loadState()
+ * of the same signature does, but with any number of processes.  The
+ * needs and available resources are inferred, then the needs and
+ * allocations are packed.
+ *
+ * @param numProcesses The number of processes (rows).
+ * @param numResources The number of resources (columns).
+ * @param total The total of each resource.
+ * @param claims The numProcesses * numResources claim matrix.
+ * @param allocations The numProcesses * numResources allocation matrix.
+ *
+ * @throws SimulatorException is thrown if the shape is invalid.
+ */
+void PackedState::loadState(int numProcesses, int numResources, const vector<int>& total, const vector<int>& claims,
+  const vector<int>& allocations)
+{
+  size_t numCells = static_cast<size_t>(numProcesses) * numResources;
+  if ((numProcesses < 0) or (numResources < 0) or (numResources > MAX_RESOURCES) or
+      (total.size() != static_cast<size_t>(numResources)) or (claims.size() != numCells) or (allocations.size() != numCells))
+  {
+    stringstream msg;
+    msg << "<PackedState::loadState> invalid shape, requested"
+        << " numProcesses = " << numProcesses << " numResources = " << numResources << endl
+        << " maximum resources = " << MAX_RESOURCES << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  this->numProcesses = numProcesses;
+  this->numResources = numResources;
+  vector<int> needs(numCells);
+  vectorCopy(numResources, total.data(), resourceTotal);
+  vectorCopy(numResources, total.data(), resourceAvailable);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    const int* allocation = &allocations[process * numResources];
+    vectorSubtract(numResources, &claims[process * numResources], allocation, &needs[process * numResources]);
+    vectorSubtract(numResources, resourceAvailable, allocation, resourceAvailable);
+  }
+
+  words.clear();
+  packColumns(needs, needColumns);
+  packColumns(allocations, allocationColumns);
+}
+
+/**
+ * @brief pack columns
+ *
+ * Frame-of-reference encode every column of every block of a matrix,
+ * appending the packed offsets to the words.  The offsets of a
+ * column are packed back to back, so an offset may straddle two
+ * words.
+ *
+ * @param values The numProcesses * numResources matrix to pack, in
+ *   row major order.
+ * @param columns Returns the numResources columns of each block.
+ */
+void PackedState::packColumns(const vector<int>& values, vector<PackedColumn>& columns)
+{
+  int numBlocks = (numProcesses + PACKED_BLOCK_ROWS - 1) / PACKED_BLOCK_ROWS;
+  columns.resize(static_cast<size_t>(numBlocks) * numResources);
+  for (int block = 0; block < numBlocks; block++)
+  {
+    int firstProcess = block * PACKED_BLOCK_ROWS;
+    int numRows = min(PACKED_BLOCK_ROWS, numProcesses - firstProcess);
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      const int* value = &values[static_cast<size_t>(firstProcess) * numResources + resource];
+      int base = value[0];
+      int largest = value[0];
+      for (int row = 1; row < numRows; row++)
+      {
+        base = min(base, value[row * numResources]);
+        largest = max(largest, value[row * numResources]);
+      }
+
+      PackedColumn& column = columns[block * numResources + resource];
+      column.base = base;
+      column.maxOffset = static_cast<uint32_t>(static_cast<int64_t>(largest) - base);
+      column.width = bitsNeeded(column.maxOffset);
+      column.offset = words.size();
+      words.resize(words.size() + (numRows * column.width + 63) / 64, 0);
+      for (int row = 0; (column.width > 0) and (row < numRows); row++)
+      {
+        uint64_t packedOffset = static_cast<uint32_t>(static_cast<int64_t>(value[row * numResources]) - base);
+        size_t bit = static_cast<size_t>(row) * column.width;
+        words[column.offset + bit / 64] |= packedOffset << (bit % 64);
+        if ((bit % 64) + column.width > 64)
+        {
+          words[column.offset + bit / 64 + 1] |= packedOffset >> (64 - bit % 64);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief unpack offset
+ *
+ * @param column The packed column.
+ * @param row The row within the block of the column.
+ *
+ * @returns uint32_t The offset from the base of the column at row.
+ */
+uint32_t PackedState::unpackOffset(const PackedColumn& column, int row) const
+{
+  if (column.width == 0)
+  {
+    return 0;
+  }
+  size_t bit = static_cast<size_t>(row) * column.width;
+  const uint64_t* word = &words[column.offset + bit / 64];
+  uint64_t packedOffset = word[0] >> (bit % 64);
+  if ((bit % 64) + column.width > 64)
+  {
+    packedOffset |= word[1] << (64 - bit % 64);
+  }
+  return static_cast<uint32_t>(packedOffset & ((uint64_t(1) << column.width) - 1));
+}
+
+/**
+ * @brief Check if any process of a block may have its needs met
+ *
+ * The base of each need column is the smallest need in the block, so
+ * when any base is more than is available no process of the block
+ * can run.
+ *
+ * @param block The block to check.
+ * @param currentAvailable The currently available resources.
+ *
+ * @returns bool false if no process of the block can have its needs
+ *   met, true if some may.
+ */
+bool PackedState::blockMayFit(int block, const int currentAvailable[]) const
+{
+  const PackedColumn* column = needColumns.data() + block * numResources;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    if (column[resource].base > currentAvailable[resource])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Check if a process's resource needs can be met
+ *
+ * Compares in the packed domain, the packed offset of each need with
+ * the slack of the available resource over the base of its column.
+ * Columns whose largest offset fits in the slack are not unpacked.
+ *
+ * @param process The process to check.
+ * @param currentAvailable The currently available resources.
+ *
+ * @returns true if the process's resource needs can be met.
+ */
+bool PackedState::needsAreMet(int process, const int currentAvailable[]) const
+{
+  const PackedColumn* column = needColumns.data() + (process / PACKED_BLOCK_ROWS) * numResources;
+  int row = process % PACKED_BLOCK_ROWS;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    int64_t slack = static_cast<int64_t>(currentAvailable[resource]) - column[resource].base;
+    if (slack < 0)
+    {
+      return false;
+    }
+    if ((slack < column[resource].maxOffset) and (unpackOffset(column[resource], row) > slack))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Find a candidate process
+ *
+ * Search for the lowest numbered process that has not completed and
+ * whose needs can be met, as State::findCandidateProcess() does.
+ * Blocks whose processes have all completed, or whose need bases
+ * rule out every process, are skipped as a whole.
+ *
+ * @param completed Which processes have completed.
+ * @param remaining The number of processes of each block that have
+ *   not completed.
+ * @param currentAvailable The currently available resources.
+ *
+ * @returns int The candidate process, or NO_CANDIDATE if none.
+ */
+int PackedState::findCandidateProcess(const vector<bool>& completed, const vector<int>& remaining,
+  const int currentAvailable[]) const
+{
+  int numBlocks = remaining.size();
+  for (int block = 0; block < numBlocks; block++)
+  {
+    if ((remaining[block] == 0) or not blockMayFit(block, currentAvailable))
+    {
+      continue;
+    }
+    int lastProcess = min(numProcesses, (block + 1) * PACKED_BLOCK_ROWS);
+    for (int process = block * PACKED_BLOCK_ROWS; process < lastProcess; process++)
+    {
+      if (not completed[process] and needsAreMet(process, currentAvailable))
+      {
+        return process;
+      }
+    }
+  }
+  return NO_CANDIDATE;
+}
+
+/**
+ * @brief Release the resources allocated to a process
+ *
+ * The allocation row of the process is decoded and then added with
+ * the vector operations.
+ *
+ * @param process The process completing.
+ * @param currentAvailable The available resources, updated by
+ *   adding the allocations of the process.
+ */
+void PackedState::releaseAllocatedResources(int process, int currentAvailable[]) const
+{
+  const PackedColumn* column = allocationColumns.data() + (process / PACKED_BLOCK_ROWS) * numResources;
+  int row = process % PACKED_BLOCK_ROWS;
+  int allocation[MAX_RESOURCES];
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    allocation[resource] = column[resource].base + static_cast<int>(unpackOffset(column[resource], row));
+  }
+  vectorAdd(numResources, allocation, currentAvailable);
+}
+
+/**
+ * @brief Check if the state is safe
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool PackedState::isSafe() const
+{
+  vector<int> safeSequence;
+  return isSafe(safeSequence);
+}
+
+/**
+ * @brief Check if the state is safe, with safe sequence
+ *
+ * The Banker's algorithm over the packed matrices, finding the same
+ * safe sequence as State::isSafe().
+ *
+ * @param safeSequence Returns the (partial) safe sequence found,
+ *   any previous contents are replaced.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool PackedState::isSafe(vector<int>& safeSequence) const
+{
+  int currentAvailable[MAX_RESOURCES];
+  vectorCopy(numResources, resourceAvailable, currentAvailable);
+  vector<bool> completed(numProcesses, false);
+  int numBlocks = (numProcesses + PACKED_BLOCK_ROWS - 1) / PACKED_BLOCK_ROWS;
+  vector<int> remaining(numBlocks);
+  for (int block = 0; block < numBlocks; block++)
+  {
+    remaining[block] = min(PACKED_BLOCK_ROWS, numProcesses - block * PACKED_BLOCK_ROWS);
+  }
+
+  safeSequence.clear();
+  int candidateProcess = findCandidateProcess(completed, remaining, currentAvailable);
+  while (candidateProcess != NO_CANDIDATE)
+  {
+    releaseAllocatedResources(candidateProcess, currentAvailable);
+    completed[candidateProcess] = true;
+    remaining[candidateProcess / PACKED_BLOCK_ROWS]--;
+    safeSequence.push_back(candidateProcess);
+    candidateProcess = findCandidateProcess(completed, remaining, currentAvailable);
+  }
+
+  return static_cast<int>(safeSequence.size()) == numProcesses;
+}
@@ -0,0 +1,661 @@
+/** @file ParallelSimulation.cpp
+ * @brief Parallel discrete event workload simulation implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the sequential simulation of a resource group,
+ * and of the time window synchronization of groups simulated by
+ * several threads.
+ */
+#include "ParallelSimulation.hpp"
+#include "SimulatorException.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+/**
+ * @brief event order
+ *
+ * Events are ordered by time, then kind, then job and stage, a total
+ * order, so a group handles its events in the same order no matter
+ * in which order they were scheduled.
+ *
+ * @param event The event to compare against.
+ *
+ * @returns bool true if this event comes after the given event.
+ */
+bool WorkloadEvent::operator>(const WorkloadEvent& event) const
+{
+  return tie(time, type, job, stage) > tie(event.time, event.type, event.job, event.stage);
+}
+
+/**
+ * @brief GroupSimulation constructor
+ *
+ * Start a group with no processes and no events.
+ *
+ * @param workload The workload being simulated.
+ * @param group The resource group to simulate.
+ * @param policy The admission policy of the group.
+ */
+GroupSimulation::GroupSimulation(const Workload& workload, int group, AdmissionPolicy policy)
+{
+  this->workload = &workload;
+  this->policy = policy;
+  const vector<int>& total = workload.groupTotal[group];
+  state.loadState(0, total.size(), total, vector<int>(), vector<int>());
+  clock = 0;
+  numEvents = numCompleted = lastFinish = totalWait = totalResponse = numDeniedRequests = allocatedTime = 0;
+}
+
+/**
+ * @brief schedule event
+ *
+ * @param event An event of a stage of this group.
+ */
+void GroupSimulation::schedule(const WorkloadEvent& event)
+{
+  events.push(event);
+}
+
+/**
+ * @brief next event time
+ *
+ * @returns long The time of the earliest pending event, or LONG_MAX
+ *   if there is none.
+ */
+long GroupSimulation::nextEventTime() const
+{
+  return events.empty() ? LONG_MAX : events.top().time;
+}
+
+/**
+ * @brief advance clock
+ *
+ * Move the clock of the group forward, adding up the resources held
+ * since the last event.
+ *
+ * @param time The time of the next event.
+ */
+void GroupSimulation::advanceClock(long time)
+{
+  long allocated = 0;
+  for (int resource = 0; resource < state.getNumResources(); resource++)
+  {
+    allocated += state.getResourceTotal(resource) - state.getResourceAvailable(resource);
+  }
+  allocatedTime += allocated * (time - clock);
+  clock = time;
+}
+
+/**
+ * @brief find process
+ *
+ * @param job A job with a stage running in this group.
+ *
+ * @returns int The process running the stage.
+ *
+ * @throws SimulatorException is thrown if no stage of the job is
+ *   running here.
+ */
+int GroupSimulation::findProcess(int job) const
+{
+  for (size_t process = 0; process < running.size(); process++)
+  {
+    if (running[process].job == job)
+    {
+      return process;
+    }
+  }
+
+  stringstream msg;
+  msg << "<GroupSimulation::findProcess> job " << job << " is not running" << endl;
+  throw SimulatorException(msg.str());
+}
+
+/**
+ * @brief request half
+ *
+ * A running stage asks for the first half of its claim (rounded up)
+ * or the rest of it.  If granted the midpoint or finish of the stage
+ * is scheduled, otherwise the stage is blocked and asks again when
+ * something changes.
+ *
+ * @param process The process of the stage.
+ * @param time The current time.
+ */
+void GroupSimulation::requestHalf(int process, long time)
+{
+  RunningStage& stage = running[process];
+  const WorkloadStage& workloadStage = workload->jobs[stage.job].stages[stage.stage];
+  int request[MAX_RESOURCES];
+  for (int resource = 0; resource < state.getNumResources(); resource++)
+  {
+    int claim = workloadStage.claim[resource];
+    request[resource] = stage.secondHalf ? claim / 2 : claim - claim / 2;
+  }
+
+  stage.blocked = not state.requestResources(process, request, policy);
+  if (stage.blocked)
+  {
+    numDeniedRequests++;
+  }
+  else if (stage.secondHalf)
+  {
+    schedule({time + workloadStage.duration - workloadStage.duration / 2, STAGE_FINISH, stage.job, stage.stage});
+  }
+  else
+  {
+    schedule({time + workloadStage.duration / 2, STAGE_MIDPOINT, stage.job, stage.stage});
+  }
+}
+
+/**
+ * @brief dispatch
+ *
+ * After an event, blocked stages ask for their resources again, and
+ * waiting stages are initiated in arrival order as the policy
+ * allows.
+ *
+ * @param time The current time.
+ */
+void GroupSimulation::dispatch(long time)
+{
+  for (size_t process = 0; process < running.size(); process++)
+  {
+    if (running[process].blocked)
+    {
+      requestHalf(process, time);
+    }
+  }
+
+  while (not waiting.empty() and (state.getNumProcesses() < MAX_PROCESSES))
+  {
+    const WorkloadEvent& arrival = waiting.front();
+    const WorkloadStage& workloadStage = workload->jobs[arrival.job].stages[arrival.stage];
+    int process = state.initiateProcess(workloadStage.claim.data(), policy);
+    if (process == NO_CANDIDATE)
+    {
+      break;
+    }
+    running.push_back({arrival.job, arrival.stage, false, false});
+    totalWait += time - arrival.time;
+    waiting.pop_front();
+    requestHalf(process, time);
+  }
+}
+
+/**
+ * @brief run window
+ *
+ * Handle the pending events of the group earlier than the end of a
+ * window.  Stages moving on to their next stage are appended to the
+ * outbox, the caller schedules them in the group they run in.
+ *
+ * @param windowEnd The end of the window, events at or after it are
+ *   left pending.
+ * @param outbox Returns the arrivals of next stages.
+ */
+void GroupSimulation::run(long windowEnd, vector<WorkloadEvent>& outbox)
+{
+  while (not events.empty() and (events.top().time < windowEnd))
+  {
+    WorkloadEvent event = events.top();
+    events.pop();
+    numEvents++;
+    advanceClock(event.time);
+
+    const WorkloadJob& job = workload->jobs[event.job];
+    int process = NO_CANDIDATE;
+    switch (event.type)
+    {
+    case STAGE_ARRIVAL:
+      waiting.push_back(event);
+      break;
+    case STAGE_MIDPOINT:
+      process = findProcess(event.job);
+      running[process].secondHalf = true;
+      requestHalf(process, event.time);
+      break;
+    case STAGE_FINISH:
+      // terminating moves the last process into the freed row
+      process = findProcess(event.job);
+      state.terminateProcess(process);
+      running[process] = running.back();
+      running.pop_back();
+      lastFinish = event.time;
+      if (event.stage + 1 < static_cast<int>(job.stages.size()))
+      {
+        outbox.push_back({event.time + workload->transferDelay, STAGE_ARRIVAL, event.job, event.stage + 1});
+      }
+      else
+      {
+        numCompleted++;
+        totalResponse += event.time - job.arrival;
+      }
+      break;
+    }
+    dispatch(event.time);
+  }
+}
+
+/**
+ * @brief WindowBarrier constructor
+ *
+ * @param numThreads The number of threads that must wait at the
+ *   barrier before it opens.
+ */
+WindowBarrier::WindowBarrier(int numThreads)
+{
+  this->numThreads = numThreads;
+  numWaiting = 0;
+  generation = 0;
+}
+
+/**
+ * @brief wait
+ *
+ * Block until all threads have reached the barrier.
+ */
+void WindowBarrier::wait()
+{
+  unique_lock<mutex> lock(barrierMutex);
+  long arrivedGeneration = generation;
+  if (++numWaiting == numThreads)
+  {
+    numWaiting = 0;
+    generation++;
+    opened.notify_all();
+  }
+  else
+  {
+    opened.wait(lock, [this, arrivedGeneration]() { return generation != arrivedGeneration; });
+  }
+}
+
+/**
+ * @brief validate workload
+ *
+ * @param workload The workload to check.
+ *
+ * @throws SimulatorException is thrown if the groups do not fit a
+ *   State, the transfer delay gives no lookahead, or a stage runs in
+ *   no group, takes no time or claims more than its group has.
+ */
+static void validateWorkload(const Workload& workload)
+{
+  if (workload.groupTotal.empty() or workload.groupTotal[0].empty() or
+      (workload.groupTotal[0].size() > static_cast<size_t>(MAX_RESOURCES)) or (workload.transferDelay < 1))
+  {
+    stringstream msg;
+    msg << "<validateWorkload> invalid workload of " << workload.groupTotal.size() << " groups with transfer delay "
+        << workload.transferDelay << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  size_t numResources = workload.groupTotal[0].size();
+  int numGroups = workload.groupTotal.size();
+  for (size_t job = 0; job < workload.jobs.size(); job++)
+  {
+    for (const WorkloadStage& stage : workload.jobs[job].stages)
+    {
+      bool valid = (stage.group >= 0) and (stage.group < numGroups) and (stage.duration >= 1) and
+                   (stage.claim.size() == numResources) and (workload.groupTotal[stage.group].size() == numResources);
+      for (size_t resource = 0; valid and (resource < numResources); resource++)
+      {
+        valid = (stage.claim[resource] >= 0) and (stage.claim[resource] <= workload.groupTotal[stage.group][resource]);
+      }
+      if (not valid)
+      {
+        stringstream msg;
+        msg << "<validateWorkload> job " << job << " has a stage in group " << stage.group << " that can never run"
+            << endl;
+        throw SimulatorException(msg.str());
+      }
+    }
+  }
+}
+
+/**
+ * @brief load workload
+ *
+ * Load a workload from a workload file.  Like a simulation file,
+ * comment lines starting with '#' may come before each section.  The
+ * file gives the number of groups, resources and jobs and the
+ * transfer delay, the total resource vector of each group, and then
+ * one line per job: its arrival tick and number of stages, followed
+ * by the group, duration and claim of each resource of each stage.
+ *
+ * @param filename The name of the workload file to load.
+ *
+ * @returns Workload The loaded workload.
+ *
+ * @throws SimulatorException is thrown if the file can not be opened,
+ *   is malformed, or describes an invalid workload.
+ */
+Workload loadWorkload(string filename)
+{
+  ifstream workloadfile(filename);
+  if (not workloadfile.is_open())
+  {
+    stringstream msg;
+    msg << "<loadWorkload> File not found, could not open workload file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int numGroups = 0;
+  int numResources = 0;
+  int numJobs = 0;
+  Workload workload;
+  skipComments(workloadfile);
+  workloadfile >> numGroups >> numResources >> numJobs >> workload.transferDelay;
+  if ((numGroups < 1) or (numResources < 1) or (numResources > MAX_RESOURCES) or (numJobs < 0))
+  {
+    stringstream msg;
+    msg << "<loadWorkload> invalid workload shape numGroups = " << numGroups << " numResources = " << numResources
+        << " numJobs = " << numJobs << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  workload.groupTotal.assign(numGroups, vector<int>(numResources));
+  skipComments(workloadfile);
+  for (vector<int>& total : workload.groupTotal)
+  {
+    for (int& resourceTotal : total)
+    {
+      workloadfile >> resourceTotal;
+    }
+  }
+
+  workload.jobs.resize(numJobs);
+  skipComments(workloadfile);
+  for (WorkloadJob& job : workload.jobs)
+  {
+    int numStages = 0;
+    workloadfile >> job.arrival >> numStages;
+    job.stages.resize(max(numStages, 0));
+    for (WorkloadStage& stage : job.stages)
+    {
+      workloadfile >> stage.group >> stage.duration;
+      stage.claim.resize(numResources);
+      for (int& claim : stage.claim)
+      {
+        workloadfile >> claim;
+      }
+    }
+  }
+
+  if (workloadfile.fail())
+  {
+    stringstream msg;
+    msg << "<loadWorkload> workload file " << filename << " is truncated or malformed" << endl;
+    throw SimulatorException(msg.str());
+  }
+  validateWorkload(workload);
+
+  return workload;
+}
+
+/**
+ * @brief generate workload
+ *
+ * Generate a random workload for capacity planning experiments.
+ * Jobs arrive a few ticks apart and run up to three stages in random
+ * groups, each claiming up to half of its group's resources.
+ *
+ * @param numGroups The number of resource groups.
+ * @param numResources The number of resources of each group.
+ * @param numJobs The number of jobs.
+ * @param seed The seed of the generator, the same seed always gives
+ *   the same workload.
+ *
+ * @returns Workload The generated workload.
+ */
+Workload generateWorkload(int numGroups, int numResources, int numJobs, unsigned int seed)
+{
+  mt19937 generator(seed);
+  uniform_int_distribution<int> totalDistribution(4, 12);
+  uniform_int_distribution<int> gapDistribution(0, 3);
+  uniform_int_distribution<int> stageDistribution(1, 3);
+  uniform_int_distribution<int> groupDistribution(0, numGroups - 1);
+  uniform_int_distribution<int> durationDistribution(1, 20);
+
+  Workload workload;
+  workload.transferDelay = 5;
+  workload.groupTotal.assign(numGroups, vector<int>(numResources));
+  for (vector<int>& total : workload.groupTotal)
+  {
+    for (int& resourceTotal : total)
+    {
+      resourceTotal = totalDistribution(generator);
+    }
+  }
+
+  workload.jobs.resize(numJobs);
+  long arrival = 0;
+  for (WorkloadJob& job : workload.jobs)
+  {
+    arrival += gapDistribution(generator);
+    job.arrival = arrival;
+    job.stages.resize(stageDistribution(generator));
+    for (WorkloadStage& stage : job.stages)
+    {
+      stage.group = groupDistribution(generator);
+      stage.duration = durationDistribution(generator);
+      stage.claim.resize(numResources);
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        stage.claim[resource] = uniform_int_distribution<int>(0, workload.groupTotal[stage.group][resource] / 2)(generator);
+      }
+    }
+  }
+
+  return workload;
+}
+
+/**
+ * @brief simulate workload
+ *
+ * Simulate a workload with its groups partitioned round robin across
+ * threads.  Every thread simulates its groups up to the end of the
+ * window, then once all threads are done the first thread schedules
+ * the stages that moved between groups, and works out the next
+ * window: the earliest pending event plus the transfer delay.  Any
+ * stage moving on within a window arrives no sooner than its end, so
+ * no group ever receives an event in its past.
+ *
+ * The threads wait at a start gate until all of them have been
+ * started.  Should starting one fail, the groups are partitioned
+ * across the threads that did start, and the barrier is sized for
+ * them, before the gate opens.
+ *
+ * @param workload The workload to simulate.
+ * @param policy The admission policy of every group.
+ * @param numThreads The number of threads to simulate with, we never
+ *   use more threads than there are groups.
+ *
+ * @returns WorkloadResult The totals of the simulation, identical for
+ *   any number of threads.
+ *
+ * @throws SimulatorException is thrown if the workload is invalid.
+ */
+WorkloadResult simulateWorkload(const Workload& workload, AdmissionPolicy policy, int numThreads)
+{
+  validateWorkload(workload);
+  int numGroups = workload.groupTotal.size();
+  numThreads = max(1, min(numThreads, numGroups));
+
+  vector<unique_ptr<GroupSimulation>> groups;
+  for (int group = 0; group < numGroups; group++)
+  {
+    groups.push_back(unique_ptr<GroupSimulation>(new GroupSimulation(workload, group, policy)));
+  }
+  for (size_t job = 0; job < workload.jobs.size(); job++)
+  {
+    if (not workload.jobs[job].stages.empty())
+    {
+      const WorkloadStage& stage = workload.jobs[job].stages[0];
+      groups[stage.group]->schedule({workload.jobs[job].arrival, STAGE_ARRIVAL, static_cast<int>(job), 0});
+    }
+  }
+
+  // the first thread sets up each window while the others wait
+  long numWindows = 0;
+  long windowEnd = 0;
+  bool done = false;
+  vector<vector<WorkloadEvent>> outboxes(numThreads);
+  unique_ptr<WindowBarrier> barrier;
+  mutex startMutex;
+  condition_variable startGate;
+  bool started = false;
+  atomic<bool> failed(false);
+  exception_ptr failure;
+  mutex failureMutex;
+
+  auto nextWindow = [&]() {
+    for (vector<WorkloadEvent>& outbox : outboxes)
+    {
+      for (const WorkloadEvent& event : outbox)
+      {
+        groups[workload.jobs[event.job].stages[event.stage].group]->schedule(event);
+      }
+      outbox.clear();
+    }
+    long nextTime = LONG_MAX;
+    for (const unique_ptr<GroupSimulation>& group : groups)
+    {
+      nextTime = min(nextTime, group->nextEventTime());
+    }
+    done = (nextTime == LONG_MAX) or failed.load();
+    windowEnd = done ? nextTime : nextTime + workload.transferDelay;
+    numWindows += not done;
+  };
+
+  auto simulateGroups = [&](int threadIndex) {
+    {
+      unique_lock<mutex> lock(startMutex);
+      startGate.wait(lock, [&started]() { return started; });
+    }
+    while (true)
+    {
+      try
+      {
+        for (int group = threadIndex; group < numGroups; group += numThreads)
+        {
+          groups[group]->run(windowEnd, outboxes[threadIndex]);
+        }
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(failureMutex);
+        failure = current_exception();
+        failed.store(true);
+      }
+      barrier->wait();
+      if (threadIndex == 0)
+      {
+        nextWindow();
+      }
+      barrier->wait();
+      if (done)
+      {
+        break;
+      }
+    }
+  };
+
+  nextWindow();
+  if (not done)
+  {
+    vector<thread> workers;
+    workers.reserve(numThreads - 1);
+    try
+    {
+      for (int worker = 1; worker < numThreads; worker++)
+      {
+        workers.push_back(thread(simulateGroups, worker));
+      }
+    }
+    catch (const system_error&)
+    {
+      // carry on with the threads that did start
+    }
+    {
+      lock_guard<mutex> lock(startMutex);
+      numThreads = workers.size() + 1;
+      barrier.reset(new WindowBarrier(numThreads));
+      started = true;
+    }
+    startGate.notify_all();
+    simulateGroups(0);
+    for (thread& worker : workers)
+    {
+      worker.join();
+    }
+  }
+  if (failure)
+  {
+    rethrow_exception(failure);
+  }
+
+  // add up the groups in order, so even the sums are deterministic
+  WorkloadResult result = {0, numWindows, 0, 0, 0, 0, 0, 0.0};
+  long allocatedTime = 0;
+  long totalResources = 0;
+  for (int group = 0; group < numGroups; group++)
+  {
+    const GroupSimulation& simulation = *groups[group];
+    result.numEvents += simulation.numEvents;
+    result.numCompleted += simulation.numCompleted;
+    result.makespan = max(result.makespan, simulation.lastFinish);
+    result.totalWait += simulation.totalWait;
+    result.totalResponse += simulation.totalResponse;
+    result.numDeniedRequests += simulation.numDeniedRequests;
+    allocatedTime += simulation.allocatedTime;
+    for (int total : workload.groupTotal[group])
+    {
+      totalResources += total;
+    }
+  }
+  if ((result.makespan > 0) and (totalResources > 0))
+  {
+    result.utilization = static_cast<double>(allocatedTime) / (static_cast<double>(totalResources) * result.makespan);
+  }
+
+  return result;
+}
+
+/**
+ * @brief workload result to string
+ *
+ * Display how a policy performed on a workload.
+ *
+ * @param policy The policy the workload was simulated under.
+ * @param result The result to display.
+ *
+ * @returns string The result as a string.
+ */
+string workloadResultToString(AdmissionPolicy policy, const WorkloadResult& result)
+{
+  double meanResponse = (result.numCompleted > 0) ? static_cast<double>(result.totalResponse) / result.numCompleted : 0.0;
+
+  stringstream out;
+  out << left << setw(30)
+      << ((policy == RESOURCE_ALLOCATION_DENIAL) ? "Resource Allocation Denial" : "Process Initiation Denial") << right
+      << fixed << setprecision(3) << " makespan " << setw(8) << result.makespan << "  jobs " << result.numCompleted
+      << "  utilization " << result.utilization << "  mean response " << meanResponse << "  denied requests "
+      << result.numDeniedRequests << "  events " << result.numEvents << "  windows " << result.numWindows << endl;
+  return out.str();
+}
@@ -0,0 +1,268 @@
+/** @file PartitionedSafety.cpp
+ * @brief Partitioned multi-process safety check implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the coordinator and workers of the partitioned
+ * safety check.  Messages between them are arrays of ints.  The
+ * coordinator sends a command, ROUND_COMMAND followed by the
+ * available vector or STOP_COMMAND.  A worker answers each round
+ * with the number of processes it completed followed by the vector
+ * of resources they released.
+ */
+#include "PartitionedSafety.hpp"
+#include "SimulatorException.hpp"
+#include "SocketIO.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/// @brief coordinator command to stop a worker
+static const int STOP_COMMAND = 0;
+/// @brief coordinator command to run a round against the
+///   available vector that follows
+static const int ROUND_COMMAND = 1;
+
+/**
+ * @brief write ints
+ *
+ * Write an array of ints to a socket.
+ *
+ * @param socket The socket to write to.
+ * @param values The ints to write.
+ * @param numValues The number of ints to write.
+ *
+ * @returns bool true if all values were written.
+ */
+static bool writeInts(int socket, const int values[], int numValues)
+{
+  return writeBytes(socket, values, numValues * sizeof(int));
+}
+
+/**
+ * @brief read ints
+ *
+ * Read an array of ints from a socket.
+ *
+ * @param socket The socket to read from.
+ * @param values Returns the ints read.
+ * @param numValues The number of ints to read.
+ *
+ * @returns bool true if all values were read.
+ */
+static bool readInts(int socket, int values[], int numValues)
+{
+  return readBytes(socket, values, numValues * sizeof(int));
+}
+
+/**
+ * @brief partition worker
+ *
+ * The main loop of a worker process, which owns the process rows
+ * [beginProcess, endProcess) of the state.  For each round, every
+ * process of the slice that is not yet completed and whose needs
+ * can be met by the broadcast available resources, plus what the
+ * slice has released so far this round, is completed.
+ *
+ * @param state The state being checked.
+ * @param beginProcess The first process of this worker's slice.
+ * @param endProcess One past the last process of this worker's slice.
+ * @param socket The socket connected to the coordinator.
+ *
+ * @returns int The exit status of the worker process.
+ */
+static int partitionWorker(const State& state, int beginProcess, int endProcess, int socket)
+{
+  int numResources = state.getNumResources();
+  bool completed[MAX_PROCESSES] = {false};
+  int currentAvailable[MAX_RESOURCES];
+  int reply[MAX_RESOURCES + 1];
+
+  int command;
+  while (readInts(socket, &command, 1) and command == ROUND_COMMAND)
+  {
+    if (not readInts(socket, currentAvailable, numResources))
+    {
+      return 1;
+    }
+
+    // repeat over the slice until it reaches a local fixed point,
+    // summing up the resources released as we go
+    int numCompleted = 0;
+    int* released = reply + 1;
+    copyVector(numResources, currentAvailable, released);
+    bool progress = true;
+    while (progress)
+    {
+      progress = false;
+      for (int process = beginProcess; process < endProcess; process++)
+      {
+        if ((not completed[process]) and state.needsAreMet(process, currentAvailable))
+        {
+          state.releaseAllocatedResources(process, currentAvailable);
+          completed[process] = true;
+          numCompleted++;
+          progress = true;
+        }
+      }
+    }
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      released[resource] = currentAvailable[resource] - released[resource];
+    }
+
+    reply[0] = numCompleted;
+    if (not writeInts(socket, reply, numResources + 1))
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief partitioned safety check
+ *
+ * Determine if a state is safe using the partitioned coordinator and
+ * worker processes.  The process rows are divided into numWorkers
+ * contiguous slices, and a worker process is forked for each slice.
+ * The coordinator runs rounds until the workers reach a fixed point,
+ * which is reached with all processes completed if and only if the
+ * state is safe, so the verdict is the same as State::isSafe().
+ *
+ * @param state The state to check.
+ * @param numWorkers The number of worker processes to partition the
+ *   process rows across.  We never use more workers than there are
+ *   processes, and always use at least one.
+ *
+ * @returns bool true if the state is safe, false otherwise.
+ *
+ * @throws SimulatorException is thrown if the workers can not be
+ *   started or a worker fails.
+ */
+bool partitionedIsSafe(const State& state, int numWorkers)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  if (numProcesses == 0)
+  {
+    return true;
+  }
+  numWorkers = max(1, min(numWorkers, numProcesses));
+
+  // start the workers, each with its own slice of the process rows
+  vector<int> sockets;
+  vector<pid_t> workers;
+  int rowsPerWorker = numProcesses / numWorkers;
+  int extraRows = numProcesses % numWorkers;
+  int beginProcess = 0;
+  bool started = true;
+  for (int worker = 0; worker < numWorkers and started; worker++)
+  {
+    int endProcess = beginProcess + rowsPerWorker + (worker < extraRows ? 1 : 0);
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+    {
+      started = false;
+      break;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      // the worker only keeps its own end of its own socket
+      close(pair[0]);
+      for (int socket : sockets)
+      {
+        close(socket);
+      }
+      _exit(partitionWorker(state, beginProcess, endProcess, pair[1]));
+    }
+
+    close(pair[1]);
+    if (pid < 0)
+    {
+      close(pair[0]);
+      started = false;
+      break;
+    }
+    sockets.push_back(pair[0]);
+    workers.push_back(pid);
+    beginProcess = endProcess;
+  }
+
+  // run rounds until no worker completes any more processes
+  int numCompleted = 0;
+  bool failed = not started;
+  int message[MAX_RESOURCES + 1];
+  int reply[MAX_RESOURCES + 1];
+  message[0] = ROUND_COMMAND;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    message[resource + 1] = state.getResourceAvailable(resource);
+  }
+
+  bool progress = not failed;
+  while (progress and numCompleted < numProcesses)
+  {
+    for (int socket : sockets)
+    {
+      failed |= not writeInts(socket, message, numResources + 1);
+    }
+
+    int roundCompleted = 0;
+    for (int socket : sockets)
+    {
+      if (failed or not readInts(socket, reply, numResources + 1))
+      {
+        failed = true;
+        break;
+      }
+      roundCompleted += reply[0];
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        message[resource + 1] += reply[resource + 1];
+      }
+    }
+
+    numCompleted += roundCompleted;
+    progress = (roundCompleted > 0) and not failed;
+  }
+
+  // stop the workers and wait for them to exit
+  int stop = STOP_COMMAND;
+  for (int socket : sockets)
+  {
+    writeInts(socket, &stop, 1);
+    close(socket);
+  }
+  for (pid_t pid : workers)
+  {
+    int status = 0;
+    pid_t waited = waitpid(pid, &status, 0);
+    while (waited < 0 and errno == EINTR)
+    {
+      waited = waitpid(pid, &status, 0);
+    }
+    failed |= (waited < 0) or not WIFEXITED(status) or WEXITSTATUS(status) != 0;
+  }
+
+  if (failed)
+  {
+    stringstream msg;
+    msg << "<partitionedIsSafe> partitioned safety check with " << numWorkers << " workers failed" << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  return numCompleted == numProcesses;
+}
@@ -0,0 +1,222 @@
+/** @file PolicySimulation.cpp
+ * @brief Admission policy trace simulation implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the simulation of job traces under Resource
+ * Allocation Denial and Process Initiation Denial.
+ */
+#include "PolicySimulation.hpp"
+#include "SimulatorException.hpp"
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief load policy trace
+ *
+ * Load a trace of jobs from a trace file.  Like a simulation file,
+ * comment lines starting with '#' may come before each section.  The
+ * file gives the number of resources and jobs, the total resource
+ * vector, and then one line per job with its arrival tick followed
+ * by its claim of each resource.
+ *
+ * @param filename The name of the trace file to load.
+ *
+ * @returns PolicyTrace The loaded trace.
+ *
+ * @throws SimulatorException is thrown if the file can not be opened,
+ *   is malformed, or a job claims more than exists in the system or
+ *   arrives before the job before it.
+ */
+PolicyTrace loadPolicyTrace(string filename)
+{
+  ifstream tracefile(filename);
+  if (not tracefile.is_open())
+  {
+    stringstream msg;
+    msg << "<loadPolicyTrace> File not found, could not open trace file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int numResources = 0;
+  int numJobs = 0;
+  skipComments(tracefile);
+  tracefile >> numResources >> numJobs;
+  if ((numResources < 1) or (numResources > MAX_RESOURCES) or (numJobs < 0))
+  {
+    stringstream msg;
+    msg << "<loadPolicyTrace> invalid trace shape numResources = " << numResources << " numJobs = " << numJobs << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  PolicyTrace trace;
+  trace.total.resize(numResources);
+  skipComments(tracefile);
+  for (int& total : trace.total)
+  {
+    tracefile >> total;
+  }
+
+  trace.jobs.resize(numJobs);
+  skipComments(tracefile);
+  for (int job = 0; job < numJobs; job++)
+  {
+    TraceJob& traceJob = trace.jobs[job];
+    tracefile >> traceJob.arrival;
+    traceJob.claim.resize(numResources);
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      tracefile >> traceJob.claim[resource];
+      if ((traceJob.claim[resource] < 0) or (traceJob.claim[resource] > trace.total[resource]))
+      {
+        stringstream msg;
+        msg << "<loadPolicyTrace> job " << job << " claim of " << traceJob.claim[resource] << " R" << resource
+            << " can never be met" << endl;
+        throw SimulatorException(msg.str());
+      }
+    }
+    if ((job > 0) and (traceJob.arrival < trace.jobs[job - 1].arrival))
+    {
+      stringstream msg;
+      msg << "<loadPolicyTrace> job " << job << " arrives before the job before it" << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+
+  if (not tracefile)
+  {
+    stringstream msg;
+    msg << "<loadPolicyTrace> truncated or malformed trace file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+  return trace;
+}
+
+/**
+ * @brief simulate policy
+ *
+ * Simulate a trace of jobs under an admission policy.  Jobs are
+ * started in arrival order, a job that can not be started yet holds
+ * up the jobs behind it, and at most MAX_PROCESSES jobs run at once.
+ * Every running process requests one more unit of each resource it
+ * still needs each tick, and once it holds its full claim it
+ * finishes at the start of the next tick, releasing everything.
+ *
+ * Neither policy can deadlock, some running process can always
+ * complete, so the simulation always finishes.
+ *
+ * @param trace The trace of jobs to simulate.
+ * @param policy The admission policy to simulate the jobs under.
+ *
+ * @returns PolicyResult The throughput and utilization measures of
+ *   the simulation.
+ */
+PolicyResult simulatePolicy(const PolicyTrace& trace, AdmissionPolicy policy)
+{
+  int numResources = trace.total.size();
+  long totalResources = 0;
+  for (int total : trace.total)
+  {
+    totalResources += total;
+  }
+
+  State state;
+  state.loadState(0, numResources, trace.total, vector<int>(), vector<int>());
+
+  PolicyResult result = {0, 0, 0, 0, 0.0};
+  deque<int> waiting;
+  size_t nextArrival = 0;
+  double allocatedSum = 0.0;
+  int request[MAX_RESOURCES];
+
+  for (long tick = 0; result.numCompleted < static_cast<long>(trace.jobs.size()); tick++)
+  {
+    // processes holding their full claim finish, we go from the last
+    // process down since terminating moves the last process
+    for (int process = state.getNumProcesses() - 1; process >= 0; process--)
+    {
+      bool finished = true;
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        finished = finished and (state.getNeed(process, resource) == 0);
+      }
+      if (finished)
+      {
+        state.terminateProcess(process);
+        result.numCompleted++;
+      }
+    }
+
+    // newly arrived jobs queue up, and are started in arrival order
+    while ((nextArrival < trace.jobs.size()) and (trace.jobs[nextArrival].arrival <= tick))
+    {
+      waiting.push_back(nextArrival++);
+    }
+    while (not waiting.empty() and (state.getNumProcesses() < MAX_PROCESSES))
+    {
+      const TraceJob& job = trace.jobs[waiting.front()];
+      if (state.initiateProcess(job.claim.data(), policy) == NO_CANDIDATE)
+      {
+        break;
+      }
+      result.totalWait += tick - job.arrival;
+      waiting.pop_front();
+    }
+
+    // every running process asks for one more unit of what it needs
+    for (int process = 0; process < state.getNumProcesses(); process++)
+    {
+      bool needsMore = false;
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        request[resource] = (state.getNeed(process, resource) > 0);
+        needsMore = needsMore or request[resource];
+      }
+      if (needsMore and not state.requestResources(process, request, policy))
+      {
+        result.numDeniedRequests++;
+      }
+    }
+
+    long allocated = 0;
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      allocated += trace.total[resource] - state.getResourceAvailable(resource);
+    }
+    allocatedSum += (totalResources > 0) ? static_cast<double>(allocated) / totalResources : 0.0;
+    result.numTicks = tick + 1;
+  }
+
+  result.utilization = (result.numTicks > 0) ? allocatedSum / result.numTicks : 0.0;
+  return result;
+}
+
+/**
+ * @brief policy result to string
+ *
+ * Format the outcome of simulating a trace under a policy as one
+ * line of a policy comparison.
+ *
+ * @param policy The policy the trace was simulated under.
+ * @param result The outcome of the simulation.
+ *
+ * @returns string The formatted result line.
+ */
+string policyResultToString(AdmissionPolicy policy, const PolicyResult& result)
+{
+  double throughput = (result.numTicks > 0) ? static_cast<double>(result.numCompleted) / result.numTicks : 0.0;
+  double meanWait = (result.numCompleted > 0) ? static_cast<double>(result.totalWait) / result.numCompleted : 0.0;
+
+  stringstream out;
+  out << left << setw(30)
+      << ((policy == RESOURCE_ALLOCATION_DENIAL) ? "Resource Allocation Denial" : "Process Initiation Denial") << right
+      << fixed << setprecision(3) << " ticks " << setw(6) << result.numTicks << "  jobs/tick " << throughput
+      << "  utilization " << result.utilization << "  mean wait " << meanWait << "  denied requests "
+      << result.numDeniedRequests << endl;
+  return out.str();
+}
@@ -0,0 +1,310 @@
+/** @file Replication.cpp
+ * @brief Primary/backup State replication implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the primary and standby sides of State
+ * replication by log shipping.
+ */
+#include "Replication.hpp"
+#include "SimulatorException.hpp"
+#include "SocketIO.hpp"
+#include "StateArchive.hpp"
+#include <unistd.h>
+
+using namespace std;
+
+/// @brief log record type of a full state snapshot
+static const char SNAPSHOT_RECORD = 'S';
+/// @brief log record type of a state delta
+static const char DELTA_RECORD = 'D';
+
+/**
+ * @brief allocation delta
+ *
+ * Build the state delta of changing the allocation of one process.
+ *
+ * @param process The process whose allocation changes.
+ * @param numResources The number of resources of the state.
+ * @param change The change of each resource allocation.
+ * @param sign 1 to add the change to the allocation, -1 to subtract it.
+ *
+ * @returns StateDelta The sparse delta of the allocation change.
+ */
+static StateDelta allocationDelta(int process, int numResources, const int change[], int sign)
+{
+  StateDelta delta;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    if (change[resource] != 0)
+    {
+      delta.cells.push_back({process, resource, 0, sign * change[resource]});
+    }
+  }
+  return delta;
+}
+
+/**
+ * @brief primary constructor
+ *
+ * Start replicating a state to a standby.  A full snapshot of the
+ * state is logged first, so the standby starts from the same state.
+ *
+ * @param state The state to replicate, it must only be changed
+ *   through this primary from now on.
+ * @param socket A socket connected to the standby, the primary
+ *   closes it when it is destroyed.
+ */
+ReplicationPrimary::ReplicationPrimary(State& state, int socket)
+  : state(state)
+  , socket(socket)
+  , numLogged(1)
+  , numShipped(0)
+  , stopping(false)
+  , failed(false)
+{
+  pendingLog.push_back(SNAPSHOT_RECORD);
+  encodeState(pendingLog, state);
+  shipper = thread(&ReplicationPrimary::shipLog, this);
+}
+
+/**
+ * @brief primary destructor
+ *
+ * Ship whatever is left in the log, stop the shipper and close the
+ * socket, which tells the standby the primary has gone away.
+ */
+ReplicationPrimary::~ReplicationPrimary()
+{
+  {
+    lock_guard<mutex> lock(logMutex);
+    stopping = true;
+  }
+  logWritten.notify_all();
+  shipper.join();
+  close(socket);
+}
+
+/**
+ * @brief request resources
+ *
+ * Admit a resource request on the primary's state, as
+ * State::requestResources() does.  If the request is granted the
+ * allocation change is appended to the log, the call does not wait
+ * for it to be shipped.
+ *
+ * @param process The process making the request.
+ * @param request The number of each resource requested.
+ *
+ * @returns bool true if the request was granted, false if denied.
+ *
+ * @throws SimulatorException is thrown if the request is invalid.
+ */
+bool ReplicationPrimary::requestResources(int process, const int request[])
+{
+  bool granted;
+  {
+    lock_guard<mutex> lock(logMutex);
+    granted = state.requestResources(process, request);
+    if (granted)
+    {
+      logDelta(allocationDelta(process, state.getNumResources(), request, 1));
+    }
+  }
+  if (granted)
+  {
+    logWritten.notify_one();
+  }
+  return granted;
+}
+
+/**
+ * @brief release resources
+ *
+ * Release resources on the primary's state, as
+ * State::releaseResources() does, and append the allocation change
+ * to the log without waiting for it to be shipped.
+ *
+ * @param process The process releasing resources.
+ * @param release The number of each resource released.
+ *
+ * @throws SimulatorException is thrown if the release is invalid.
+ */
+void ReplicationPrimary::releaseResources(int process, const int release[])
+{
+  {
+    lock_guard<mutex> lock(logMutex);
+    state.releaseResources(process, release);
+    logDelta(allocationDelta(process, state.getNumResources(), release, -1));
+  }
+  logWritten.notify_one();
+}
+
+/**
+ * @brief flush the log
+ *
+ * Wait until everything logged so far has been shipped to the
+ * standby, e.g. before a planned failover.
+ *
+ * @returns bool true if the whole log was shipped, false if
+ *   shipping to the standby failed.
+ */
+bool ReplicationPrimary::flush()
+{
+  unique_lock<mutex> lock(logMutex);
+  logShipped.wait(lock, [this]() { return failed or numShipped == numLogged; });
+  return not failed;
+}
+
+/**
+ * @brief log a delta
+ *
+ * Append a delta record to the pending log, the log mutex must be
+ * held by the caller.
+ *
+ * @param delta The change made to the primary's state.
+ */
+void ReplicationPrimary::logDelta(const StateDelta& delta)
+{
+  pendingLog.push_back(DELTA_RECORD);
+  encodeDelta(pendingLog, delta, state.getNumResources());
+  numLogged++;
+}
+
+/**
+ * @brief ship the log
+ *
+ * Main loop of the shipper thread.  We wait for records to be
+ * logged, then take everything logged so far as one batch and send
+ * it to the standby outside of the lock, so the grant path is only
+ * ever held up by appending to the log.  Once the primary is
+ * stopping, the rest of the log is shipped before we exit.
+ */
+void ReplicationPrimary::shipLog()
+{
+  unique_lock<mutex> lock(logMutex);
+  while (true)
+  {
+    logWritten.wait(lock, [this]() { return stopping or not pendingLog.empty(); });
+    if (pendingLog.empty())
+    {
+      break;
+    }
+
+    string batch;
+    batch.swap(pendingLog);
+    uint64_t batchLogged = numLogged;
+    lock.unlock();
+
+    bool shipped = false;
+    if (not failed)
+    {
+      uint32_t length = batch.size();
+      shipped = writeBytes(socket, &length, sizeof(length)) and writeBytes(socket, batch.data(), batch.size());
+    }
+
+    lock.lock();
+    failed |= not shipped;
+    numShipped = batchLogged;
+    logShipped.notify_all();
+  }
+}
+
+/**
+ * @brief standby constructor
+ *
+ * Create a standby receiving the log of a primary.  The standby's
+ * state is empty until the first batch, holding the primary's
+ * snapshot, has been received.
+ *
+ * @param socket A socket connected to the primary, the standby
+ *   closes it when it is destroyed.
+ */
+ReplicationStandby::ReplicationStandby(int socket)
+  : socket(socket)
+  , numApplied(0)
+{
+}
+
+/**
+ * @brief standby destructor
+ *
+ * Close the socket to the primary.
+ */
+ReplicationStandby::~ReplicationStandby()
+{
+  close(socket);
+}
+
+/**
+ * @brief receive a batch
+ *
+ * Wait for the next batch of the log from the primary, and apply
+ * its records to the standby's state.
+ *
+ * @returns bool true if a batch was applied, false if the primary
+ *   closed the connection (or went away).
+ *
+ * @throws SimulatorException is thrown if the batch is corrupt.
+ */
+bool ReplicationStandby::receiveBatch()
+{
+  uint32_t length;
+  if (not readBytes(socket, &length, sizeof(length)))
+  {
+    return false;
+  }
+  string batch(length, '\0');
+  if (not readBytes(socket, &batch[0], length))
+  {
+    return false;
+  }
+
+  const char* in = batch.data();
+  const char* end = in + batch.size();
+  StateDelta delta;
+  while (in < end)
+  {
+    char record = *in++;
+    if (record == SNAPSHOT_RECORD)
+    {
+      decodeState(in, end, state);
+    }
+    else if (record == DELTA_RECORD)
+    {
+      decodeDelta(in, end, delta, state.getNumResources());
+      state.applyDelta(delta);
+    }
+    else
+    {
+      throw SimulatorException("<ReplicationStandby::receiveBatch> corrupt log record\n");
+    }
+    numApplied++;
+  }
+  return true;
+}
+
+/**
+ * @brief standby state accessor
+ *
+ * @returns const State& The standby's copy of the replicated state,
+ *   as of the last batch received.
+ */
+const State& ReplicationStandby::getState() const
+{
+  return state;
+}
+
+/**
+ * @brief number of records applied accessor
+ *
+ * @returns uint64_t The number of log records applied so far,
+ *   including the initial snapshot.
+ */
+uint64_t ReplicationStandby::getNumApplied() const
+{
+  return numApplied;
+}
@@ -0,0 +1,120 @@
+/** @file ResourceKernels.cpp
+ * @brief Width specialized resource vector kernels
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the generic resource vector kernels, and the
+ * dispatch tables of template instantiated kernels for the common
+ * resource widths.
+ */
+#include "ResourceKernels.hpp"
+#include "State.hpp"
+
+/// @brief generic kernels, used for any width we do not specialize
+static const ResourceKernels genericKernels = {0, genericNeedsAreMet, genericClaimNeedsAreMet, genericAccumulate, genericCopy};
+
+/// @brief kernels specialized for states with 4 resources
+static const ResourceKernels width4Kernels = {4, fixedNeedsAreMet<4>, fixedClaimNeedsAreMet<4>, fixedAccumulate<4>, fixedCopy<4>};
+
+/// @brief kernels specialized for states with 8 resources
+static const ResourceKernels width8Kernels = {8, fixedNeedsAreMet<8>, fixedClaimNeedsAreMet<8>, fixedAccumulate<8>, fixedCopy<8>};
+
+/// @brief kernels specialized for states with 16 resources
+static const ResourceKernels width16Kernels = {16, fixedNeedsAreMet<16>, fixedClaimNeedsAreMet<16>, fixedAccumulate<16>, fixedCopy<16>};
+
+/**
+ * @brief select resource kernels
+ *
+ * Select the table of kernels to use for vectors of the given
+ * number of resources.  The specialized kernels are only used when
+ * the width matches exactly, since the vectors handed to us by
+ * callers are only guaranteed to hold numResources values.  Widths
+ * larger than MAX_RESOURCES are never selected.
+ *
+ * @param numResources The number of resources (columns) in the
+ *   vectors the kernels will be applied to.
+ *
+ * @returns const ResourceKernels* Returns the kernel table to use,
+ *   which is the generic table if this width is not specialized.
+ */
+const ResourceKernels* selectResourceKernels(int numResources)
+{
+  switch (numResources)
+  {
+  case 4:
+    return &width4Kernels;
+  case 8:
+    return &width8Kernels;
+  case 16:
+    return &width16Kernels;
+  default:
+    return &genericKernels;
+  }
+}
+
+/**
+ * @brief generic needs are met kernel
+ *
+ * Counted loop version of the needs test, we stop at the first
+ * group of needs that cannot be met.
+ *
+ * @param numResources The number of resources to compare.
+ * @param need The need row of a process.
+ * @param available The currently available resources.
+ *
+ * @returns bool true if every need can be met.
+ */
+bool genericNeedsAreMet(int numResources, const int need[], const int available[])
+{
+  return vectorLessEqual(numResources, need, available);
+}
+
+/**
+ * @brief generic claim needs are met kernel
+ *
+ * Counted loop version of the needs test computing need = claim -
+ * allocation on the fly, we stop at the first group of needs that
+ * cannot be met.
+ *
+ * @param numResources The number of resources to compare.
+ * @param claim The claim row of a process.
+ * @param allocation The allocation row of a process.
+ * @param available The currently available resources.
+ *
+ * @returns bool true if every need can be met.
+ */
+bool genericClaimNeedsAreMet(int numResources, const int claim[], const int allocation[], const int available[])
+{
+  return vectorDifferenceLessEqual(numResources, claim, allocation, available);
+}
+
+/**
+ * @brief generic accumulate kernel
+ *
+ * Counted loop version of dst += src.
+ *
+ * @param numResources The number of resources to add.
+ * @param src The vector to add.
+ * @param dst The vector being accumulated into.
+ */
+void genericAccumulate(int numResources, const int src[], int dst[])
+{
+  vectorAdd(numResources, src, dst);
+}
+
+/**
+ * @brief generic copy kernel
+ *
+ * Counted loop version of dst = src.
+ *
+ * @param numResources The number of resources to copy.
+ * @param src The vector to copy from.
+ * @param dst The vector to copy into.
+ */
+void genericCopy(int numResources, const int src[], int dst[])
+{
+  vectorCopy(numResources, src, dst);
+}
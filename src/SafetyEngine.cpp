@@ -0,0 +1,408 @@
+/** @file SafetyEngine.cpp
+ * @brief Safety engine interface and autotuning selector implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the safety engines and of the autotuning engine
+ * selector.
+ */
+#include "SafetyEngine.hpp"
+#include "SimulatorException.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+/// @brief the clock the selector profiles engines with
+typedef chrono::steady_clock TuningClock;
+
+/**
+ * @brief safety engine destructor
+ */
+SafetyEngine::~SafetyEngine()
+{
+}
+
+/**
+ * @brief scan engine name
+ *
+ * @returns string The name of the engine, as used in tuning files.
+ */
+string ScanSafetyEngine::getName() const
+{
+  return "scan";
+}
+
+/**
+ * @brief scan engine safety check
+ *
+ * @param state The state to check.
+ *
+ * @returns bool true if the state is safe.
+ */
+bool ScanSafetyEngine::isSafe(const State& state)
+{
+  return state.isSafe();
+}
+
+/**
+ * @brief workspace engine name
+ *
+ * @returns string The name of the engine, as used in tuning files.
+ */
+string WorkspaceSafetyEngine::getName() const
+{
+  return "workspace";
+}
+
+/**
+ * @brief workspace engine safety check
+ *
+ * @param state The state to check.
+ *
+ * @returns bool true if the state is safe.
+ */
+bool WorkspaceSafetyEngine::isSafe(const State& state)
+{
+  return state.isSafe(workspace);
+}
+
+/**
+ * @brief summary tree engine constructor
+ *
+ * Reserve the safe sequence buffer up front, so checks never allocate.
+ */
+SummaryTreeSafetyEngine::SummaryTreeSafetyEngine()
+{
+  safeSequence.reserve(MAX_PROCESSES);
+}
+
+/**
+ * @brief summary tree engine name
+ *
+ * @returns string The name of the engine, as used in tuning files.
+ */
+string SummaryTreeSafetyEngine::getName() const
+{
+  return "summary-tree";
+}
+
+/**
+ * @brief summary tree engine safety check
+ *
+ * @param state The state to check.
+ *
+ * @returns bool true if the state is safe.
+ */
+bool SummaryTreeSafetyEngine::isSafe(const State& state)
+{
+  return state.isSafe(tree, safeSequence);
+}
+
+/**
+ * @brief size bucket
+ *
+ * Bucket a number of processes or resources by powers of two, 1,
+ * 2, 3-4, 5-8, 9-16 and 17-32.
+ *
+ * @param size The number of processes or resources.
+ *
+ * @returns int The size bucket.
+ */
+static int sizeBucket(int size)
+{
+  int bucket = 0;
+  while ((bucket < SIZE_BUCKETS - 1) and ((1 << bucket) < size))
+  {
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * @brief value width bucket
+ *
+ * Bucket the largest claim value of a state by its width in bits.
+ *
+ * @param maxValue The largest claim value.
+ *
+ * @returns int The value width bucket.
+ */
+static int valueWidthBucket(int maxValue)
+{
+  const int widthLimits[VALUE_WIDTH_BUCKETS - 1] = {1, (1 << 4) - 1, (1 << 8) - 1};
+  int bucket = 0;
+  while ((bucket < VALUE_WIDTH_BUCKETS - 1) and (maxValue > widthLimits[bucket]))
+  {
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * @brief shape bucket
+ *
+ * Bucket a state by its shape, its number of processes and
+ * resources, the fraction of its needs that are nonzero, and the
+ * width of its largest claim.  The state keeps its count of nonzero
+ * needs and its largest claim from when its information was
+ * inferred, so bucketing does not scan the state.
+ *
+ * @param state The state to bucket.
+ *
+ * @returns int The shape bucket of the state.
+ */
+int shapeBucket(const State& state)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  int nonzeroNeeds = state.getNumNonzeroNeeds();
+  int maxValue = state.getMaxClaim();
+
+  int numCells = numProcesses * numResources;
+  int density = (numCells > 0) ? min(nonzeroNeeds * DENSITY_BUCKETS / numCells, DENSITY_BUCKETS - 1) : 0;
+  return ((sizeBucket(numProcesses) * SIZE_BUCKETS + sizeBucket(numResources)) * DENSITY_BUCKETS + density) *
+           VALUE_WIDTH_BUCKETS +
+         valueWidthBucket(maxValue);
+}
+
+/**
+ * @brief representative state
+ *
+ * Generate a state of the given shape bucket to profile the engines
+ * on.  The state has the most processes and resources of the bucket
+ * (up to the maximum we handle), needs of the bucket's density and
+ * claims of the bucket's width.  It is safe, but processes with a
+ * need can only complete after the process after them has, so a
+ * check has to do the full amount of work.  The same bucket always gives the same state.
+ *
+ * @param bucket The shape bucket.
+ *
+ * @returns State A representative state of the bucket.
+ */
+State representativeState(int bucket)
+{
+  const int maxValues[VALUE_WIDTH_BUCKETS] = {1, (1 << 4) - 1, (1 << 8) - 1, (1 << 12) - 1};
+  int width = bucket % VALUE_WIDTH_BUCKETS;
+  bucket /= VALUE_WIDTH_BUCKETS;
+  int density = bucket % DENSITY_BUCKETS;
+  bucket /= DENSITY_BUCKETS;
+  int numResources = min(1 << (bucket % SIZE_BUCKETS), MAX_RESOURCES);
+  int numProcesses = min(1 << (bucket / SIZE_BUCKETS), MAX_PROCESSES);
+
+  mt19937 generator(bucket * VALUE_WIDTH_BUCKETS * DENSITY_BUCKETS + density * VALUE_WIDTH_BUCKETS + width);
+  uniform_int_distribution<int> value(1, maxValues[width]);
+  bernoulli_distribution hasNeed((density + 0.5) / DENSITY_BUCKETS);
+
+  // each process needs at most what the process after it holds, and
+  // the last process at most what is available, so the state is safe
+  int numCells = numProcesses * numResources;
+  vector<int> claims(numCells);
+  vector<int> allocations(numCells);
+  vector<int> total(numResources, maxValues[width]);
+  for (int process = numProcesses - 1; process >= 0; process--)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      int cell = process * numResources + resource;
+      int held = (process < numProcesses - 1) ? allocations[cell + numResources] : maxValues[width];
+      claims[cell] = value(generator);
+      int need = hasNeed(generator) ? min(held, uniform_int_distribution<int>(1, claims[cell])(generator)) : 0;
+      allocations[cell] = claims[cell] - need;
+      total[resource] += allocations[cell];
+    }
+  }
+
+  State state;
+  state.loadState(numProcesses, numResources, total, claims, allocations);
+  return state;
+}
+
+/**
+ * @brief engine selector constructor
+ *
+ * Create a selector holding one of each engine, which selects the
+ * plain scan for every bucket until it is tuned.
+ */
+EngineSelector::EngineSelector()
+{
+  engines.push_back(unique_ptr<SafetyEngine>(new ScanSafetyEngine()));
+  engines.push_back(unique_ptr<SafetyEngine>(new WorkspaceSafetyEngine()));
+  engines.push_back(unique_ptr<SafetyEngine>(new SummaryTreeSafetyEngine()));
+  for (int bucket = 0; bucket < SHAPE_BUCKETS; bucket++)
+  {
+    selected[bucket] = 0;
+  }
+}
+
+/**
+ * @brief number of engines accessor
+ *
+ * @returns int The number of engines the selector selects from.
+ */
+int EngineSelector::getNumEngines() const
+{
+  return engines.size();
+}
+
+/**
+ * @brief engine accessor
+ *
+ * @param engine The index of the engine.
+ *
+ * @returns SafetyEngine& The engine.
+ */
+SafetyEngine& EngineSelector::getEngine(int engine)
+{
+  return *engines[engine];
+}
+
+/**
+ * @brief find engine by name
+ *
+ * @param name The name of the engine to find.
+ *
+ * @returns int The index of the engine, or -1 if there is none.
+ */
+int EngineSelector::findEngine(const string& name) const
+{
+  for (size_t engine = 0; engine < engines.size(); engine++)
+  {
+    if (engines[engine]->getName() == name)
+    {
+      return engine;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief tune selector
+ *
+ * Profile every engine on the representative state of every shape
+ * bucket on this host, and select the fastest engine for each
+ * bucket.  Each engine is timed over a number of repeated checks,
+ * after one untimed check to warm up its scratch space.
+ *
+ * @param repetitions The number of timed checks of each engine on
+ *   each bucket.
+ */
+void EngineSelector::tune(int repetitions)
+{
+  for (int bucket = 0; bucket < SHAPE_BUCKETS; bucket++)
+  {
+    State state = representativeState(bucket);
+    double fastest = 0.0;
+    for (size_t engine = 0; engine < engines.size(); engine++)
+    {
+      volatile bool verdict = engines[engine]->isSafe(state);
+      TuningClock::time_point start = TuningClock::now();
+      for (int repetition = 0; repetition < repetitions; repetition++)
+      {
+        verdict = engines[engine]->isSafe(state);
+      }
+      double seconds = chrono::duration<double>(TuningClock::now() - start).count();
+      (void)verdict;
+
+      if ((engine == 0) or (seconds < fastest))
+      {
+        fastest = seconds;
+        selected[bucket] = engine;
+      }
+    }
+  }
+}
+
+/**
+ * @brief load tuning file
+ *
+ * Load the engine selected for each bucket from a tuning file saved
+ * by saveTuning(), so the selector need not be tuned again on the
+ * same host.  Buckets missing from the file keep their selection.
+ *
+ * @param filename The name of the tuning file.
+ *
+ * @throws SimulatorException is thrown if the file can not be opened,
+ *   or names an unknown bucket or engine.
+ */
+void EngineSelector::loadTuning(string filename)
+{
+  ifstream tuningfile(filename);
+  if (not tuningfile.is_open())
+  {
+    stringstream msg;
+    msg << "<EngineSelector::loadTuning> File not found, could not open tuning file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int bucket;
+  string name;
+  skipComments(tuningfile);
+  while (tuningfile >> bucket >> name)
+  {
+    int engine = findEngine(name);
+    if ((bucket < 0) or (bucket >= SHAPE_BUCKETS) or (engine < 0))
+    {
+      stringstream msg;
+      msg << "<EngineSelector::loadTuning> invalid tuning of bucket " << bucket << " to engine " << name << endl;
+      throw SimulatorException(msg.str());
+    }
+    selected[bucket] = engine;
+  }
+}
+
+/**
+ * @brief save tuning file
+ *
+ * Save the engine selected for each bucket, one bucket per line.
+ *
+ * @param filename The name of the tuning file.
+ *
+ * @throws SimulatorException is thrown if the file can not be written.
+ */
+void EngineSelector::saveTuning(string filename) const
+{
+  ofstream tuningfile(filename);
+  if (not tuningfile.is_open())
+  {
+    stringstream msg;
+    msg << "<EngineSelector::saveTuning> could not write tuning file:" << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  tuningfile << "# safety engine selected for each shape bucket" << endl;
+  for (int bucket = 0; bucket < SHAPE_BUCKETS; bucket++)
+  {
+    tuningfile << bucket << " " << engines[selected[bucket]]->getName() << endl;
+  }
+}
+
+/**
+ * @brief select engine
+ *
+ * @param state The state to be checked.
+ *
+ * @returns SafetyEngine& The fastest engine for the shape of the state.
+ */
+SafetyEngine& EngineSelector::select(const State& state)
+{
+  return *engines[selected[shapeBucket(state)]];
+}
+
+/**
+ * @brief check if a state is safe
+ *
+ * Check if a state is safe with the fastest engine for its shape.
+ *
+ * @param state The state to check.
+ *
+ * @returns bool true if the state is safe.
+ */
+bool EngineSelector::isSafe(const State& state)
+{
+  return select(state).isSafe(state);
+}
@@ -0,0 +1,62 @@
+/** @file SafetyWorkspace.cpp
+ * @brief Reusable safety check scratch space implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the safety check workspace member functions.
+ */
+#include "SafetyWorkspace.hpp"
+
+/**
+ * @brief workspace constructor
+ *
+ * Create an empty workspace, ready for a check of an empty state.
+ */
+SafetyWorkspace::SafetyWorkspace()
+{
+  reset(0, nullptr);
+}
+
+/**
+ * @brief reset workspace
+ *
+ * Prepare the workspace for a new safety check, starting from the
+ * given available resources with no processes completed.
+ *
+ * @param numResources The number of resources of the state checked.
+ * @param available The resources initially available.
+ */
+void SafetyWorkspace::reset(int numResources, const int available[])
+{
+  copyVector(numResources, available, currentAvailable);
+  for (int word = 0; word < BITMAP_WORDS; word++)
+  {
+    completed[word] = 0;
+  }
+  sequenceLength = 0;
+}
+
+/**
+ * @brief is process completed
+ *
+ * @param process The process to test.
+ *
+ * @returns bool true if the process has completed in this check.
+ */
+bool SafetyWorkspace::isCompleted(int process) const
+{
+  return (completed[process / BITMAP_WORD_BITS] >> (process % BITMAP_WORD_BITS)) & 1;
+}
+
+/**
+ * @brief mark process completed
+ *
+ * @param process The process that has completed in this check.
+ */
+void SafetyWorkspace::markCompleted(int process)
+{
+  completed[process / BITMAP_WORD_BITS] |= uint64_t(1) << (process % BITMAP_WORD_BITS);
+}
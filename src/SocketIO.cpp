@@ -0,0 +1,201 @@
+/** @file SocketIO.cpp
+ * @brief Unix domain socket helpers implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation of the helpers to create Unix domain sockets and
+ * to reliably send and receive blocks of bytes over them.
+ */
+#include "SocketIO.hpp"
+#include "SimulatorException.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief write bytes
+ *
+ * Write a block of bytes to a socket, retrying partial writes.
+ * We send with MSG_NOSIGNAL, so writing to a socket whose other end
+ * has gone away is reported as an error rather than a SIGPIPE.
+ *
+ * @param socket The socket to write to.
+ * @param data The bytes to write.
+ * @param numBytes The number of bytes to write.
+ *
+ * @returns bool true if all bytes were written.
+ */
+bool writeBytes(int socket, const void* data, size_t numBytes)
+{
+  const char* next = static_cast<const char*>(data);
+  while (numBytes > 0)
+  {
+    ssize_t written = send(socket, next, numBytes, MSG_NOSIGNAL);
+    if (written < 0 and errno == EINTR)
+    {
+      continue;
+    }
+    if (written <= 0)
+    {
+      return false;
+    }
+    next += written;
+    numBytes -= written;
+  }
+  return true;
+}
+
+/**
+ * @brief read bytes
+ *
+ * Read a block of bytes from a socket, retrying partial reads.
+ *
+ * @param socket The socket to read from.
+ * @param data Returns the bytes read.
+ * @param numBytes The number of bytes to read.
+ *
+ * @returns bool true if all bytes were read, false on error or if
+ *   the other end closed the socket.
+ */
+bool readBytes(int socket, void* data, size_t numBytes)
+{
+  char* next = static_cast<char*>(data);
+  while (numBytes > 0)
+  {
+    ssize_t received = read(socket, next, numBytes);
+    if (received < 0 and errno == EINTR)
+    {
+      continue;
+    }
+    if (received <= 0)
+    {
+      return false;
+    }
+    next += received;
+    numBytes -= received;
+  }
+  return true;
+}
+
+/**
+ * @brief unix socket address
+ *
+ * Fill in the address of a Unix domain socket path.
+ *
+ * @param path The file system path of the socket.
+ * @param address Returns the socket address.
+ *
+ * @throws SimulatorException is thrown if the path is too long.
+ */
+static void unixSocketAddress(const string& path, sockaddr_un& address)
+{
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    stringstream msg;
+    msg << "<unixSocketAddress> socket path too long: " << path << endl;
+    throw SimulatorException(msg.str());
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+}
+
+/**
+ * @brief listen on a unix socket
+ *
+ * Create a Unix domain stream socket bound to the given path and
+ * listen for connections on it.  Any stale socket file left at the
+ * path is removed first.
+ *
+ * @param path The file system path of the socket.
+ *
+ * @returns int The listening socket.
+ *
+ * @throws SimulatorException is thrown if the socket can not be
+ *   created, bound or listened on.
+ */
+int listenUnixSocket(const string& path)
+{
+  sockaddr_un address;
+  unixSocketAddress(path, address);
+  unlink(path.c_str());
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ((listener < 0) or (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) or
+      (listen(listener, 1) != 0))
+  {
+    if (listener >= 0)
+    {
+      close(listener);
+    }
+    stringstream msg;
+    msg << "<listenUnixSocket> could not listen on socket: " << path << " " << strerror(errno) << endl;
+    throw SimulatorException(msg.str());
+  }
+  return listener;
+}
+
+/**
+ * @brief accept a unix socket connection
+ *
+ * Wait for and accept the next connection on a listening socket.
+ *
+ * @param listener A socket created by listenUnixSocket().
+ *
+ * @returns int The connected socket.
+ *
+ * @throws SimulatorException is thrown if accepting fails.
+ */
+int acceptUnixSocket(int listener)
+{
+  int connection = accept(listener, nullptr, nullptr);
+  while (connection < 0 and errno == EINTR)
+  {
+    connection = accept(listener, nullptr, nullptr);
+  }
+  if (connection < 0)
+  {
+    stringstream msg;
+    msg << "<acceptUnixSocket> could not accept connection: " << strerror(errno) << endl;
+    throw SimulatorException(msg.str());
+  }
+  return connection;
+}
+
+/**
+ * @brief connect to a unix socket
+ *
+ * Connect to a Unix domain stream socket listening at the given path.
+ *
+ * @param path The file system path of the socket.
+ *
+ * @returns int The connected socket.
+ *
+ * @throws SimulatorException is thrown if the connection fails.
+ */
+int connectUnixSocket(const string& path)
+{
+  sockaddr_un address;
+  unixSocketAddress(path, address);
+
+  int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ((connection < 0) or (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0))
+  {
+    if (connection >= 0)
+    {
+      close(connection);
+    }
+    stringstream msg;
+    msg << "<connectUnixSocket> could not connect to socket: " << path << " " << strerror(errno) << endl;
+    throw SimulatorException(msg.str());
+  }
+  return connection;
+}
@@ -14,13 +14,27 @@
  *
  */
 #include "State.hpp"
+#include "NeedSummaryTree.hpp"
+#include "ResourceKernels.hpp"
+#include "SafetyWorkspace.hpp"
 #include "SimulatorException.hpp"
+#include "StateProbes.hpp"
+#include "VectorOps.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstddef>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
 
 using namespace std;
 
@@ -66,7 +80,14 @@ void State::initializeState()
   {
     resourceTotal[resource] = BAD_VALUE;
     resourceAvailable[resource] = BAD_VALUE;
+    claimSum[resource] = BAD_VALUE;
   }
+
+  // an empty state has no invalid values and uses the generic kernels
+  numNegativeValues = 0;
+  numNonzeroNeeds = 0;
+  maxClaim = 0;
+  kernels = selectResourceKernels(numResources);
 }
 /**
  * @brief Check if a process's resource needs can be met
@@ -79,87 +100,837 @@ void State::initializeState()
  */
 bool State::needsAreMet(int processID, const int* currentAvaliable) const
 {
-  const int* processNeed = need[processID];
-  for (int i = 0; i < numResources; ++i)
+  return kernels->needsAreMet(numResources, need[processID], currentAvaliable);
+}
+/**
+ * @brief Find a process that can be run to completion
+ * This function searches for a process that is not yet completed
+ * and whose resource needs can be met by the currently available
+ * resources. If such a process is found, its ID is returned. If no
+ * such process is found, it returns -1.
+ *
+ * @param completed An array indicating if each process has completed.
+ * @param currentAvailable An array of available resources.
+ * @returns The ID of a process that can be run to completion, or -1 if none is found.
+ */
+int State::findCandidateProcess(bool completed[], const int currentAvaliable[]) const
+{
+  for (int process = 0; process < numProcesses; process++)
+  {
+    if ((not completed[process]) and (needsAreMet(process, currentAvaliable)))
+      return process;
+  }
+  return NO_CANDIDATE;
+}
+/**
+ * @brief Release resources allocated to a process
+ * This function adds the resources allocated to a specified process
+ * back to the pool of currently available resources.
+ *
+ * @param processId The ID of the process whose resources are being released.
+ * @param currentAvailable An array of available resources.
+ */
+void State::releaseAllocatedResources(int process, int currentAvailable[]) const
+{
+  kernels->accumulate(numResources, allocation[process], currentAvailable);
+}
+/**
+ * @brief Check if the current state is safe
+ * This function implements the Banker's algorithm to determine if the current state
+ * is safe. uses the needsAreMet(), findCandidateProcess() and
+ * releaseAllocatedResources() member functions to check for safe state.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool State::isSafe() const
+{
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  bool completed[MAX_PROCESSES] = {false};
+  STATE_PROBE(safety_start, NO_CANDIDATE, numProcesses, numResources, 0);
+
+  bool possible = true;
+  int iteration = 0;
+  while (possible)
+  {
+    int candidateProcess = findCandidateProcess(completed, currentAvailable);
+    if (candidateProcess != NO_CANDIDATE)
+    {
+      STATE_PROBE(safety_candidate, candidateProcess, numProcesses, numResources, iteration);
+      releaseAllocatedResources(candidateProcess, currentAvailable);
+      completed[candidateProcess] = true;
+      STATE_PROBE(safety_release, candidateProcess, numProcesses, numResources, iteration);
+      iteration++;
+    }
+    else
+    {
+      possible = false;
+    }
+  }
+
+  bool safe = true;
+  for (int process = 0; process < numProcesses; process++)
+  {
+    safe = safe and completed[process];
+  }
+  STATE_PROBE_RESULT(safety_done, NO_CANDIDATE, numProcesses, numResources, iteration, safe);
+  return safe;
+}
+
+/**
+ * @brief Check if the current state is safe, with safe sequence
+ * Version of isSafe() that also returns the order in which the
+ * processes can be run to completion.  If the state is safe the
+ * sequence holds every process, otherwise it holds the processes
+ * that could complete before no further candidate was found.
+ *
+ * @param safeSequence Returns the (partial) safe sequence found,
+ *   any previous contents are replaced.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool State::isSafe(vector<int>& safeSequence) const
+{
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  bool completed[MAX_PROCESSES] = {false};
+
+  safeSequence.clear();
+  return completeSafeSequence(currentAvailable, completed, safeSequence);
+}
+
+/**
+ * @brief Check if the current state is safe, using a workspace
+ * Version of isSafe() that does all of its work in a caller supplied
+ * workspace, so it never allocates memory and only writes to the
+ * workspace.  Callers that check safety repeatedly should keep a
+ * workspace around (one per thread) and reuse it.  The (partial)
+ * safe sequence is left in the workspace.
+ *
+ * @param workspace The scratch space to use for the check.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool State::isSafe(SafetyWorkspace& workspace) const
+{
+  workspace.reset(numResources, resourceAvailable);
+  STATE_PROBE(safety_start, NO_CANDIDATE, numProcesses, numResources, 0);
+
+  int candidateProcess = findCandidateProcess(workspace);
+  while (candidateProcess != NO_CANDIDATE)
+  {
+    STATE_PROBE(safety_candidate, candidateProcess, numProcesses, numResources, workspace.sequenceLength);
+    releaseAllocatedResources(candidateProcess, workspace.currentAvailable);
+    workspace.markCompleted(candidateProcess);
+    STATE_PROBE(safety_release, candidateProcess, numProcesses, numResources, workspace.sequenceLength);
+    workspace.sequence[workspace.sequenceLength++] = candidateProcess;
+    candidateProcess = findCandidateProcess(workspace);
+  }
+
+  bool safe = workspace.sequenceLength == numProcesses;
+  STATE_PROBE_RESULT(safety_done, NO_CANDIDATE, numProcesses, numResources, workspace.sequenceLength, safe);
+  return safe;
+}
+
+/**
+ * @brief Check if the current state is safe, with unsafe certificate
+ * Version of isSafe() that also explains an unsafe verdict.  When no
+ * further candidate can be found, the resources then available and
+ * the processes that have not completed are exactly the evidence of
+ * why the state is unsafe, so instead of throwing them away we
+ * gather them into a certificate.  This costs one more pass over the
+ * needs of the blocked processes, and only when the state is unsafe.
+ *
+ * @param safeSequence Returns the (partial) safe sequence found,
+ *   any previous contents are replaced.
+ * @param certificate Returns the unsafe certificate, which has no
+ *   blocked processes if the state is safe.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool State::isSafe(vector<int>& safeSequence, UnsafeCertificate& certificate) const
+{
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  bool completed[MAX_PROCESSES] = {false};
+
+  safeSequence.clear();
+  bool safe = completeSafeSequence(currentAvailable, completed, safeSequence);
+  certifyUnsafe(currentAvailable, completed, certificate);
+  return safe;
+}
+
+/**
+ * @brief Check if the current state is safe, using a summary tree
+ * Version of isSafe() that searches for candidate processes with a
+ * minimum need summary tree, skipping whole blocks of processes
+ * that can not run instead of testing them one by one.  The tree is
+ * scratch space like a workspace, and can be reused between checks.
+ *
+ * @param tree The summary tree to use for the check.
+ * @param safeSequence Returns the (partial) safe sequence found,
+ *   any previous contents are replaced.
+ *
+ * @returns true if the state is safe, false otherwise.
+ */
+bool State::isSafe(NeedSummaryTree& tree, vector<int>& safeSequence) const
+{
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  tree.reset(*this);
+
+  safeSequence.clear();
+  int candidateProcess = tree.findCandidateProcess(currentAvailable);
+  while (candidateProcess != NO_CANDIDATE)
+  {
+    releaseAllocatedResources(candidateProcess, currentAvailable);
+    tree.markCompleted(candidateProcess);
+    safeSequence.push_back(candidateProcess);
+    candidateProcess = tree.findCandidateProcess(currentAvailable);
+  }
+
+  return static_cast<int>(safeSequence.size()) == numProcesses;
+}
+
+/**
+ * @brief certify unsafe
+ * Gather the unsafe certificate of a safety check that has stopped
+ * because no further candidate process could be found.  Every
+ * process that has not completed is blocked, and is short of at
+ * least one resource.  Resources are ranked by the number of blocked
+ * processes they hold back, ties are ranked by resource number.
+ *
+ * @param currentAvailable The resources available when the check
+ *   stopped.
+ * @param completed The processes that completed before the check
+ *   stopped.
+ * @param certificate Returns the unsafe certificate, any previous
+ *   contents are replaced.
+ */
+void State::certifyUnsafe(const int currentAvailable[], const bool completed[], UnsafeCertificate& certificate) const
+{
+  certificate.available.assign(currentAvailable, currentAvailable + numResources);
+  certificate.blockedProcesses.clear();
+  certificate.shortfall.clear();
+  certificate.blockedCount.assign(numResources, 0);
+  certificate.bottleneckResources.clear();
+
+  const int noShortfall[MAX_RESOURCES] = {0};
+  for (int process = 0; process < numProcesses; process++)
+  {
+    if (completed[process])
+    {
+      continue;
+    }
+
+    certificate.blockedProcesses.push_back(process);
+    int shortfall[MAX_RESOURCES];
+    vectorSubtract(numResources, need[process], currentAvailable, shortfall);
+    vectorMax(numResources, shortfall, noShortfall, shortfall);
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      certificate.shortfall.push_back(shortfall[resource]);
+      certificate.blockedCount[resource] += (shortfall[resource] > 0);
+    }
+  }
+
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    if (certificate.blockedCount[resource] > 0)
+    {
+      certificate.bottleneckResources.push_back(resource);
+    }
+  }
+  stable_sort(certificate.bottleneckResources.begin(), certificate.bottleneckResources.end(),
+    [&certificate](int first, int second) { return certificate.blockedCount[first] > certificate.blockedCount[second]; });
+}
+
+/**
+ * @brief Find a candidate process, using a workspace
+ * Version of findCandidateProcess() using the completed bitmap of a
+ * workspace.  We walk the bitmap a word at a time, only looking at
+ * the processes of a word that have not completed yet, so runs of
+ * completed processes are skipped 64 at a time.
+ *
+ * @param workspace The workspace holding the completed bitmap and
+ *   the current available resources.
+ *
+ * @returns The lowest numbered process that has not completed and
+ *   whose needs can be met, or NO_CANDIDATE if there is none.
+ */
+int State::findCandidateProcess(const SafetyWorkspace& workspace) const
+{
+  for (int word = 0; word * BITMAP_WORD_BITS < numProcesses; word++)
+  {
+    uint64_t remaining = ~workspace.completed[word];
+    int processesInWord = numProcesses - word * BITMAP_WORD_BITS;
+    if (processesInWord < BITMAP_WORD_BITS)
+    {
+      remaining &= (uint64_t(1) << processesInWord) - 1;
+    }
+
+    while (remaining != 0)
+    {
+      int process = word * BITMAP_WORD_BITS + __builtin_ctzll(remaining);
+      if (needsAreMet(process, workspace.currentAvailable))
+      {
+        return process;
+      }
+      remaining &= remaining - 1;
+    }
+  }
+  return NO_CANDIDATE;
+}
+
+/**
+ * @brief complete a safe sequence
+ * Continue the Banker's algorithm from a partial safe sequence,
+ * where the processes marked as completed have already released
+ * their allocations into currentAvailable.  Since releasing
+ * resources can never make a candidate process unrunnable, any
+ * valid partial sequence can be completed if and only if the state
+ * is safe.
+ *
+ * @param currentAvailable The resources available after the partial
+ *   sequence has completed, updated as further processes complete.
+ * @param completed The processes completed by the partial sequence,
+ *   updated as further processes complete.
+ * @param safeSequence The partial safe sequence, further processes
+ *   are appended as they complete.
+ *
+ * @returns true if all processes can complete, false otherwise.
+ */
+bool State::completeSafeSequence(int currentAvailable[], bool completed[], vector<int>& safeSequence) const
+{
+  STATE_PROBE(safety_start, NO_CANDIDATE, numProcesses, numResources, safeSequence.size());
+  int candidateProcess = findCandidateProcess(completed, currentAvailable);
+  while (candidateProcess != NO_CANDIDATE)
+  {
+    STATE_PROBE(safety_candidate, candidateProcess, numProcesses, numResources, safeSequence.size());
+    releaseAllocatedResources(candidateProcess, currentAvailable);
+    completed[candidateProcess] = true;
+    STATE_PROBE(safety_release, candidateProcess, numProcesses, numResources, safeSequence.size());
+    safeSequence.push_back(candidateProcess);
+    candidateProcess = findCandidateProcess(completed, currentAvailable);
+  }
+
+  bool safe = static_cast<int>(safeSequence.size()) == numProcesses;
+  STATE_PROBE_RESULT(safety_done, NO_CANDIDATE, numProcesses, numResources, safeSequence.size(), safe);
+  return safe;
+}
+
+/**
+ * @brief request resources
+ *
+ * Resource Allocation Denial admission of a resource request by a
+ * process.  The request is tentatively granted, and the grant is
+ * kept only if the resulting state is safe.  Otherwise, or if not
+ * enough resources are available right now, the request is denied
+ * and the state is left unchanged, the process has to wait and
+ * request again later.
+ *
+ * Processes admitted under Process Initiation Denial can never
+ * deadlock, so under that policy the safety check is skipped and
+ * a request is granted whenever enough resources are available.
+ *
+ * @param process The process making the request.
+ * @param request The number of each resource requested.
+ * @param policy The admission policy the process runs under.
+ *
+ * @returns bool true if the request was granted, false if denied.
+ *
+ * @throws SimulatorException is thrown if the process does not
+ *   exist, or requests more than its remaining need (its claim).
+ */
+bool State::requestResources(int process, const int request[], AdmissionPolicy policy)
+{
+  if ((process < 0) or (process >= numProcesses))
   {
-    if (processNeed[i] > currentAvaliable[i])
+    stringstream msg;
+    msg << "<State::requestResources> no such process P" << process << endl;
+    throw SimulatorException(msg.str());
+  }
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    if ((request[resource] < 0) or (request[resource] > need[process][resource]))
+    {
+      stringstream msg;
+      msg << "<State::requestResources> P" << process << " request of " << request[resource] << " R" << resource
+          << " exceeds its need of " << need[process][resource] << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+  if (not kernels->needsAreMet(numResources, request, resourceAvailable))
+  {
+    STATE_PROBE_RESULT(admission_request, process, numProcesses, numResources, 0, false);
+    return false;
+  }
+
+  // tentatively grant the request, and keep it if we are still safe
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    numNonzeroNeeds -= (need[process][resource] != 0);
+    allocation[process][resource] += request[resource];
+    need[process][resource] -= request[resource];
+    resourceAvailable[resource] -= request[resource];
+    numNonzeroNeeds += (need[process][resource] != 0);
+  }
+  if ((policy == PROCESS_INITIATION_DENIAL) or isSafe())
+  {
+    STATE_PROBE_RESULT(admission_request, process, numProcesses, numResources, 0, true);
+    return true;
+  }
+
+  releaseResources(process, request);
+  STATE_PROBE_RESULT(admission_request, process, numProcesses, numResources, 0, false);
+  return false;
+}
+
+/**
+ * @brief release resources
+ *
+ * A process releases some (or all) of the resources allocated to it
+ * back to the system.  Releasing resources can never make a safe
+ * state unsafe, so no check is needed.
+ *
+ * @param process The process releasing resources.
+ * @param release The number of each resource released.
+ *
+ * @throws SimulatorException is thrown if the process does not
+ *   exist, or releases more than is allocated to it.
+ */
+void State::releaseResources(int process, const int release[])
+{
+  if ((process < 0) or (process >= numProcesses))
+  {
+    stringstream msg;
+    msg << "<State::releaseResources> no such process P" << process << endl;
+    throw SimulatorException(msg.str());
+  }
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    if ((release[resource] < 0) or (release[resource] > allocation[process][resource]))
+    {
+      stringstream msg;
+      msg << "<State::releaseResources> P" << process << " release of " << release[resource] << " R" << resource
+          << " exceeds its allocation of " << allocation[process][resource] << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    numNonzeroNeeds -= (need[process][resource] != 0);
+    allocation[process][resource] -= release[resource];
+    need[process][resource] += release[resource];
+    resourceAvailable[resource] += release[resource];
+    numNonzeroNeeds += (need[process][resource] != 0);
+  }
+}
+
+/**
+ * @brief can initiate process
+ *
+ * Process Initiation Denial admission test.  A new process may only
+ * be started if the claims of all current processes plus its own
+ * claims fit in the total resources, for every resource.  Then even
+ * if every process asks for its full claim at once they can all be
+ * satisfied, so deadlock is impossible and no further checks are
+ * needed when resources are requested.  Since the claim column sums
+ * are kept up to date, the test costs O(m) for m resources.
+ *
+ * Under Resource Allocation Denial a process may be started as long
+ * as its own claims fit in the total resources, the requests it
+ * makes are checked instead.
+ *
+ * @param processClaim The claim of each resource by the new process.
+ * @param policy The admission policy to test under.
+ *
+ * @returns bool true if the process can be initiated.
+ */
+bool State::canInitiateProcess(const int processClaim[], AdmissionPolicy policy) const
+{
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    int claimed = (policy == PROCESS_INITIATION_DENIAL) ? claimSum[resource] : 0;
+    if ((processClaim[resource] < 0) or (claimed + processClaim[resource] > resourceTotal[resource]))
     {
       return false;
     }
   }
   return true;
 }
+
+/**
+ * @brief initiate process
+ *
+ * Start a new process, by default under Process Initiation Denial.
+ * If it is admitted, the process is added as the last row of the
+ * state with nothing allocated, so its need is its claim.
+ *
+ * @param processClaim The claim of each resource by the new process.
+ * @param policy The admission policy to initiate the process under.
+ *
+ * @returns int The number of the new process, or NO_CANDIDATE if
+ *   initiating it was denied.
+ *
+ * @throws SimulatorException is thrown if the state already holds
+ *   the maximum number of processes we can handle.
+ */
+int State::initiateProcess(const int processClaim[], AdmissionPolicy policy)
+{
+  if (numProcesses >= MAX_PROCESSES)
+  {
+    stringstream msg;
+    msg << "<State::initiateProcess> maximum exceeded, can not initiate more than " << MAX_PROCESSES << " processes"
+        << endl;
+    throw SimulatorException(msg.str());
+  }
+  if (not canInitiateProcess(processClaim, policy))
+  {
+    STATE_PROBE_RESULT(admission_initiate, NO_CANDIDATE, numProcesses, numResources, 0, false);
+    return NO_CANDIDATE;
+  }
+
+  int process = numProcesses++;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    claim[process][resource] = processClaim[resource];
+    allocation[process][resource] = 0;
+    need[process][resource] = processClaim[resource];
+    claimSum[resource] += processClaim[resource];
+    numNonzeroNeeds += (processClaim[resource] != 0);
+    maxClaim = max(maxClaim, processClaim[resource]);
+  }
+  STATE_PROBE_RESULT(admission_initiate, process, numProcesses, numResources, 0, true);
+  return process;
+}
+
+/**
+ * @brief terminate process
+ *
+ * Remove a process from the state, its allocated resources become
+ * available again and its claims no longer count against the
+ * admission of new processes.  To keep this O(m) the last process
+ * is moved into the row of the terminated process, and so takes
+ * its process number.
+ *
+ * @param process The process to terminate.
+ *
+ * @throws SimulatorException is thrown if the process does not exist.
+ */
+void State::terminateProcess(int process)
+{
+  if ((process < 0) or (process >= numProcesses))
+  {
+    stringstream msg;
+    msg << "<State::terminateProcess> process out of bounds P" << process << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int last = --numProcesses;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    numNegativeValues -= (need[process][resource] < 0) + (resourceAvailable[resource] < 0);
+    numNonzeroNeeds -= (need[process][resource] != 0);
+    resourceAvailable[resource] += allocation[process][resource];
+    numNegativeValues += (resourceAvailable[resource] < 0);
+    claimSum[resource] -= claim[process][resource];
+    claim[process][resource] = claim[last][resource];
+    allocation[process][resource] = allocation[last][resource];
+    need[process][resource] = need[last][resource];
+    claim[last][resource] = allocation[last][resource] = need[last][resource] = BAD_VALUE;
+  }
+}
+
+/**
+ * @brief difference of two states
+ *
+ * Compute the sparse difference between this state and another
+ * state of the same shape, e.g. the next snapshot of the same
+ * system.  Applying the resulting delta to this state with
+ * applyDelta() gives a state equal to the other state.
+ *
+ * @param other The (newer) state to compare this state to.
+ *
+ * @returns StateDelta The claim/allocation cells and resource
+ *   totals that differ, as other - this.
+ *
+ * @throws SimulatorException is thrown if the states have a
+ *   different number of processes or resources.
+ */
+StateDelta State::diff(const State& other) const
+{
+  if ((numProcesses != other.numProcesses) or (numResources != other.numResources))
+  {
+    stringstream msg;
+    msg << "<State::diff> can only diff states of the same shape, "
+        << numProcesses << "x" << numResources << " != " << other.numProcesses << "x" << other.numResources << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  StateDelta delta;
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      int claimDelta = other.claim[process][resource] - claim[process][resource];
+      int allocationDelta = other.allocation[process][resource] - allocation[process][resource];
+      if ((claimDelta != 0) or (allocationDelta != 0))
+      {
+        delta.cells.push_back({process, resource, claimDelta, allocationDelta});
+      }
+    }
+  }
+
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    int totalDelta = other.resourceTotal[resource] - resourceTotal[resource];
+    if (totalDelta != 0)
+    {
+      delta.totals.push_back({resource, totalDelta});
+    }
+  }
+
+  return delta;
+}
+
+/**
+ * @brief apply a state delta
+ *
+ * Update this state by a delta computed by diff().  The need and
+ * available information is updated incrementally for just the
+ * changed cells, rather than inferred again from scratch.  The whole
+ * delta is checked before anything is changed, so a delta that is
+ * rejected leaves the state untouched.
+ *
+ * @param delta The changes to apply to this state.
+ *
+ * @throws SimulatorException is thrown if the delta refers to a
+ *   process or resource this state does not have.
+ */
+void State::applyDelta(const StateDelta& delta)
+{
+  for (const CellDelta& cell : delta.cells)
+  {
+    if ((cell.process < 0) or (cell.process >= numProcesses) or (cell.resource < 0) or (cell.resource >= numResources))
+    {
+      stringstream msg;
+      msg << "<State::applyDelta> delta cell out of bounds P" << cell.process << " R" << cell.resource << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+  for (const TotalDelta& total : delta.totals)
+  {
+    if ((total.resource < 0) or (total.resource >= numResources))
+    {
+      stringstream msg;
+      msg << "<State::applyDelta> delta total out of bounds R" << total.resource << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+
+  for (const CellDelta& cell : delta.cells)
+  {
+    int& processNeed = need[cell.process][cell.resource];
+    int& available = resourceAvailable[cell.resource];
+    numNegativeValues -= (processNeed < 0) + (available < 0);
+    numNonzeroNeeds -= (processNeed != 0);
+
+    claim[cell.process][cell.resource] += cell.claimDelta;
+    maxClaim = max(maxClaim, claim[cell.process][cell.resource]);
+    claimSum[cell.resource] += cell.claimDelta;
+    allocation[cell.process][cell.resource] += cell.allocationDelta;
+    processNeed += cell.claimDelta - cell.allocationDelta;
+    available -= cell.allocationDelta;
+
+    numNegativeValues += (processNeed < 0) + (available < 0);
+    numNonzeroNeeds += (processNeed != 0);
+  }
+
+  for (const TotalDelta& total : delta.totals)
+  {
+    int& available = resourceAvailable[total.resource];
+    numNegativeValues -= (available < 0);
+    resourceTotal[total.resource] += total.delta;
+    available += total.delta;
+    numNegativeValues += (available < 0);
+  }
+}
+
+/**
+ * @brief apply a state delta and reevaluate safety
+ *
+ * Update this state by a delta computed by diff() as applyDelta()
+ * does, and determine if the updated state is safe.
+ *
+ * The safe sequence found for the previous state is revalidated
+ * instead of being searched for again.  If no resource availability
+ * shrank, every process in the previous sequence before the first
+ * affected process can still run, so needs are only checked again
+ * from there on.  If the old sequence breaks, the search continues
+ * from the last process that could still complete.
+ *
+ * @param delta The changes to apply to this state.
+ * @param safeSequence On input the (partial) safe sequence of the
+ *   state before the delta, as returned by isSafe().  Returns the
+ *   (partial) safe sequence of the updated state.
+ *
+ * @returns true if the updated state is safe, false otherwise.
+ *
+ * @throws SimulatorException is thrown if the delta refers to a
+ *   process or resource this state does not have.
+ */
+bool State::applyDelta(const StateDelta& delta, vector<int>& safeSequence)
+{
+  applyDelta(delta);
+
+  // find the processes whose needs changed, and if any of the
+  // resources available to the previous sequence shrank
+  bool affected[MAX_PROCESSES] = {false};
+  bool availableShrank = false;
+  for (const CellDelta& cell : delta.cells)
+  {
+    affected[cell.process] = true;
+    availableShrank |= (cell.allocationDelta > 0);
+  }
+  for (const TotalDelta& total : delta.totals)
+  {
+    availableShrank |= (total.delta < 0);
+  }
+
+  return revalidateSafeSequence(affected, availableShrank, safeSequence);
+}
+
 /**
- * @brief Find a process that can be run to completion
- * This function searches for a process that is not yet completed
- * and whose resource needs can be met by the currently available
- * resources. If such a process is found, its ID is returned. If no
- * such process is found, it returns -1.
+ * @brief revalidate safe sequence
  *
- * @param completed An array indicating if each process has completed.
- * @param currentAvailable An array of available resources.
- * @returns The ID of a process that can be run to completion, or -1 if none is found.
+ * Replay a safe sequence found before the state changed as far as it
+ * is still valid, and continue the search from there.  Needs are
+ * only checked again from the first affected process on, or from the
+ * start if some resource availability shrank.
+ *
+ * @param affected Whether the needs of each process changed.
+ * @param availableShrank Whether the available count of some
+ *   resource shrank.
+ * @param safeSequence On input the (partial) safe sequence of the
+ *   state before the change.  Returns the (partial) safe sequence of
+ *   the changed state.
+ *
+ * @returns true if the changed state is safe, false otherwise.
  */
-int State::findCandidateProcess(bool completed[], const int currentAvaliable[]) const
+bool State::revalidateSafeSequence(const bool affected[], bool availableShrank, vector<int>& safeSequence) const
 {
-  for (int process = 0; process < numProcesses; process++)
+  int currentAvailable[MAX_RESOURCES];
+  kernels->copy(numResources, resourceAvailable, currentAvailable);
+  bool completed[MAX_PROCESSES] = {false};
+  vector<int> previousSequence;
+  previousSequence.swap(safeSequence);
+
+  bool checkNeeds = availableShrank;
+  for (int process : previousSequence)
   {
-    if ((not completed[process]) and (needsAreMet(process, currentAvaliable)))
-      return process;
+    if ((process < 0) or (process >= numProcesses) or completed[process])
+    {
+      break;
+    }
+    checkNeeds |= affected[process];
+    if (checkNeeds and not needsAreMet(process, currentAvailable))
+    {
+      break;
+    }
+    releaseAllocatedResources(process, currentAvailable);
+    completed[process] = true;
+    safeSequence.push_back(process);
   }
-  return NO_CANDIDATE;
+
+  return completeSafeSequence(currentAvailable, completed, safeSequence);
 }
+
 /**
- * @brief Release resources allocated to a process
- * This function adds the resources allocated to a specified process
- * back to the pool of currently available resources.
+ * @brief adjust capacity
  *
- * @param processId The ID of the process whose resources are being released.
- * @param currentAvailable An array of available resources.
+ * Grow or shrink the total of a resource online, as when a cluster
+ * gains or loses capacity.  Allocations are untouched, so the
+ * available count changes by the same amount, in O(1).
+ *
+ * @param resource The resource whose total changes.
+ * @param delta The change of the total, new total - old total.
+ *
+ * @throws SimulatorException is thrown if the resource does not
+ *   exist, or its total would become negative.
  */
-void State::releaseAllocatedResources(int process, int currentAvailable[]) const
+void State::adjustCapacity(int resource, int delta)
 {
-  for (int resource = 0; resource < numResources; resource++)
+  if ((resource < 0) or (resource >= numResources) or (resourceTotal[resource] + delta < 0))
   {
-    currentAvailable[resource] += allocation[process][resource];
+    stringstream msg;
+    msg << "<State::adjustCapacity> can not adjust R" << resource << " by " << delta << endl;
+    throw SimulatorException(msg.str());
   }
+
+  int& available = resourceAvailable[resource];
+  numNegativeValues -= (available < 0);
+  resourceTotal[resource] += delta;
+  available += delta;
+  numNegativeValues += (available < 0);
 }
+
 /**
- * @brief Check if the current state is safe
- * This function implements the Banker's algorithm to determine if the current state
- * is safe. uses the needsAreMet(), findCandidateProcess() and
- * releaseAllocatedResources() member functions to check for safe state.
+ * @brief adjust capacity and reevaluate safety
  *
- * @returns true if the state is safe, false otherwise.
+ * Grow or shrink the total of a resource as adjustCapacity() does,
+ * and determine if the state is still safe.
+ *
+ * Growing a resource only adds to what is available at every step
+ * of the previous safe sequence, so a complete safe sequence stays
+ * valid and we are done.  Otherwise the previous sequence is
+ * revalidated as applyDelta() does, and the search continues from
+ * where it breaks.  When shrinking, processes whose claim of the
+ * resource fit the old total but exceeds the new one can never be
+ * given their full claim again, and are reported so the caller can
+ * decide what to do with them.
+ *
+ * @param resource The resource whose total changes.
+ * @param delta The change of the total, new total - old total.
+ * @param safeSequence On input the (partial) safe sequence of the
+ *   state before the change, as returned by isSafe().  Returns the
+ *   (partial) safe sequence of the updated state.
+ * @param infeasibleProcesses Returns the processes whose claim has
+ *   just become larger than the total of the resource.
+ *
+ * @returns true if the updated state is safe, false otherwise.
+ *
+ * @throws SimulatorException is thrown if the resource does not
+ *   exist, or its total would become negative.
  */
-bool State::isSafe() const
+bool State::adjustCapacity(int resource, int delta, vector<int>& safeSequence, vector<int>& infeasibleProcesses)
 {
-  int currentAvailable[MAX_RESOURCES];
-  copyVector(numResources, resourceAvailable, currentAvailable);
-  bool completed[MAX_PROCESSES] = {false};
+  adjustCapacity(resource, delta);
 
-  bool possible = true;
-  while (possible)
+  infeasibleProcesses.clear();
+  if (delta >= 0)
   {
-    int candidateProcess = findCandidateProcess(completed, currentAvailable);
-    if (candidateProcess != NO_CANDIDATE)
-    {
-      releaseAllocatedResources(candidateProcess, currentAvailable);
-      completed[candidateProcess] = true;
-    }
-    else
+    if (safeSequence.size() == static_cast<size_t>(numProcesses))
     {
-      possible = false;
+      return true;
     }
   }
-  for (int process = 0; process < numProcesses; process++)
+  else
   {
-    if (not completed[process])
+    int total = resourceTotal[resource];
+    for (int process = 0; process < numProcesses; process++)
     {
-      return false;
+      if ((claim[process][resource] > total) and (claim[process][resource] <= total - delta))
+      {
+        infeasibleProcesses.push_back(process);
+      }
     }
   }
-  return true;
+
+  // no need changed, only what is available
+  bool affected[MAX_PROCESSES] = {false};
+  return revalidateSafeSequence(affected, delta < 0, safeSequence);
 }
 
 /**
@@ -192,6 +963,141 @@ int State::getNumProcesses() const
   return numProcesses;
 }
 
+/**
+ * @brief number of negative values accessor
+ *
+ * Constant accessor method to get the number of negative need
+ * entries and negative available resources that were found the
+ * last time the state information was inferred.  This should be 0
+ * for a valid state.
+ *
+ * @returns int The number of negative need and available values.
+ */
+int State::getNumNegativeValues() const
+{
+  return numNegativeValues;
+}
+
+/**
+ * @brief claim accessor
+ *
+ * Constant accessor method to get the maximum claim of a process
+ * for a resource.
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The claim of the process for the resource.
+ */
+int State::getClaim(int process, int resource) const
+{
+  return claim[process][resource];
+}
+
+/**
+ * @brief allocation accessor
+ *
+ * Constant accessor method to get the current allocation of a
+ * resource to a process.
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The allocation of the resource to the process.
+ */
+int State::getAllocation(int process, int resource) const
+{
+  return allocation[process][resource];
+}
+
+/**
+ * @brief need accessor
+ *
+ * Constant accessor method to get the current need of a
+ * process for a resource.
+ *
+ * @param process The process (row) to look up.
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The need of the process for the resource.
+ */
+int State::getNeed(int process, int resource) const
+{
+  return need[process][resource];
+}
+
+/**
+ * @brief resource total accessor
+ *
+ * Constant accessor method to get the total number of a resource
+ * present in the system.
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The total of the resource.
+ */
+int State::getResourceTotal(int resource) const
+{
+  return resourceTotal[resource];
+}
+
+/**
+ * @brief resource available accessor
+ *
+ * Constant accessor method to get the number of a resource
+ * that is currently available (unallocated).
+ *
+ * @param resource The resource to look up.
+ *
+ * @returns int The available amount of the resource.
+ */
+int State::getResourceAvailable(int resource) const
+{
+  return resourceAvailable[resource];
+}
+
+/**
+ * @brief claim sum accessor
+ *
+ * Constant accessor method to get the sum of the claims of all
+ * processes for a resource.
+ *
+ * @param resource The resource (column) to look up.
+ *
+ * @returns int The claim column sum of the resource.
+ */
+int State::getClaimSum(int resource) const
+{
+  return claimSum[resource];
+}
+
+/**
+ * @brief nonzero needs accessor
+ *
+ * Constant accessor method to get the number of nonzero need entries,
+ * kept up to date as needs change.
+ *
+ * @returns int The number of nonzero needs.
+ */
+int State::getNumNonzeroNeeds() const
+{
+  return numNonzeroNeeds;
+}
+
+/**
+ * @brief largest claim accessor
+ *
+ * Constant accessor method to get the largest claim found the last
+ * time the state information was inferred, or any larger claim made
+ * since.
+ *
+ * @returns int The largest claim, 0 if there are no positive claims.
+ */
+int State::getMaxClaim() const
+{
+  return maxClaim;
+}
+
 /**
  * @brief load state from file
  *
@@ -228,12 +1134,16 @@ int State::getNumProcesses() const
  *
  * @param filename A string with the name of a file to open and
  *   read in the system state information.
+ * @param strict If true the loaded state is validated, and
+ *   loading fails on the first violation found, leaving an empty
+ *   state.  By default states are loaded without being validated.
  *
  * @throws SimulatorException is thrown if file is not found, or
  *   if file cannot be parsed because it is malformed or missing
- *   values at expected locations during read of file.
+ *   values at expected locations during read of file.  In strict
+ *   mode it is also thrown if the loaded state is not valid.
  */
-void State::loadState(string filename)
+void State::loadState(string filename, bool strict)
 {
   ifstream simfile(filename);
 
@@ -249,6 +1159,7 @@ void State::loadState(string filename)
 
   // make sure state is completely clean before load, just to be safe
   initializeState();
+  STATE_PROBE(load_start, NO_CANDIDATE, numProcesses, numResources, 0);
 
   // start by going to the line containing the number of
   // processes and resources and read them in
@@ -259,90 +1170,456 @@ void State::loadState(string filename)
   // we can handle
   if ((numProcesses > MAX_PROCESSES) or (numResources > MAX_RESOURCES))
   {
-    stringstream msg;
-    msg << "<State::loadState> maximum exceeded, requested"
-        << " numProcesses = " << numProcesses << " numResources = " << numResources << endl
-        << " maximum = " << MAX_PROCESSES << ", " << MAX_RESOURCES << endl;
-    throw SimulatorException(msg.str());
+    stringstream msg;
+    msg << "<State::loadState> maximum exceeded, requested"
+        << " numProcesses = " << numProcesses << " numResources = " << numResources << endl
+        << " maximum = " << MAX_PROCESSES << ", " << MAX_RESOURCES << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  // Now go to the lines holding the total system resources and
+  // read in the total resources
+  skipComments(simfile);
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    simfile >> resourceTotal[resource];
+  }
+
+  // Now go to the lines holding the process/system claims and read
+  // in the claims
+  skipComments(simfile);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      simfile >> claim[process][resource];
+    }
+  }
+
+  // Now go to the lines holding the process/system current
+  // allocations and read in the allocations
+  skipComments(simfile);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      simfile >> allocation[process][resource];
+    }
+  }
+
+  // now infer the need and available resources from the
+  // current state information
+  inferStateInformation();
+
+  // close the opened file before returning
+  simfile.close();
+  STATE_PROBE(load_done, NO_CANDIDATE, numProcesses, numResources, 0);
+
+  // in strict mode refuse to keep a state that would give meaningless
+  // verdicts, reporting the first violation found and leaving the
+  // state empty
+  if (strict)
+  {
+    vector<StateViolation> violations = validateState(true);
+    if (not violations.empty())
+    {
+      initializeState();
+      stringstream msg;
+      msg << "<State::loadState> invalid state in file: " << filename << endl
+          << " " << violationToString(violations[0]) << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+}
+
+/**
+ * @brief load allocation snapshot
+ *
+ * Load the next allocation-only snapshot from a stream of them, as
+ * exported by monitoring, where the claims and total resources of
+ * the system are already loaded and rarely change.  A snapshot is
+ * just the allocation matrix, numProcesses rows of numResources
+ * values, optionally preceeded by comment lines.  The allocations are
+ * read into a fixed size buffer, and only once the whole snapshot has
+ * been read are they copied into the allocation matrix and the need
+ * and available information inferred again in place against the
+ * cached claims.  So a stream of any length is evaluated with
+ * constant memory, and a truncated or malformed snapshot leaves the
+ * state as it was.
+ *
+ * @param snapshots The stream of snapshots to read the next one from.
+ *
+ * @returns bool true if a snapshot was loaded, false if the stream
+ *   has no more snapshots.
+ *
+ * @throws SimulatorException is thrown if the stream ends part way
+ *   through a snapshot or holds something other than a number.
+ */
+bool State::loadAllocationSnapshot(istream& snapshots)
+{
+  // at the end of the stream skipping comments fails, or leaves
+  // nothing but whitespace before the end
+  skipComments(snapshots);
+  snapshots >> ws;
+  if (snapshots.fail() or snapshots.eof())
+  {
+    return false;
+  }
+
+  int snapshot[MAX_PROCESSES][MAX_RESOURCES];
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      if (not(snapshots >> snapshot[process][resource]))
+      {
+        stringstream msg;
+        msg << "<State::loadAllocationSnapshot> truncated or malformed allocation snapshot at"
+            << " process = " << process << " resource = " << resource << endl;
+        throw SimulatorException(msg.str());
+      }
+    }
+  }
+
+  for (int process = 0; process < numProcesses; process++)
+  {
+    copyVector(numResources, snapshot[process], allocation[process]);
+  }
+  inferStateInformation();
+  return true;
+}
+
+/**
+ * @brief load state from memory
+ *
+ * Load the system state from values already in memory, rather
+ * than parsing them from a simulation file, e.g. when decoding a
+ * state from a binary archive.  The need and available information
+ * is then inferred as for a state loaded from a file.
+ *
+ * @param numProcesses The number of processes in the system.
+ * @param numResources The number of resource types in the system.
+ * @param total The total resource vector, numResources values.
+ * @param claims The claim matrix in row major order, numProcesses
+ *   times numResources values.
+ * @param allocations The allocation matrix in row major order,
+ *   numProcesses times numResources values.
+ *
+ * @throws SimulatorException is thrown if the shape exceeds the
+ *   maximum we can handle or does not match the sizes of the
+ *   given vector and matrices.
+ */
+void State::loadState(int numProcesses, int numResources, const vector<int>& total, const vector<int>& claims,
+  const vector<int>& allocations)
+{
+  size_t numCells = static_cast<size_t>(numProcesses) * numResources;
+  if ((numProcesses < 0) or (numResources < 0) or (numProcesses > MAX_PROCESSES) or (numResources > MAX_RESOURCES) or
+      (total.size() != static_cast<size_t>(numResources)) or (claims.size() != numCells) or (allocations.size() != numCells))
+  {
+    stringstream msg;
+    msg << "<State::loadState> invalid shape, requested"
+        << " numProcesses = " << numProcesses << " numResources = " << numResources << endl
+        << " maximum = " << MAX_PROCESSES << ", " << MAX_RESOURCES << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  initializeState();
+  STATE_PROBE(load_start, NO_CANDIDATE, numProcesses, numResources, 0);
+  this->numProcesses = numProcesses;
+  this->numResources = numResources;
+
+  copyVector(numResources, total.data(), resourceTotal);
+  for (int process = 0; process < numProcesses; process++)
+  {
+    copyVector(numResources, &claims[process * numResources], claim[process]);
+    copyVector(numResources, &allocations[process * numResources], allocation[process]);
+  }
+
+  inferStateInformation();
+  STATE_PROBE(load_done, NO_CANDIDATE, numProcesses, numResources, 0);
+}
+
+/**
+ * @brief infer state informaton
+ *
+ * When we load state information from a file, we are only
+ * given the minimal necessary information.  We need to infer
+ * the process needs from the given claim and allocation information,
+ * and we need to infer the available resources given the
+ * total resources and the current allocation of resources.
+ *
+ * While we sweep the matrices we also count any negative needs
+ * or negative available resources, which indicate an invalid state.
+ * A state has at most MAX_PROCESSES x MAX_RESOURCES cells, far too
+ * few for starting threads to pay off, so this is always done
+ * serially.
+ */
+void State::inferStateInformation()
+{
+  STATE_PROBE(infer_start, NO_CANDIDATE, numProcesses, numResources, 0);
+
+  // need = claim - allocation, and sum up the current allocations of
+  // each resource, in a single pass over the rows of the matrices
+  int allocationSum[MAX_RESOURCES] = {0};
+  int totalClaimSum[MAX_RESOURCES] = {0};
+  int claimMax[MAX_RESOURCES] = {0};
+  int nonzeroNeeds = 0;
+  int negativeNeeds = inferRows(0, numProcesses, allocationSum, totalClaimSum, claimMax, nonzeroNeeds);
+
+  // resourceAvailable = resourceTotal - (sum of current allocations)
+  inferAvailable(allocationSum, totalClaimSum, negativeNeeds, claimMax, nonzeroNeeds);
+  STATE_PROBE_RESULT(infer_done, NO_CANDIDATE, numProcesses, numResources, 0, numNegativeValues);
+}
+
+/**
+ * @brief infer state information in parallel
+ *
+ * Parallel version of inferStateInformation().  The process rows are
+ * partitioned into contiguous ranges, one for each thread.  Each
+ * thread infers the need for its rows and sums up the allocations of
+ * its rows into its own partial column sums, these are then reduced
+ * into the resource available vector once all threads are done.
+ * The calling thread infers the first range itself, and should a
+ * thread fail to start, the threads already started are joined
+ * before the failure is passed on.  This is never chosen
+ * automatically, callers that want the work split across threads
+ * ask for it explicitly.
+ *
+ * @param numThreads The number of threads to partition the process
+ *   rows across.  We never use more threads than there are processes.
+ */
+void State::inferStateInformationParallel(int numThreads)
+{
+  STATE_PROBE(infer_start, NO_CANDIDATE, numProcesses, numResources, 0);
+  if (numThreads > numProcesses)
+  {
+    numThreads = numProcesses;
+  }
+  if (numThreads < 1)
+  {
+    numThreads = 1;
   }
 
-  // Now go to the lines holding the total system resources and
-  // read in the total resources
-  skipComments(simfile);
-  for (int resource = 0; resource < numResources; resource++)
+  // each thread gets its own partial allocation sums and counts of
+  // negative and nonzero needs, so no synchronization is needed until
+  // the reduction
+  vector<vector<int>> partialSums(numThreads, vector<int>(numResources, 0));
+  vector<vector<int>> partialClaimSums(numThreads, vector<int>(numResources, 0));
+  vector<vector<int>> partialClaimMax(numThreads, vector<int>(numResources, 0));
+  vector<int> partialNegatives(numThreads, 0);
+  vector<int> partialNonzeros(numThreads, 0);
+  vector<int> beginProcesses(numThreads + 1, 0);
+  int rowsPerThread = numProcesses / numThreads;
+  int extraRows = numProcesses % numThreads;
+  for (int worker = 0; worker < numThreads; worker++)
   {
-    simfile >> resourceTotal[resource];
+    beginProcesses[worker + 1] = beginProcesses[worker] + rowsPerThread + (worker < extraRows ? 1 : 0);
   }
+  auto inferRange = [&](int worker) {
+    partialNegatives[worker] = inferRows(beginProcesses[worker], beginProcesses[worker + 1], partialSums[worker].data(),
+      partialClaimSums[worker].data(), partialClaimMax[worker].data(), partialNonzeros[worker]);
+  };
 
-  // Now go to the lines holding the process/system claims and read
-  // in the claims
-  skipComments(simfile);
-  for (int process = 0; process < numProcesses; process++)
+  vector<thread> workers;
+  workers.reserve(numThreads);
+  try
   {
-    for (int resource = 0; resource < numResources; resource++)
+    for (int worker = 1; worker < numThreads; worker++)
     {
-      simfile >> claim[process][resource];
+      workers.push_back(thread(inferRange, worker));
+    }
+  }
+  catch (...)
+  {
+    for (thread& worker : workers)
+    {
+      worker.join();
     }
+    throw;
+  }
+  inferRange(0);
+  for (thread& worker : workers)
+  {
+    worker.join();
   }
 
-  // Now go to the lines holding the process/system current
-  // allocations and read in the allocations
-  skipComments(simfile);
-  for (int process = 0; process < numProcesses; process++)
+  // once the workers are done, reduce their partial sums
+  int allocationSum[MAX_RESOURCES] = {0};
+  int totalClaimSum[MAX_RESOURCES] = {0};
+  int claimMax[MAX_RESOURCES] = {0};
+  int negativeNeeds = 0;
+  int nonzeroNeeds = 0;
+  for (int worker = 0; worker < numThreads; worker++)
   {
     for (int resource = 0; resource < numResources; resource++)
     {
-      simfile >> allocation[process][resource];
+      allocationSum[resource] += partialSums[worker][resource];
+      totalClaimSum[resource] += partialClaimSums[worker][resource];
     }
+    vectorMax(numResources, claimMax, partialClaimMax[worker].data(), claimMax);
+    negativeNeeds += partialNegatives[worker];
+    nonzeroNeeds += partialNonzeros[worker];
   }
 
-  // now infer the need and available resources from the
-  // current state information
-  inferStateInformation();
+  inferAvailable(allocationSum, totalClaimSum, negativeNeeds, claimMax, nonzeroNeeds);
+  STATE_PROBE_RESULT(infer_done, NO_CANDIDATE, numProcesses, numResources, 0, numNegativeValues);
+}
 
-  // close the opened file before returning
-  simfile.close();
+/**
+ * @brief infer need for a range of rows
+ *
+ * Infer need = claim - allocation for the processes in the range
+ * [beginProcess, endProcess), and add their allocations and claims
+ * into the given allocation and claim sums.  We walk the matrices row by row, so all
+ * accesses are sequential, and count negative needs without
+ * branching so the inner loop stays vectorizable.  While each row is
+ * still in cache we also count its nonzero needs and take the
+ * maximum of its claims, the shape statistics of the state.
+ *
+ * @param beginProcess The first process (row) to infer.
+ * @param endProcess One past the last process (row) to infer.
+ * @param allocationSum The per resource allocation sums we
+ *   accumulate the row allocations into.
+ * @param partialClaimSum The per resource claim sums we accumulate
+ *   the row claims into.
+ * @param claimMax The per resource largest claims, raised by the
+ *   row claims.
+ * @param nonzeroNeeds The count of nonzero needs, incremented for
+ *   these rows.
+ *
+ * @returns int The number of negative needs found in these rows.
+ */
+int State::inferRows(int beginProcess, int endProcess, int allocationSum[], int partialClaimSum[], int claimMax[],
+  int& nonzeroNeeds)
+{
+  int negativeNeeds = 0;
+  for (int process = beginProcess; process < endProcess; process++)
+  {
+    negativeNeeds += vectorInferRow(numResources, claim[process], allocation[process], need[process], allocationSum,
+      partialClaimSum);
+    nonzeroNeeds += vectorCountNonzero(numResources, need[process]);
+    vectorMax(numResources, claimMax, claim[process], claimMax);
+  }
+  return negativeNeeds;
 }
 
 /**
- * @brief infer state informaton
+ * @brief infer available resources
  *
- * When we load state information from a file, we are only
- * given the minimal necessary information.  We need to infer
- * the process needs from the given claim and allocation information,
- * and we need to infer the available resources given the
- * total resources and the current allocation of resources.
+ * Final step of inferring the state information, once the
+ * allocations of each resource have been summed up we know what
+ * is still available.  Also records the claim column sums, the
+ * number of negative values found and the shape statistics, and
+ * selects the vector kernels for this state.
+ *
+ * @param allocationSum The sum of the current allocations of each
+ *   resource over all processes.
+ * @param totalClaimSum The sum of the claims for each resource
+ *   over all processes.
+ * @param negativeNeeds The number of negative needs that were found
+ *   while inferring the need matrix.
+ * @param claimMax The largest claim for each resource, 0 if none is
+ *   positive.
+ * @param nonzeroNeeds The number of nonzero needs that were found
+ *   while inferring the need matrix.
  */
-void State::inferStateInformation()
+void State::inferAvailable(const int allocationSum[], const int totalClaimSum[], int negativeNeeds, const int claimMax[],
+  int nonzeroNeeds)
+{
+  copyVector(numResources, totalClaimSum, claimSum);
+  vectorSubtract(numResources, resourceTotal, allocationSum, resourceAvailable);
+  numNegativeValues = negativeNeeds + vectorCountNegative(numResources, resourceAvailable);
+  numNonzeroNeeds = nonzeroNeeds;
+  maxClaim = 0;
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    maxClaim = max(maxClaim, claimMax[resource]);
+  }
+
+  // select the vector kernels specialized for this number of resources
+  kernels = selectResourceKernels(numResources);
+}
+
+/**
+ * @brief validate state
+ *
+ * Check that this state is valid, that all claims, allocations and
+ * totals are non negative, that no process is allocated more than it
+ * claims (need >= 0) and that no resource is oversubscribed
+ * (available >= 0).  The state information must already have been
+ * inferred.
+ *
+ * Valid states are the common case, so we check each row with a
+ * branch free pass that only or's together the violation tests,
+ * which the compiler can vectorize.  Only when a row turns out to
+ * hold a violation do we go back over it to find the coordinates.
+ *
+ * @param strict If true, stop and return as soon as the first
+ *   violation is found, otherwise all violations are reported.
+ *
+ * @returns vector<StateViolation> Returns the violations found,
+ *   in row major order, followed by violations of the resource
+ *   vectors.  The result is empty for a valid state.
+ */
+vector<StateViolation> State::validateState(bool strict) const
 {
-  // first of all, infer need from claim and allocation.
-  // need = claim - allocation
+  vector<StateViolation> violations;
+
   for (int process = 0; process < numProcesses; process++)
   {
+    const int* claimRow = claim[process];
+    const int* allocationRow = allocation[process];
+    const int* needRow = need[process];
+
+    bool rowInvalid = false;
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      rowInvalid |= (claimRow[resource] < 0) | (allocationRow[resource] < 0) | (needRow[resource] < 0);
+    }
+    if (not rowInvalid)
+    {
+      continue;
+    }
+
+    // slow path, find the coordinates of the violations in this row
     for (int resource = 0; resource < numResources; resource++)
     {
-      need[process][resource] = claim[process][resource] - allocation[process][resource];
+      if (claimRow[resource] < 0)
+      {
+        violations.push_back({NEGATIVE_VALUE, process, resource, claimRow[resource]});
+      }
+      if (allocationRow[resource] < 0)
+      {
+        violations.push_back({NEGATIVE_VALUE, process, resource, allocationRow[resource]});
+      }
+      if (needRow[resource] < 0)
+      {
+        violations.push_back({ALLOCATION_EXCEEDS_CLAIM, process, resource, needRow[resource]});
+      }
+      if (strict and not violations.empty())
+      {
+        return violations;
+      }
     }
   }
 
-  // now infer resource availability.  We need to sum up the allocated
-  // resources for all processes from the allocation matrix, then use
-  // this sum to determine the available from the resourceTotal
-  // resourceAvailable = resourceTotal - (sum of current allocations)
-  // notice the outer loop is over resources
   for (int resource = 0; resource < numResources; resource++)
   {
-    // sum up the current allocations for this resource
-    int currentAllocation = 0;
-    for (int process = 0; process < numProcesses; process++)
+    if (resourceTotal[resource] < 0)
     {
-      currentAllocation += allocation[process][resource];
+      violations.push_back({NEGATIVE_VALUE, NO_CANDIDATE, resource, resourceTotal[resource]});
+    }
+    if (resourceAvailable[resource] < 0)
+    {
+      violations.push_back({RESOURCE_OVERSUBSCRIBED, NO_CANDIDATE, resource, resourceAvailable[resource]});
+    }
+    if (strict and not violations.empty())
+    {
+      return violations;
     }
-
-    // now we know the sum of the current allocations for the resource,
-    // so we can derive what is available
-    resourceAvailable[resource] = resourceTotal[resource] - currentAllocation;
   }
+
+  return violations;
 }
 
 /**
@@ -387,6 +1664,236 @@ string State::tostring() const
   return out.str();
 }
 
+/**
+ * @brief write state
+ *
+ * Write the current state to a file descriptor, byte for byte as
+ * tostring() formats it.  The process rows are partitioned into
+ * contiguous ranges, one for each thread, as for
+ * inferStateInformationParallel().  Each thread formats its rows of
+ * the claim, allocation and need matrices into its own buffers, the
+ * calling thread taking the first range itself, and once all threads
+ * are done the titles, headers and buffers are written in order with
+ * vectored I/O, without first concatenating them.  Should a thread
+ * fail to start, the threads already started are joined before the
+ * failure is passed on.
+ *
+ * @param fd The file descriptor to write the state to.
+ * @param numThreads The number of threads to format rows with.  We
+ *   never use more threads than there are processes.
+ *
+ * @throws SimulatorException is thrown if writing fails.
+ */
+void State::writeState(int fd, int numThreads) const
+{
+  numThreads = max(1, min(numThreads, numProcesses));
+  const int NUM_MATRICES = 3;
+  const int(*matrices[NUM_MATRICES])[MAX_RESOURCES] = {claim, allocation, need};
+  const string titles[NUM_MATRICES] = {"Claim matrix C\n", "Allocation matrix A\n", "Need matrix C-A\n"};
+
+  string header = matrixHeaderToString(numResources);
+  string heads[NUM_MATRICES];
+  for (int matrix = 0; matrix < NUM_MATRICES; matrix++)
+  {
+    heads[matrix] = ((matrix > 0) ? "\n" : "") + titles[matrix] + header;
+  }
+  string tail = "\nResource vector R\n" + vectorToString(numResources, resourceTotal) + "\nAvailable vector V\n" +
+                vectorToString(numResources, resourceAvailable) + "\n";
+
+  // each thread formats its rows of every matrix into its own buffers
+  vector<string> rows(NUM_MATRICES * numThreads);
+  vector<int> beginProcesses(numThreads + 1, 0);
+  int rowsPerThread = numProcesses / numThreads;
+  int extraRows = numProcesses % numThreads;
+  for (int worker = 0; worker < numThreads; worker++)
+  {
+    beginProcesses[worker + 1] = beginProcesses[worker] + rowsPerThread + (worker < extraRows ? 1 : 0);
+  }
+  vector<exception_ptr> failures(numThreads);
+  auto formatRows = [&](int worker) {
+    try
+    {
+      for (int matrix = 0; matrix < NUM_MATRICES; matrix++)
+      {
+        rows[matrix * numThreads + worker] =
+          matrixRowsToString(beginProcesses[worker], beginProcesses[worker + 1], numResources, matrices[matrix]);
+      }
+    }
+    catch (...)
+    {
+      failures[worker] = current_exception();
+    }
+  };
+
+  vector<thread> workers;
+  workers.reserve(numThreads);
+  try
+  {
+    for (int worker = 1; worker < numThreads; worker++)
+    {
+      workers.push_back(thread(formatRows, worker));
+    }
+  }
+  catch (...)
+  {
+    for (thread& worker : workers)
+    {
+      worker.join();
+    }
+    throw;
+  }
+  formatRows(0);
+  for (thread& worker : workers)
+  {
+    worker.join();
+  }
+  for (const exception_ptr& failure : failures)
+  {
+    if (failure)
+    {
+      rethrow_exception(failure);
+    }
+  }
+
+  vector<iovec> buffers;
+  for (int matrix = 0; matrix < NUM_MATRICES; matrix++)
+  {
+    buffers.push_back({const_cast<char*>(heads[matrix].data()), heads[matrix].size()});
+    for (int worker = 0; worker < numThreads; worker++)
+    {
+      string& buffer = rows[matrix * numThreads + worker];
+      buffers.push_back({const_cast<char*>(buffer.data()), buffer.size()});
+    }
+  }
+  buffers.push_back({const_cast<char*>(tail.data()), tail.size()});
+
+  // writev() may write only part of the buffers, so resume after
+  // the bytes written until everything is out
+  size_t first = 0;
+  while (first < buffers.size())
+  {
+    int count = min<size_t>(buffers.size() - first, IOV_MAX);
+    ssize_t written = writev(fd, &buffers[first], count);
+    if ((written < 0) and (errno == EINTR))
+    {
+      continue;
+    }
+    if (written < 0)
+    {
+      stringstream msg;
+      msg << "<State::writeState> failed writing state: " << strerror(errno) << endl;
+      throw SimulatorException(msg.str());
+    }
+    while ((first < buffers.size()) and (static_cast<size_t>(written) >= buffers[first].iov_len))
+    {
+      written -= buffers[first].iov_len;
+      first++;
+    }
+    if (first < buffers.size())
+    {
+      buffers[first].iov_base = static_cast<char*>(buffers[first].iov_base) + written;
+      buffers[first].iov_len -= written;
+    }
+  }
+}
+
+/**
+ * @brief State summary to string
+ *
+ * Summarize the current state, for states too large to usefully
+ * display all of their matrices.  The summary holds the total,
+ * allocated and available amount of each resource, the number of
+ * processes blocked on each resource (whose need exceeds what is
+ * available), and the top k processes by total need and by total
+ * allocation held.  Everything is gathered in a single pass over
+ * the rows of the matrices, keeping only the k best processes so
+ * far in each ranking, so the summary stays small however large
+ * the state is.
+ *
+ * @param topK The number of processes to list in each ranking.
+ *
+ * @returns string Returns a formatted string object with the
+ *   summary of the current system State.
+ */
+string State::summaryString(int topK) const
+{
+  int allocated[MAX_RESOURCES] = {0};
+  int blocked[MAX_RESOURCES] = {0};
+
+  // min heaps of (total, -process) pairs, so the smallest of the
+  // top k (and the latest process on ties) is dropped first
+  typedef pair<long, int> Ranked;
+  priority_queue<Ranked, vector<Ranked>, greater<Ranked>> topNeed;
+  priority_queue<Ranked, vector<Ranked>, greater<Ranked>> topHeld;
+
+  for (int process = 0; process < numProcesses; process++)
+  {
+    long processNeed = 0;
+    long processHeld = 0;
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      allocated[resource] += allocation[process][resource];
+      blocked[resource] += (need[process][resource] > resourceAvailable[resource]);
+      processNeed += need[process][resource];
+      processHeld += allocation[process][resource];
+    }
+
+    topNeed.push(Ranked(processNeed, -process));
+    topHeld.push(Ranked(processHeld, -process));
+    if (static_cast<int>(topNeed.size()) > topK)
+    {
+      topNeed.pop();
+      topHeld.pop();
+    }
+  }
+
+  stringstream out;
+  out << "State summary: " << numProcesses << " processes, " << numResources << " resources" << endl;
+  out << endl;
+
+  out << "Resource vector R" << endl;
+  out << vectorToString(numResources, resourceTotal);
+  out << endl;
+
+  out << "Allocated vector" << endl;
+  out << vectorToString(numResources, allocated);
+  out << endl;
+
+  out << "Available vector V" << endl;
+  out << vectorToString(numResources, resourceAvailable);
+  out << endl;
+
+  out << "Blocked processes per resource" << endl;
+  out << vectorToString(numResources, blocked);
+  out << endl;
+
+  // the heaps hand back the rankings smallest first, so we fill
+  // the ranking lines in from the end
+  const char* titles[] = {"need", "allocation held"};
+  priority_queue<Ranked, vector<Ranked>, greater<Ranked>>* rankings[] = {&topNeed, &topHeld};
+  for (int ranking = 0; ranking < 2; ranking++)
+  {
+    vector<string> lines(rankings[ranking]->size());
+    for (int line = lines.size() - 1; line >= 0; line--)
+    {
+      Ranked ranked = rankings[ranking]->top();
+      rankings[ranking]->pop();
+      stringstream entry;
+      entry << "P" << left << fixed << setw(3) << -ranked.second << ranked.first;
+      lines[line] = entry.str();
+    }
+
+    out << "Top " << lines.size() << " processes by " << titles[ranking] << endl;
+    for (const string& line : lines)
+    {
+      out << line << endl;
+    }
+    out << endl;
+  }
+
+  return out.str();
+}
+
 /** State output operator
  * Overload the output operator for a State object.
  * This function allows us to directly stream the simulated
@@ -417,13 +1924,13 @@ ostream& operator<<(ostream& stream, const State& state)
  * until we find a line that doesn't start with a '#' then we
  * are done.
  *
- * @param simfile An input file stream object we are to read
- *   from and process.
+ * @param simfile An input stream object we are to read
+ *   from and process, a file stream or e.g. standard input.
  */
-void skipComments(ifstream& simfile)
+void skipComments(istream& simfile)
 {
   bool done = false;
-  char c;
+  char c = '\0';
 
   // keep going until we find out we are done by reading
   // a non '#' character
@@ -469,10 +1976,100 @@ void skipComments(ifstream& simfile)
  */
 void copyVector(int numItems, const int srcVector[], int dstVector[])
 {
-  for (int item = 0; item < numItems; item++)
+  vectorCopy(numItems, srcVector, dstVector);
+}
+
+/**
+ * @brief violation to string
+ *
+ * Describe a state validation violation and its coordinates
+ * for display.
+ *
+ * @param violation The violation to describe.
+ *
+ * @returns string Returns a one line description of the violation.
+ */
+string violationToString(const StateViolation& violation)
+{
+  stringstream out;
+
+  switch (violation.type)
+  {
+  case NEGATIVE_VALUE:
+    out << "negative value";
+    break;
+  case ALLOCATION_EXCEEDS_CLAIM:
+    out << "allocation exceeds claim, need";
+    break;
+  case RESOURCE_OVERSUBSCRIBED:
+    out << "resource oversubscribed, available";
+    break;
+  }
+  out << " = " << violation.value << " at ";
+  if (violation.process != NO_CANDIDATE)
+  {
+    out << "P" << violation.process << " ";
+  }
+  out << "R" << violation.resource;
+
+  return out.str();
+}
+
+/**
+ * @brief unsafe certificate to string
+ *
+ * Function to convert an unsafe certificate to a string for display,
+ * the resources available when the safety check stopped, the
+ * shortfall of each blocked process, and the bottleneck resources
+ * with the number of blocked processes each holds back.
+ *
+ * @param certificate The unsafe certificate to display.
+ *
+ * @returns string Returns a formatted string object describing
+ *   why the state is unsafe, or that it is safe.
+ */
+string certificateToString(const UnsafeCertificate& certificate)
+{
+  stringstream out;
+  if (certificate.blockedProcesses.empty())
+  {
+    out << "No blocked processes, state is safe" << endl;
+    return out.str();
+  }
+
+  int numResources = certificate.available.size();
+  out << "Available vector when blocked" << endl;
+  out << vectorToString(numResources, certificate.available.data());
+  out << endl;
+
+  // the shortfall rows are labeled by the blocked processes, which
+  // are not consecutive, so we can not use matrixToString() here
+  out << "Shortfall of blocked processes" << endl;
+  out << left << fixed << setw(4) << " ";
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    out << "R" << left << fixed << setw(3) << resource;
+  }
+  out << endl;
+  for (size_t row = 0; row < certificate.blockedProcesses.size(); row++)
+  {
+    out << "P" << left << fixed << setw(3) << certificate.blockedProcesses[row];
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      out << left << fixed << setw(4) << certificate.shortfall[row * numResources + resource];
+    }
+    out << endl;
+  }
+  out << endl;
+
+  out << "Bottleneck resources by blocked processes" << endl;
+  for (int resource : certificate.bottleneckResources)
   {
-    dstVector[item] = srcVector[item];
+    out << "R" << left << fixed << setw(3) << resource << certificate.blockedCount[resource] << endl;
   }
+  out << endl;
+
+  return out.str();
 }
 
 /**
@@ -529,6 +2126,21 @@ string vectorToString(int numResources, const int vector[])
  *   contents of the given matrix represented in the string.
  */
 string matrixToString(int numProcesses, int numResources, const int matrix[][MAX_RESOURCES])
+{
+  return matrixHeaderToString(numResources) + matrixRowsToString(0, numProcesses, numResources, matrix);
+}
+
+/**
+ * @brief matrix header to string
+ *
+ * The header line of a matrix displayed by matrixToString(), the
+ * resource labels of its columns.
+ *
+ * @param numResources The number of resources (columns) in the matrix
+ *
+ * @returns string Returns the formatted header line.
+ */
+string matrixHeaderToString(int numResources)
 {
   stringstream out;
 
@@ -541,8 +2153,30 @@ string matrixToString(int numProcesses, int numResources, const int matrix[][MAX
   }
   out << endl;
 
+  return out.str();
+}
+
+/**
+ * @brief matrix rows to string
+ *
+ * The lines of a range of rows of a matrix displayed by
+ * matrixToString(), so that ranges of rows can be formatted
+ * separately and then concatenated.
+ *
+ * @param beginProcess The first process (row) to format.
+ * @param endProcess One past the last process (row) to format.
+ * @param numResources The number of resources (columns) in the matrix
+ * @param matrix A 2-d array of integer values which are the number
+ *   of each resource type.
+ *
+ * @returns string Returns the formatted lines of the rows.
+ */
+string matrixRowsToString(int beginProcess, int endProcess, int numResources, const int matrix[][MAX_RESOURCES])
+{
+  stringstream out;
+
   // output the matrix contents
-  for (int process = 0; process < numProcesses; process++)
+  for (int process = beginProcess; process < endProcess; process++)
   {
     out << "P" << left << fixed << setw(3) << process;
     for (int resource = 0; resource < numResources; resource++)
@@ -0,0 +1,611 @@
+/** @file StateArchive.cpp
+ * @brief State time series archive implementations
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Implementation file for our compressed archive of State
+ * snapshots, and the varint encoding of states and state deltas.
+ */
+#include "StateArchive.hpp"
+#include "SimulatorException.hpp"
+#include <climits>
+#include <sstream>
+
+using namespace std;
+
+/// @brief magic bytes at the start of an archive
+static const char ARCHIVE_MAGIC[] = "SIMA";
+/// @brief magic bytes at the end of an archive
+static const char TRAILER_MAGIC[] = "SIMI";
+/// @brief size of the archive header, magic and keyframe interval
+static const int HEADER_SIZE = 8;
+/// @brief size of the archive trailer, snapshot count, index offset and magic
+static const int TRAILER_SIZE = 20;
+/// @brief record type of a keyframe record
+static const char KEYFRAME_RECORD = 'K';
+/// @brief record type of a delta record
+static const char DELTA_RECORD = 'D';
+
+/**
+ * @brief write fixed size integer
+ *
+ * Write the low numBytes bytes of value to the stream, in little
+ * endian order, as used for the archive header, index and trailer.
+ *
+ * @param out The stream to write to.
+ * @param value The value to write.
+ * @param numBytes The number of bytes to write.
+ */
+static void writeFixed(ostream& out, uint64_t value, int numBytes)
+{
+  for (int byte = 0; byte < numBytes; byte++)
+  {
+    out.put(static_cast<char>((value >> (8 * byte)) & 0xff));
+  }
+}
+
+/**
+ * @brief read fixed size integer
+ *
+ * Read a numBytes little endian integer from a buffer.
+ *
+ * @param in The buffer holding the integer.
+ * @param numBytes The number of bytes to read.
+ *
+ * @returns uint64_t The value read.
+ */
+static uint64_t readFixed(const char* in, int numBytes)
+{
+  uint64_t value = 0;
+  for (int byte = 0; byte < numBytes; byte++)
+  {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(in[byte])) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * @brief archive writer constructor
+ *
+ * Create (or truncate) an archive file and write its header.
+ *
+ * @param filename The name of the archive file to write.
+ * @param keyframeInterval The number of snapshots between two
+ *   full keyframes.  1 stores every snapshot as a keyframe.
+ *
+ * @throws SimulatorException is thrown if the file can not be
+ *   created or the keyframe interval is not positive.
+ */
+StateArchiveWriter::StateArchiveWriter(string filename, int keyframeInterval)
+  : archive(filename, ios::binary | ios::trunc)
+  , keyframeInterval(keyframeInterval)
+  , closed(false)
+{
+  if (!archive.is_open() or keyframeInterval < 1)
+  {
+    stringstream msg;
+    msg << "<StateArchiveWriter> could not create archive file: " << filename << " with keyframe interval "
+        << keyframeInterval << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  archive.write(ARCHIVE_MAGIC, 4);
+  writeFixed(archive, keyframeInterval, 4);
+}
+
+/**
+ * @brief archive writer destructor
+ *
+ * Make sure the index and trailer get written, an archive that
+ * was not closed can not be read.  A destructor must not throw, so
+ * a failure to write them is only reported by an explicit close().
+ */
+StateArchiveWriter::~StateArchiveWriter()
+{
+  if (not closed)
+  {
+    finishIndex();
+  }
+}
+
+/**
+ * @brief append a snapshot
+ *
+ * Append the next snapshot of a state to the archive.  A keyframe
+ * is written every keyframeInterval snapshots, otherwise only the
+ * difference from the previous snapshot is written.
+ *
+ * @param state The next snapshot to archive.
+ *
+ * @throws SimulatorException is thrown if the archive was already
+ *   closed, the snapshot does not have the same shape as the
+ *   previous snapshots, or writing the archive has failed.
+ */
+void StateArchiveWriter::append(const State& state)
+{
+  if (closed)
+  {
+    throw SimulatorException("<StateArchiveWriter::append> archive is already closed\n");
+  }
+
+  string record;
+  if (recordOffsets.size() % keyframeInterval == 0)
+  {
+    if (not recordOffsets.empty() and ((state.getNumProcesses() != previous.getNumProcesses()) or
+                                          (state.getNumResources() != previous.getNumResources())))
+    {
+      throw SimulatorException("<StateArchiveWriter::append> snapshots must all have the same shape\n");
+    }
+    record.push_back(KEYFRAME_RECORD);
+    encodeState(record, state);
+  }
+  else
+  {
+    // diff throws if the shapes do not match
+    record.push_back(DELTA_RECORD);
+    encodeDelta(record, previous.diff(state), state.getNumResources());
+  }
+
+  uint64_t offset = archive.tellp();
+  archive.write(record.data(), record.size());
+  if (archive.fail())
+  {
+    stringstream msg;
+    msg << "<StateArchiveWriter::append> failed writing snapshot " << recordOffsets.size() << endl;
+    throw SimulatorException(msg.str());
+  }
+  recordOffsets.push_back(offset);
+  previous = state;
+}
+
+/**
+ * @brief finish index
+ *
+ * Write the record index and trailer and close the archive file,
+ * without throwing.
+ *
+ * @returns bool true if the archive was written, false if writing
+ *   it failed.
+ */
+bool StateArchiveWriter::finishIndex()
+{
+  closed = true;
+  uint64_t indexOffset = archive.tellp();
+  for (uint64_t offset : recordOffsets)
+  {
+    writeFixed(archive, offset, 8);
+  }
+  writeFixed(archive, recordOffsets.size(), 8);
+  writeFixed(archive, indexOffset, 8);
+  archive.write(TRAILER_MAGIC, 4);
+
+  archive.close();
+  return not archive.fail();
+}
+
+/**
+ * @brief close the archive
+ *
+ * Write the record index and trailer, and close the archive file.
+ * No more snapshots can be appended afterwards.
+ *
+ * @throws SimulatorException is thrown if writing the archive
+ *   failed.
+ */
+void StateArchiveWriter::close()
+{
+  if (closed)
+  {
+    return;
+  }
+
+  if (not finishIndex())
+  {
+    stringstream msg;
+    msg << "<StateArchiveWriter::close> failed writing archive index" << endl;
+    throw SimulatorException(msg.str());
+  }
+}
+
+/**
+ * @brief number of snapshots accessor
+ *
+ * @returns int The number of snapshots appended so far.
+ */
+int StateArchiveWriter::getNumSnapshots() const
+{
+  return recordOffsets.size();
+}
+
+/**
+ * @brief archive reader constructor
+ *
+ * Open an archive and read its header and trailer.
+ *
+ * @param filename The name of the archive file to read.
+ *
+ * @throws SimulatorException is thrown if the file can not be
+ *   opened, or is not a (complete) archive, or its keyframe interval
+ *   or trailer is invalid.
+ */
+StateArchiveReader::StateArchiveReader(string filename)
+  : archive(filename, ios::binary)
+{
+  char header[HEADER_SIZE];
+  char trailer[TRAILER_SIZE];
+  archive.read(header, HEADER_SIZE);
+  archive.seekg(0, ios::end);
+  uint64_t fileSize = archive.tellg();
+  archive.seekg(-TRAILER_SIZE, ios::end);
+  archive.read(trailer, TRAILER_SIZE);
+
+  if (!archive or string(header, 4) != ARCHIVE_MAGIC or string(trailer + 16, 4) != TRAILER_MAGIC)
+  {
+    stringstream msg;
+    msg << "<StateArchiveReader> not a state archive, or archive was not closed: " << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  keyframeInterval = readFixed(header + 4, 4);
+  uint64_t trailerSnapshots = readFixed(trailer, 8);
+  indexOffset = readFixed(trailer + 8, 8);
+  if (keyframeInterval < 1)
+  {
+    stringstream msg;
+    msg << "<StateArchiveReader> corrupt archive, invalid keyframe interval " << keyframeInterval << ": " << filename
+        << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  // the index must start after the header and, together with the
+  // trailer, run exactly to the end of the file
+  if ((trailerSnapshots > static_cast<uint64_t>(INT_MAX)) or (indexOffset < HEADER_SIZE) or (indexOffset > fileSize) or
+      (indexOffset + 8 * trailerSnapshots + TRAILER_SIZE != fileSize))
+  {
+    stringstream msg;
+    msg << "<StateArchiveReader> corrupt archive, trailer does not match the file size: " << filename << endl;
+    throw SimulatorException(msg.str());
+  }
+  numSnapshots = trailerSnapshots;
+}
+
+/**
+ * @brief record offset
+ *
+ * Look up the file offset of the record of a snapshot in the
+ * archive index.
+ *
+ * @param snapshot The snapshot to look up.
+ *
+ * @returns uint64_t The file offset of the snapshot's record.
+ *
+ * @throws SimulatorException is thrown if the index entry can not
+ *   be read.
+ */
+uint64_t StateArchiveReader::recordOffset(int snapshot)
+{
+  char entry[8];
+  archive.clear();
+  archive.seekg(indexOffset + 8 * static_cast<uint64_t>(snapshot));
+  archive.read(entry, 8);
+  if (!archive)
+  {
+    stringstream msg;
+    msg << "<StateArchiveReader::recordOffset> could not read index entry of snapshot " << snapshot << endl;
+    throw SimulatorException(msg.str());
+  }
+  return readFixed(entry, 8);
+}
+
+/**
+ * @brief number of snapshots accessor
+ *
+ * @returns int The number of snapshots in the archive.
+ */
+int StateArchiveReader::getNumSnapshots() const
+{
+  return numSnapshots;
+}
+
+/**
+ * @brief read a snapshot
+ *
+ * Reconstruct a snapshot from the archive.  We seek to the nearest
+ * keyframe at or before the snapshot, read it and the following
+ * deltas in one block, decode the keyframe and then apply the deltas
+ * up to the requested snapshot.  The snapshot is reconstructed in a
+ * local state, so a corrupt record leaves the given state untouched.
+ *
+ * @param snapshot The index of the snapshot to read, from 0 to
+ *   getNumSnapshots() - 1.
+ * @param state The state to load the snapshot into, only changed
+ *   once the whole snapshot has been reconstructed.
+ *
+ * @throws SimulatorException is thrown if the snapshot does not
+ *   exist or the archive is corrupt.
+ */
+void StateArchiveReader::readSnapshot(int snapshot, State& state)
+{
+  if ((snapshot < 0) or (snapshot >= numSnapshots))
+  {
+    stringstream msg;
+    msg << "<StateArchiveReader::readSnapshot> no snapshot " << snapshot << " in archive of " << numSnapshots
+        << " snapshots" << endl;
+    throw SimulatorException(msg.str());
+  }
+
+  int keyframe = snapshot - (snapshot % keyframeInterval);
+  uint64_t begin = recordOffset(keyframe);
+  uint64_t end = (snapshot + 1 < numSnapshots) ? recordOffset(snapshot + 1) : indexOffset;
+  if (begin < HEADER_SIZE or end <= begin or end > indexOffset)
+  {
+    throw SimulatorException("<StateArchiveReader::readSnapshot> corrupt archive index\n");
+  }
+
+  string records(end - begin, '\0');
+  archive.seekg(begin);
+  archive.read(&records[0], records.size());
+  const char* in = records.data();
+  const char* last = in + records.size();
+
+  if (!archive or *in++ != KEYFRAME_RECORD)
+  {
+    throw SimulatorException("<StateArchiveReader::readSnapshot> missing keyframe record\n");
+  }
+  State reconstructed;
+  decodeState(in, last, reconstructed);
+
+  StateDelta delta;
+  for (int record = keyframe + 1; record <= snapshot; record++)
+  {
+    if (in >= last or *in++ != DELTA_RECORD)
+    {
+      throw SimulatorException("<StateArchiveReader::readSnapshot> missing delta record\n");
+    }
+    decodeDelta(in, last, delta, reconstructed.getNumResources());
+    reconstructed.applyDelta(delta);
+  }
+  state = reconstructed;
+}
+
+//------------------------------------------------------------------
+
+/**
+ * @brief write varint
+ *
+ * Append an unsigned value as a variable length integer, 7 bits
+ * per byte, least significant first, with the high bit of each
+ * byte set if more bytes follow.
+ *
+ * @param out The buffer to append the encoded value to.
+ * @param value The value to encode.
+ */
+void writeVarint(string& out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief read varint
+ *
+ * Decode a variable length integer written by writeVarint().
+ *
+ * @param in The position to decode from, advanced past the value.
+ * @param end The end of the buffer being decoded.
+ *
+ * @returns uint64_t The decoded value.
+ *
+ * @throws SimulatorException is thrown if the buffer ends in the
+ *   middle of the value.
+ */
+uint64_t readVarint(const char*& in, const char* end)
+{
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (in >= end)
+    {
+      break;
+    }
+    unsigned char byte = static_cast<unsigned char>(*in++);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return value;
+    }
+  }
+  throw SimulatorException("<readVarint> truncated or malformed varint\n");
+}
+
+/**
+ * @brief zigzag encode
+ *
+ * Map a signed value to an unsigned one so that values of small
+ * magnitude, positive or negative, encode as small varints, e.g.
+ * 0, -1, 1, -2, 2 map to 0, 1, 2, 3, 4.
+ *
+ * @param value The signed value to encode.
+ *
+ * @returns uint64_t The zigzag encoded value.
+ */
+uint64_t zigzagEncode(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @brief zigzag decode
+ *
+ * Inverse of zigzagEncode().
+ *
+ * @param value The zigzag encoded value.
+ *
+ * @returns int64_t The signed value.
+ */
+int64_t zigzagDecode(uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @brief encode state
+ *
+ * Append a full state, its shape, resource totals, claims and
+ * allocations, as zigzag varints.  The need and available
+ * information is not stored, it is inferred again when decoded.
+ *
+ * @param out The buffer to append the encoded state to.
+ * @param state The state to encode.
+ */
+void encodeState(string& out, const State& state)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  writeVarint(out, numProcesses);
+  writeVarint(out, numResources);
+
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    writeVarint(out, zigzagEncode(state.getResourceTotal(resource)));
+  }
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      writeVarint(out, zigzagEncode(state.getClaim(process, resource)));
+    }
+  }
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      writeVarint(out, zigzagEncode(state.getAllocation(process, resource)));
+    }
+  }
+}
+
+/**
+ * @brief decode state
+ *
+ * Decode a state written by encodeState() directly into a State.
+ *
+ * @param in The position to decode from, advanced past the state.
+ * @param end The end of the buffer being decoded.
+ * @param state The state to load the decoded state into.
+ *
+ * @throws SimulatorException is thrown if the encoded state is
+ *   truncated or has an invalid shape.
+ */
+void decodeState(const char*& in, const char* end, State& state)
+{
+  int numProcesses = readVarint(in, end);
+  int numResources = readVarint(in, end);
+  if ((numProcesses < 0) or (numResources < 0) or (numProcesses > MAX_PROCESSES) or (numResources > MAX_RESOURCES))
+  {
+    throw SimulatorException("<decodeState> encoded state has an invalid shape\n");
+  }
+
+  int numCells = numProcesses * numResources;
+  vector<int> total(numResources);
+  vector<int> claims(numCells);
+  vector<int> allocations(numCells);
+  for (int& value : total)
+  {
+    value = zigzagDecode(readVarint(in, end));
+  }
+  for (int& value : claims)
+  {
+    value = zigzagDecode(readVarint(in, end));
+  }
+  for (int& value : allocations)
+  {
+    value = zigzagDecode(readVarint(in, end));
+  }
+
+  state.loadState(numProcesses, numResources, total, claims, allocations);
+}
+
+/**
+ * @brief encode delta
+ *
+ * Append a state delta as varints.  Cells are in row major order,
+ * so each cell is stored as the gap from the previous cell's
+ * row major index, followed by its zigzag encoded claim and
+ * allocation deltas.  The changed totals follow the cells.
+ *
+ * @param out The buffer to append the encoded delta to.
+ * @param delta The delta to encode, as produced by State::diff().
+ * @param numResources The number of resources of the states the
+ *   delta is between, needed to compute row major cell indexes.
+ */
+void encodeDelta(string& out, const StateDelta& delta, int numResources)
+{
+  writeVarint(out, delta.cells.size());
+  int previousIndex = -1;
+  for (const CellDelta& cell : delta.cells)
+  {
+    int index = cell.process * numResources + cell.resource;
+    writeVarint(out, index - previousIndex - 1);
+    writeVarint(out, zigzagEncode(cell.claimDelta));
+    writeVarint(out, zigzagEncode(cell.allocationDelta));
+    previousIndex = index;
+  }
+
+  writeVarint(out, delta.totals.size());
+  for (const TotalDelta& total : delta.totals)
+  {
+    writeVarint(out, total.resource);
+    writeVarint(out, zigzagEncode(total.delta));
+  }
+}
+
+/**
+ * @brief decode delta
+ *
+ * Decode a state delta written by encodeDelta().
+ *
+ * @param in The position to decode from, advanced past the delta.
+ * @param end The end of the buffer being decoded.
+ * @param delta The delta to decode into, any previous contents
+ *   are replaced.
+ * @param numResources The number of resources of the states the
+ *   delta is between.
+ *
+ * @throws SimulatorException is thrown if the encoded delta is
+ *   truncated.
+ */
+void decodeDelta(const char*& in, const char* end, StateDelta& delta, int numResources)
+{
+  delta.cells.clear();
+  delta.totals.clear();
+  if (numResources < 1)
+  {
+    numResources = 1;
+  }
+
+  uint64_t numCells = readVarint(in, end);
+  int index = -1;
+  for (uint64_t cell = 0; cell < numCells; cell++)
+  {
+    index += readVarint(in, end) + 1;
+    int claimDelta = zigzagDecode(readVarint(in, end));
+    int allocationDelta = zigzagDecode(readVarint(in, end));
+    delta.cells.push_back({index / numResources, index % numResources, claimDelta, allocationDelta});
+  }
+
+  uint64_t numTotals = readVarint(in, end);
+  for (uint64_t total = 0; total < numTotals; total++)
+  {
+    int resource = readVarint(in, end);
+    int totalDelta = zigzagDecode(readVarint(in, end));
+    delta.totals.push_back({resource, totalDelta});
+  }
+}
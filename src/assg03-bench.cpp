@@ -0,0 +1,225 @@
+/** @file assg03-bench.cpp
+ * @brief Admission throughput and latency benchmark
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Command line benchmark comparing two ways of sharing one State
+ * between many client threads making resource requests and releases:
+ * locking the State with a mutex, and handing all requests to a
+ * single writer AdmissionActor through its lock free queue.  We
+ * report the throughput and the latency distribution of each.
+ */
+#include "AdmissionActor.hpp"
+#include "SimulatorException.hpp"
+#include "State.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/// @brief clock used to time operations
+typedef chrono::steady_clock BenchClock;
+
+/**
+ * @brief usage
+ *
+ * Usage information for invoking the benchmark with command line
+ * arguments.  Print usage information and exit with non success
+ * status to indicate error.
+ */
+void usage()
+{
+  cout << "Usage: bench state.sim [threads] [operations]" << endl
+       << "Benchmark mutex based and actor based admission of resource" << endl
+       << "requests and releases against the given state." << endl
+       << endl
+       << "threads      The number of client threads, default 8." << endl
+       << "operations   The number of request/release operations per" << endl
+       << "             client thread, default 20000." << endl;
+  exit(1);
+}
+
+/**
+ * @brief client workload
+ *
+ * The operations of one client thread.  Client clientId works on
+ * the processes clientId, clientId + numClients, ... and for each
+ * operation requests one unit of a resource its process still needs,
+ * releasing it again with the next operation if it was granted.
+ * Clients can share processes, so a request may exceed what is left
+ * of the process's need by the time it is admitted, this is counted
+ * as a denied request.  The time each operation takes is recorded.
+ *
+ * @param state The loaded state, used for its shape and needs.
+ * @param clientId The index of this client thread.
+ * @param numClients The number of client threads.
+ * @param numOperations The number of operations to perform.
+ * @param operate Performs one request or release and returns if it
+ *   was granted.
+ * @param latencies Returns the latency of each operation, in
+ *   nanoseconds.
+ */
+template<typename Operate>
+void clientWorkload(const State& state, int clientId, int numClients, int numOperations, Operate operate,
+  vector<long>& latencies)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  int resources[MAX_RESOURCES] = {0};
+  int heldProcess = NO_CANDIDATE;
+  int nextProcess = clientId % numProcesses;
+
+  latencies.reserve(numOperations);
+  for (int operation = 0; operation < numOperations; operation++)
+  {
+    BenchClock::time_point start = BenchClock::now();
+    if (heldProcess != NO_CANDIDATE)
+    {
+      operate(RELEASE_RESOURCES, heldProcess, resources);
+      heldProcess = NO_CANDIDATE;
+    }
+    else
+    {
+      int process = nextProcess;
+      nextProcess = (nextProcess + numClients) % numProcesses;
+      int resource = operation % numResources;
+      fill(resources, resources + numResources, 0);
+      resources[resource] = (state.getNeed(process, resource) > 0) ? 1 : 0;
+      try
+      {
+        if (operate(REQUEST_RESOURCES, process, resources) and resources[resource] > 0)
+        {
+          heldProcess = process;
+        }
+      }
+      catch (const SimulatorException&)
+      {
+        // another client used up the rest of this process's need
+      }
+    }
+    latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(BenchClock::now() - start).count());
+  }
+}
+
+/**
+ * @brief run clients
+ *
+ * Run the client workload on numClients threads at once, and report
+ * the throughput and latency percentiles over all operations.
+ *
+ * @param name The name of the admission strategy, for the report.
+ * @param state The loaded state.
+ * @param numClients The number of client threads.
+ * @param numOperations The number of operations per client thread.
+ * @param operate Performs one request or release.
+ */
+template<typename Operate>
+void runClients(const string& name, const State& state, int numClients, int numOperations, Operate operate)
+{
+  vector<vector<long>> latencies(numClients);
+  vector<thread> clients;
+
+  BenchClock::time_point start = BenchClock::now();
+  for (int client = 0; client < numClients; client++)
+  {
+    clients.push_back(thread([&, client]() {
+      clientWorkload(state, client, numClients, numOperations, operate, latencies[client]);
+    }));
+  }
+  for (thread& client : clients)
+  {
+    client.join();
+  }
+  double seconds = chrono::duration<double>(BenchClock::now() - start).count();
+
+  vector<long> all;
+  for (const vector<long>& clientLatencies : latencies)
+  {
+    all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+  }
+  sort(all.begin(), all.end());
+
+  double percentiles[] = {0.50, 0.99, 0.999};
+  cout << left << setw(8) << name << fixed << setprecision(0) << setw(12) << all.size() / seconds << " ops/s";
+  for (double percentile : percentiles)
+  {
+    size_t index = min(all.size() - 1, static_cast<size_t>(percentile * all.size()));
+    cout << "  p" << setprecision(1) << percentile * 100 << " " << setprecision(2) << all[index] / 1000.0 << "us";
+  }
+  cout << endl;
+}
+
+/**
+ * @brief main entry point
+ *
+ * Entry point of the admission benchmark.  Loads the state and runs
+ * the same client workload with mutex based and actor based
+ * admission.
+ *
+ * @param argc The command line argument count.
+ * @param argv[] The command line argument values, the state file
+ *   followed by the optional number of threads and operations.
+ *
+ * @return 0 is returned if the benchmark finishes successfully.
+ */
+int main(int argc, char** argv)
+{
+  if (argc < 2 or argc > 4)
+  {
+    usage();
+  }
+  int numClients = (argc > 2) ? atoi(argv[2]) : 8;
+  int numOperations = (argc > 3) ? atoi(argv[3]) : 20000;
+  if (numClients < 1 or numOperations < 1)
+  {
+    usage();
+  }
+
+  try
+  {
+    State state;
+    state.loadState(argv[1]);
+    cout << "clients " << numClients << ", operations per client " << numOperations << endl;
+
+    // every client locks the shared state for each operation
+    State shared = state;
+    mutex stateMutex;
+    runClients("mutex", state, numClients, numOperations, [&](AdmissionType type, int process, const int resources[]) {
+      lock_guard<mutex> lock(stateMutex);
+      if (type == REQUEST_RESOURCES)
+      {
+        return shared.requestResources(process, resources);
+      }
+      shared.releaseResources(process, resources);
+      return true;
+    });
+
+    // every client submits to the actor and waits for the result
+    AdmissionActor actor(state, 0);
+    runClients("actor", state, numClients, numOperations, [&](AdmissionType type, int process, const int resources[]) {
+      if (type == REQUEST_RESOURCES)
+      {
+        return actor.submitRequest(process, resources).get();
+      }
+      return actor.submitRelease(process, resources).get();
+    });
+    actor.stop();
+  }
+  catch (const SimulatorException& e)
+  {
+    cerr << "Benchmark resulted in runtime error occurring:" << endl;
+    cerr << e.what() << endl;
+    exit(1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,558 @@
+/** @file assg03-difftest.cpp
+ * @brief Differential test harness for the safety engines
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Summer 2022
+ * @note   ide:  g++ 8.2.0 / GNU Make 4.2.1
+ *
+ * Command line differential tester.  We generate large numbers of
+ * random and adversarial states from a seeded generator, and check
+ * the verdict of every optimized safety engine against the reference
+ * State::isSafe(), along with the validity of the safe sequence the
+ * engine found.  Any disagreement is minimized to a small
+ * counterexample, which is printed as a simulation file that can be
+ * loaded by sim.
+ */
+#include "CompactState.hpp"
+#include "ExternalSafety.hpp"
+#include "NeedSummaryTree.hpp"
+#include "PackedState.hpp"
+#include "PartitionedSafety.hpp"
+#include "SafetyEngine.hpp"
+#include "SafetyWorkspace.hpp"
+#include "SimulatorException.hpp"
+#include "State.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+/** @struct DiffCase
+ * @brief A generated test state
+ *
+ * The values of a generated state, kept separately from a State so
+ * they can be shrunk while minimizing a counterexample.
+ */
+struct DiffCase
+{
+  /// @brief The number of processes.
+  int numProcesses;
+  /// @brief The number of resources.
+  int numResources;
+  /// @brief The total resource vector.
+  vector<int> total;
+  /// @brief The claim matrix, in row major order.
+  vector<int> claims;
+  /// @brief The allocation matrix, in row major order.
+  vector<int> allocations;
+};
+
+/// @brief a safety engine under test, returns its verdict and the
+///   (partial) safe sequence it found
+typedef bool (*EngineFunction)(const State& state, vector<int>& sequence);
+
+/** @struct DiffEngine
+ * @brief A safety engine under test
+ */
+struct DiffEngine
+{
+  /// @brief The name of the engine, for reports.
+  const char* name;
+  /// @brief Whether the engine returns a safe sequence to validate.
+  bool producesSequence;
+  /// @brief Only run the engine on every stride'th case, for
+  ///   engines too expensive to run on every case.
+  int stride;
+  /// @brief Runs the engine.
+  EngineFunction run;
+};
+
+/**
+ * @brief sequence engine
+ *
+ * State::isSafe() returning the safe sequence.
+ */
+static bool sequenceEngine(const State& state, vector<int>& sequence)
+{
+  return state.isSafe(sequence);
+}
+
+/**
+ * @brief workspace engine
+ *
+ * State::isSafe() with a reusable SafetyWorkspace and bitmap
+ * candidate search.
+ */
+static bool workspaceEngine(const State& state, vector<int>& sequence)
+{
+  static SafetyWorkspace workspace;
+  bool safe = state.isSafe(workspace);
+  sequence.assign(workspace.sequence, workspace.sequence + workspace.sequenceLength);
+  return safe;
+}
+
+/**
+ * @brief summary tree engine
+ *
+ * State::isSafe() with a reusable minimum need summary tree to skip
+ * blocks of processes that can not run.
+ */
+static bool summaryTreeEngine(const State& state, vector<int>& sequence)
+{
+  static NeedSummaryTree tree;
+  return state.isSafe(tree, sequence);
+}
+
+/**
+ * @brief selector engine
+ *
+ * EngineSelector::isSafe(), tuned on this host, dispatching each
+ * state to the fastest engine for its shape.
+ */
+static bool selectorEngine(const State& state, vector<int>& /* sequence */)
+{
+  static EngineSelector selector;
+  static bool tuned = false;
+  if (not tuned)
+  {
+    selector.tune(1);
+    tuned = true;
+  }
+  return selector.isSafe(state);
+}
+
+/**
+ * @brief compact engine
+ *
+ * CompactState::isSafe(), computing needs from the claims and
+ * allocations on the fly.
+ */
+static bool compactEngine(const State& state, vector<int>& sequence)
+{
+  CompactState compact(state);
+  return compact.isSafe(sequence);
+}
+
+/**
+ * @brief incremental engine
+ *
+ * State::applyDelta() revalidation, starting from the state with
+ * the same claims and totals but nothing allocated.
+ */
+static bool incrementalEngine(const State& state, vector<int>& sequence)
+{
+  int numProcesses = state.getNumProcesses();
+  int numResources = state.getNumResources();
+  vector<int> total(numResources);
+  vector<int> claims(numProcesses * numResources);
+  vector<int> allocations(numProcesses * numResources, 0);
+  for (int resource = 0; resource < numResources; resource++)
+  {
+    total[resource] = state.getResourceTotal(resource);
+  }
+  for (int process = 0; process < numProcesses; process++)
+  {
+    for (int resource = 0; resource < numResources; resource++)
+    {
+      claims[process * numResources + resource] = state.getClaim(process, resource);
+    }
+  }
+
+  State base;
+  base.loadState(numProcesses, numResources, total, claims, allocations);
+  base.isSafe(sequence);
+  return base.applyDelta(base.diff(state), sequence);
+}
+
+/**
+ * @brief parallel infer engine
+ *
+ * State::isSafe() after inferring the state information again with
+ * multiple threads.
+ */
+static bool parallelInferEngine(const State& state, vector<int>& sequence)
+{
+  State copy = state;
+  copy.inferStateInformationParallel(3);
+  return copy.isSafe(sequence);
+}
+
+/**
+ * @brief partitioned engine
+ *
+ * partitionedIsSafe() with worker processes over Unix sockets.
+ */
+static bool partitionedEngine(const State& state, vector<int>& /* sequence */)
+{
+  return partitionedIsSafe(state, 3);
+}
+
+/**
+ * @brief external engine
+ *
+ * Out-of-core safety check, the state is written to an external
+ * state file and streamed back in blocks of 3 rows, so that most
+ * states span several double buffered blocks.
+ *
+ * @param state The state to check.
+ *
+ * @returns bool The verdict of the engine.
+ */
+static bool externalEngine(const State& state, vector<int>& /* sequence */)
+{
+  const string filename = "difftest-external.bin";
+  writeExternalState(state, filename);
+  ExternalSafetyChecker checker(filename, 3);
+  bool safe = checker.isSafe();
+  remove(filename.c_str());
+  return safe;
+}
+
+/**
+ * @brief packed engine
+ *
+ * PackedState::isSafe(), over frame-of-reference bit packed needs
+ * and allocations.
+ */
+static bool packedEngine(const State& state, vector<int>& sequence)
+{
+  PackedState packed(state);
+  return packed.isSafe(sequence);
+}
+
+/// @brief all of the engines checked against the reference
+static const DiffEngine engines[] = {
+  {"sequence", true, 1, sequenceEngine},
+  {"workspace", true, 1, workspaceEngine},
+  {"summary-tree", true, 1, summaryTreeEngine},
+  {"selector", false, 1, selectorEngine},
+  {"compact", true, 1, compactEngine},
+  {"incremental", true, 1, incrementalEngine},
+  {"parallel-infer", true, 7, parallelInferEngine},
+  {"partitioned", false, 997, partitionedEngine},
+  {"external", false, 11, externalEngine},
+  {"packed", true, 1, packedEngine},
+};
+
+/**
+ * @brief usage
+ *
+ * Usage information for invoking the differential tester with
+ * command line arguments.  Print usage information and exit with
+ * non success status to indicate error.
+ */
+void usage()
+{
+  cout << "Usage: difftest [cases] [seed]" << endl
+       << "Compare every safety engine against State::isSafe() on randomly" << endl
+       << "generated states." << endl
+       << endl
+       << "cases        The number of states to generate, default 100000." << endl
+       << "seed         The seed of the state generator, default 1." << endl;
+  exit(1);
+}
+
+/**
+ * @brief generate a case
+ *
+ * Generate a random state.  Shapes favor the widths with specialized
+ * kernels, and most states are made adversarial by leaving only a
+ * little slack between the total resources and what is allocated,
+ * so they sit close to the boundary between safe and unsafe.
+ *
+ * @param generator The seeded random generator.
+ *
+ * @returns DiffCase The generated state values.
+ */
+static DiffCase generateCase(mt19937& generator)
+{
+  const int widths[] = {1, 2, 3, 4, 8, 16, MAX_RESOURCES};
+  DiffCase diffCase;
+  diffCase.numProcesses = uniform_int_distribution<int>(1, MAX_PROCESSES)(generator);
+  diffCase.numResources = widths[uniform_int_distribution<int>(0, 6)(generator)];
+  int maxClaim = uniform_int_distribution<int>(1, 9)(generator);
+  int maxSlack = uniform_int_distribution<int>(0, 3)(generator);
+
+  int numCells = diffCase.numProcesses * diffCase.numResources;
+  diffCase.claims.resize(numCells);
+  diffCase.allocations.resize(numCells);
+  diffCase.total.assign(diffCase.numResources, 0);
+  for (int cell = 0; cell < numCells; cell++)
+  {
+    diffCase.claims[cell] = uniform_int_distribution<int>(0, maxClaim)(generator);
+    diffCase.allocations[cell] = uniform_int_distribution<int>(0, diffCase.claims[cell])(generator);
+    diffCase.total[cell % diffCase.numResources] += diffCase.allocations[cell];
+  }
+  for (int& total : diffCase.total)
+  {
+    total += uniform_int_distribution<int>(0, maxSlack)(generator);
+  }
+  return diffCase;
+}
+
+/**
+ * @brief valid sequence
+ *
+ * Check a safe sequence returned by an engine: it must not repeat a
+ * process, each process must be able to run when its turn comes, it
+ * must hold every process if the verdict is safe, and otherwise no
+ * process left out may be able to run at the end.
+ *
+ * @param state The state checked.
+ * @param safe The engine's verdict.
+ * @param sequence The engine's safe sequence.
+ *
+ * @returns bool true if the sequence is valid.
+ */
+static bool validSequence(const State& state, bool safe, const vector<int>& sequence)
+{
+  int currentAvailable[MAX_RESOURCES];
+  bool completed[MAX_PROCESSES] = {false};
+  for (int resource = 0; resource < state.getNumResources(); resource++)
+  {
+    currentAvailable[resource] = state.getResourceAvailable(resource);
+  }
+
+  for (int process : sequence)
+  {
+    if ((process < 0) or (process >= state.getNumProcesses()) or completed[process] or
+        not state.needsAreMet(process, currentAvailable))
+    {
+      return false;
+    }
+    state.releaseAllocatedResources(process, currentAvailable);
+    completed[process] = true;
+  }
+
+  bool complete = static_cast<int>(sequence.size()) == state.getNumProcesses();
+  return (safe == complete) and (state.findCandidateProcess(completed, currentAvailable) == NO_CANDIDATE);
+}
+
+/**
+ * @brief engine disagrees
+ *
+ * Run an engine on a case and compare it to the reference.
+ *
+ * @param engine The engine to run.
+ * @param diffCase The case to run it on.
+ *
+ * @returns bool true if the engine's verdict differs from the
+ *   reference or its safe sequence is invalid.
+ */
+static bool engineDisagrees(const DiffEngine& engine, const DiffCase& diffCase)
+{
+  State state;
+  state.loadState(diffCase.numProcesses, diffCase.numResources, diffCase.total, diffCase.claims, diffCase.allocations);
+
+  vector<int> sequence;
+  bool safe = engine.run(state, sequence);
+  if (safe != state.isSafe())
+  {
+    return true;
+  }
+  return engine.producesSequence and not validSequence(state, safe, sequence);
+}
+
+/**
+ * @brief minimize a counterexample
+ *
+ * Greedily shrink a case on which an engine disagrees with the
+ * reference, by dropping processes, dropping resources and lowering
+ * values, for as long as the engine keeps disagreeing.
+ *
+ * @param engine The engine that disagrees.
+ * @param diffCase The counterexample to minimize.
+ *
+ * @returns DiffCase A smaller case the engine still disagrees on.
+ */
+static DiffCase minimizeCase(const DiffEngine& engine, DiffCase diffCase)
+{
+  bool shrunk = true;
+  while (shrunk)
+  {
+    shrunk = false;
+
+    // try dropping each process (row), along with its allocations
+    for (int process = 0; process < diffCase.numProcesses and diffCase.numProcesses > 1; process++)
+    {
+      DiffCase smaller = diffCase;
+      int numResources = smaller.numResources;
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        smaller.total[resource] -= smaller.allocations[process * numResources + resource];
+      }
+      smaller.claims.erase(smaller.claims.begin() + process * numResources,
+        smaller.claims.begin() + (process + 1) * numResources);
+      smaller.allocations.erase(smaller.allocations.begin() + process * numResources,
+        smaller.allocations.begin() + (process + 1) * numResources);
+      smaller.numProcesses--;
+      if (engineDisagrees(engine, smaller))
+      {
+        diffCase = smaller;
+        shrunk = true;
+        process--;
+      }
+    }
+
+    // try dropping each resource (column)
+    for (int resource = 0; resource < diffCase.numResources and diffCase.numResources > 1; resource++)
+    {
+      DiffCase smaller = diffCase;
+      for (int process = smaller.numProcesses - 1; process >= 0; process--)
+      {
+        smaller.claims.erase(smaller.claims.begin() + process * smaller.numResources + resource);
+        smaller.allocations.erase(smaller.allocations.begin() + process * smaller.numResources + resource);
+      }
+      smaller.total.erase(smaller.total.begin() + resource);
+      smaller.numResources--;
+      if (engineDisagrees(engine, smaller))
+      {
+        diffCase = smaller;
+        shrunk = true;
+        resource--;
+      }
+    }
+
+    // try lowering each value one at a time
+    vector<int> DiffCase::*fields[] = {&DiffCase::total, &DiffCase::claims, &DiffCase::allocations};
+    for (vector<int> DiffCase::*field : fields)
+    {
+      for (size_t index = 0; index < (diffCase.*field).size(); index++)
+      {
+        while ((diffCase.*field)[index] > 0)
+        {
+          DiffCase smaller = diffCase;
+          (smaller.*field)[index]--;
+          if (not engineDisagrees(engine, smaller))
+          {
+            break;
+          }
+          diffCase = smaller;
+          shrunk = true;
+        }
+      }
+    }
+  }
+  return diffCase;
+}
+
+/**
+ * @brief case to string
+ *
+ * Format a case in the simulation file format, so that it can be
+ * saved and loaded by sim.
+ *
+ * @param diffCase The case to format.
+ *
+ * @returns string The case as a simulation file.
+ */
+static string caseToString(const DiffCase& diffCase)
+{
+  stringstream out;
+  out << "# number of processes / number of resources" << endl;
+  out << diffCase.numProcesses << " " << diffCase.numResources << endl << endl;
+  out << "# total Resources vector R" << endl;
+  for (int total : diffCase.total)
+  {
+    out << total << " ";
+  }
+  out << endl << endl;
+
+  const char* titles[] = {"# Claim matrix C", "# Allocation matrix A"};
+  const vector<int>* matrices[] = {&diffCase.claims, &diffCase.allocations};
+  for (int matrix = 0; matrix < 2; matrix++)
+  {
+    out << titles[matrix] << endl;
+    for (int process = 0; process < diffCase.numProcesses; process++)
+    {
+      for (int resource = 0; resource < diffCase.numResources; resource++)
+      {
+        out << (*matrices[matrix])[process * diffCase.numResources + resource] << " ";
+      }
+      out << endl;
+    }
+    out << endl;
+  }
+  return out.str();
+}
+
+/**
+ * @brief main entry point
+ *
+ * Entry point of the differential tester.  Generate the requested
+ * number of cases, run every engine on each, and report any
+ * minimized counterexamples.
+ *
+ * @param argc The command line argument count.
+ * @param argv[] The command line argument values, the optional
+ *   number of cases and seed.
+ *
+ * @return 0 is returned if every engine agreed with the reference
+ *   on every case, 1 otherwise.
+ */
+int main(int argc, char** argv)
+{
+  if (argc > 3)
+  {
+    usage();
+  }
+  long numCases = (argc > 1) ? atol(argv[1]) : 100000;
+  unsigned long seed = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 1;
+  if (numCases < 1)
+  {
+    usage();
+  }
+
+  mt19937 generator(seed);
+  int numEngines = sizeof(engines) / sizeof(engines[0]);
+  vector<long> numRuns(numEngines, 0);
+  long numSafe = 0;
+  int numFailures = 0;
+
+  try
+  {
+    for (long caseNumber = 0; caseNumber < numCases; caseNumber++)
+    {
+      DiffCase diffCase = generateCase(generator);
+      State state;
+      state.loadState(diffCase.numProcesses, diffCase.numResources, diffCase.total, diffCase.claims, diffCase.allocations);
+      numSafe += state.isSafe();
+
+      for (int engine = 0; engine < numEngines; engine++)
+      {
+        if (caseNumber % engines[engine].stride != 0)
+        {
+          continue;
+        }
+        numRuns[engine]++;
+        if (engineDisagrees(engines[engine], diffCase))
+        {
+          numFailures++;
+          cout << "engine " << engines[engine].name << " disagrees with isSafe() on case " << caseNumber
+               << ", minimized counterexample:" << endl;
+          cout << caseToString(minimizeCase(engines[engine], diffCase)) << endl;
+        }
+      }
+    }
+  }
+  catch (const SimulatorException& e)
+  {
+    cerr << "Differential test resulted in runtime error occurring:" << endl;
+    cerr << e.what() << endl;
+    exit(1);
+  }
+
+  cout << numCases << " cases (" << numSafe << " safe, " << numCases - numSafe << " unsafe), seed " << seed << endl;
+  for (int engine = 0; engine < numEngines; engine++)
+  {
+    cout << "  " << engines[engine].name << ": " << numRuns[engine] << " cases checked" << endl;
+  }
+  cout << (numFailures == 0 ? "All engines agree" : "Engine disagreements found") << endl;
+
+  return numFailures == 0 ? 0 : 1;
+}
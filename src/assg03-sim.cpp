@@ -10,10 +10,23 @@
  * Algorithm) deadlock avoidance Simulator, used to perform system
  * tests.
  */
+#include "ExternalSafety.hpp"
+#include "ModelChecker.hpp"
+#include "ParallelSimulation.hpp"
+#include "PartitionedSafety.hpp"
+#include "PolicySimulation.hpp"
+#include "SafetyEngine.hpp"
+#include "SafetyWorkspace.hpp"
 #include "SimulatorException.hpp"
 #include "State.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <unistd.h>
 using namespace std;
 
 /**
@@ -25,16 +38,176 @@ using namespace std;
  */
 void usage()
 {
-  cout << "Usage: sim state.sim" << endl
+  cout << "Usage: sim [--summary] [--explain] [--workers n] [--stream file] [--tuning file] [--trace]" << endl
+       << "           [--format-threads n] [--check] [--workload] [--external] state.sim" << endl
        << "Run Resource Allocation Denial (Banker's Algorithm) on simulation" << endl
        << "state file.  Return safe if the state is safe, or unsafe if not." << endl
        << endl
+       << "--summary    Display a summary of the resources and the top" << endl
+       << "             processes instead of the full state matrices, for" << endl
+       << "             states too large to display." << endl
+       << "--explain    When the state is unsafe, display the blocked" << endl
+       << "             processes, their shortfall of each resource and" << endl
+       << "             the bottleneck resources holding them back." << endl
+       << "--workers n  Check if the state is safe by partitioning the" << endl
+       << "             processes across n worker processes." << endl
+       << "--format-threads n" << endl
+       << "             Format the state display with n threads, and write" << endl
+       << "             it to standard output with vectored I/O." << endl
+       << "--stream f   Load the claims and total resources of state.sim" << endl
+       << "             once, then stream allocation-only snapshots from" << endl
+       << "             file f (- for standard input) and report a verdict" << endl
+       << "             for each snapshot." << endl
+       << "--tuning f   Check if the state is safe with the fastest safety" << endl
+       << "             engine for its shape, as profiled in tuning file f." << endl
+       << "             If f does not exist yet the engines are profiled" << endl
+       << "             on this host and the results are saved to f." << endl
+       << "--trace      The file is a job trace rather than a state, compare" << endl
+       << "             the throughput and utilization of Resource Allocation" << endl
+       << "             Denial and Process Initiation Denial on the trace." << endl
+       << "--check      The file is a process script rather than a state," << endl
+       << "             explore every interleaving of the script with and" << endl
+       << "             without Resource Allocation Denial, and display a" << endl
+       << "             shortest trace to deadlock if one is reachable.  The" << endl
+       << "             search uses the number of threads given by --workers." << endl
+       << "--workload   The file is a capacity planning workload rather than" << endl
+       << "             a state, simulate it under both Resource Allocation" << endl
+       << "             Denial and Process Initiation Denial, with resource" << endl
+       << "             groups partitioned across the number of threads given" << endl
+       << "             by --workers." << endl
+       << "--external   The file is an external state file of need and" << endl
+       << "             allocation rows, check if it is safe by streaming" << endl
+       << "             the rows rather than loading the state into memory." << endl
        << endl
        << "state.sim    Filename describing system state to load and" << endl
        << "             test if it is safe or unsafe." << endl;
   exit(1);
 }
 
+/**
+ * @brief stream snapshots
+ *
+ * Evaluate a stream of allocation-only snapshots against the claims
+ * and total resources of an already loaded state, reporting one
+ * verdict line per snapshot as soon as it has been read.  Snapshots
+ * that give negative needs or available resources are reported as
+ * invalid, rather than given a meaningless verdict.
+ *
+ * @param state The loaded state, whose allocations are replaced by
+ *   each snapshot in turn.
+ * @param streamFileName The file to read the snapshots from, or "-"
+ *   to read them from standard input.
+ *
+ * @throws SimulatorException is thrown if the snapshot file can not
+ *   be opened or holds a malformed snapshot.
+ */
+void streamSnapshots(State& state, const string& streamFileName)
+{
+  ifstream streamFile;
+  if (streamFileName != "-")
+  {
+    streamFile.open(streamFileName);
+    if (not streamFile.is_open())
+    {
+      stringstream msg;
+      msg << "<streamSnapshots> File not found, could not open snapshot file:" << streamFileName << endl;
+      throw SimulatorException(msg.str());
+    }
+  }
+  istream& snapshots = (streamFileName == "-") ? cin : streamFile;
+
+  SafetyWorkspace workspace;
+  for (int snapshot = 0; state.loadAllocationSnapshot(snapshots); snapshot++)
+  {
+    cout << "Snapshot " << snapshot << ": ";
+    if (state.getNumNegativeValues() > 0)
+    {
+      cout << "State is invalid" << endl;
+    }
+    else if (state.isSafe(workspace))
+    {
+      cout << "State is safe" << endl;
+    }
+    else
+    {
+      cout << "State is unsafe" << endl;
+    }
+  }
+}
+
+/**
+ * @brief compare policies
+ *
+ * Simulate a trace of jobs under both Resource Allocation Denial and
+ * Process Initiation Denial, and display how each policy performed.
+ *
+ * @param traceFileName The job trace file to simulate.
+ *
+ * @throws SimulatorException is thrown if the trace can not be loaded.
+ */
+void comparePolicies(const string& traceFileName)
+{
+  PolicyTrace trace = loadPolicyTrace(traceFileName);
+  cout << "Policy comparison of " << trace.jobs.size() << " jobs over " << trace.total.size() << " resources" << endl;
+
+  AdmissionPolicy policies[] = {RESOURCE_ALLOCATION_DENIAL, PROCESS_INITIATION_DENIAL};
+  for (AdmissionPolicy policy : policies)
+  {
+    cout << policyResultToString(policy, simulatePolicy(trace, policy));
+  }
+}
+
+/**
+ * @brief check protocol
+ *
+ * Model check a process script both without deadlock avoidance and
+ * with Resource Allocation Denial, and display whether a deadlock is
+ * reachable under each.
+ *
+ * @param scriptFileName The process script file to check.
+ * @param numThreads The number of threads to explore states with.
+ *
+ * @throws SimulatorException is thrown if the script can not be
+ *   loaded or checked.
+ */
+void checkProtocol(const string& scriptFileName, int numThreads)
+{
+  ProcessScript script = loadProcessScript(scriptFileName);
+  cout << "Model check of " << script.steps.size() << " process scripts over " << script.total.size() << " resources"
+       << endl;
+
+  cout << endl << "Without deadlock avoidance:" << endl;
+  cout << modelCheckResultToString(ModelChecker(script, false, numThreads).check());
+  cout << endl << "With Resource Allocation Denial:" << endl;
+  cout << modelCheckResultToString(ModelChecker(script, true, numThreads).check());
+}
+
+/**
+ * @brief compare workload policies
+ *
+ * Simulate a capacity planning workload under both Resource
+ * Allocation Denial and Process Initiation Denial, and display how
+ * each policy performed.
+ *
+ * @param workloadFileName The workload file to simulate.
+ * @param numThreads The number of threads to simulate with.
+ *
+ * @throws SimulatorException is thrown if the workload can not be
+ *   loaded.
+ */
+void compareWorkloadPolicies(const string& workloadFileName, int numThreads)
+{
+  Workload workload = loadWorkload(workloadFileName);
+  cout << "Workload simulation of " << workload.jobs.size() << " jobs over " << workload.groupTotal.size()
+       << " resource groups" << endl;
+
+  AdmissionPolicy policies[] = {RESOURCE_ALLOCATION_DENIAL, PROCESS_INITIATION_DENIAL};
+  for (AdmissionPolicy policy : policies)
+  {
+    cout << workloadResultToString(policy, simulateWorkload(workload, policy, numThreads));
+  }
+}
+
 /**
  * @brief main entry point
  *
@@ -45,10 +218,10 @@ void usage()
  * load the indicated simulation events file, and run the simulation.
  *
  * @param argc The command line argument count.  This program requires
- *   3 command line arguments to run.
- * @param argv[] The command line argument values.  argv[1] should be
- *   the system timeSliceQuantum, and argv[2] should be the simulation
- *   file to be loaded and executed.
+ *   the simulation file argument, optionally preceeded by options.
+ * @param argv[] The command line argument values.  The last argument
+ *   should be the simulation state file to be loaded and tested, any
+ *   arguments before it are options.
  *
  * @return 0 is returned if simulation finishes successfully with no errors
  *   or exceptions.  A non-zero value is returned when an exception occurs
@@ -59,22 +232,167 @@ int main(int argc, char** argv)
   // parse command line arguments
   // if we do not get required command line arguments, print usage
   // and exit immediately.
-  if (argc != 2)
+  bool summary = false;
+  bool explain = false;
+  int numWorkers = 0;
+  int numFormatThreads = 0;
+  string streamFileName;
+  bool trace = false;
+  bool check = false;
+  bool workload = false;
+  bool external = false;
+  string tuningFileName;
+  int arg = 1;
+  while (arg < argc - 1)
+  {
+    string option = string(argv[arg++]);
+    if (option == "--summary")
+    {
+      summary = true;
+    }
+    else if (option == "--explain")
+    {
+      explain = true;
+    }
+    else if (option == "--workers" and arg < argc - 1)
+    {
+      numWorkers = atoi(argv[arg++]);
+    }
+    else if (option == "--format-threads" and arg < argc - 1)
+    {
+      numFormatThreads = atoi(argv[arg++]);
+    }
+    else if (option == "--trace")
+    {
+      trace = true;
+    }
+    else if (option == "--check")
+    {
+      check = true;
+    }
+    else if (option == "--external")
+    {
+      external = true;
+    }
+    else if (option == "--workload")
+    {
+      workload = true;
+    }
+    else if (option == "--tuning" and arg < argc - 1)
+    {
+      tuningFileName = string(argv[arg++]);
+    }
+    else if (option == "--stream" and arg < argc - 1)
+    {
+      streamFileName = string(argv[arg++]);
+    }
+    else
+    {
+      usage();
+    }
+  }
+  if (arg != argc - 1)
   {
     usage();
   }
 
-  string stateFileName = string(argv[1]);
+  string stateFileName = string(argv[arg]);
 
   // create a State, load the file, and test if the state is safe
   // or unsafe
   State state;
-  state.loadState(stateFileName);
 
   try
   {
-    cout << state << endl;
-    // need to invoke the isSafe() method here and display the resul
+    if (trace)
+    {
+      comparePolicies(stateFileName);
+      return 0;
+    }
+
+    if (external)
+    {
+      ExternalSafetyChecker checker(stateFileName);
+      cout << "External state of " << checker.getNumProcesses() << " processes and " << checker.getNumResources()
+           << " resources" << endl;
+      bool safe = checker.isSafe();
+      cout << "State is " << (safe ? "safe" : "unsafe") << " after " << checker.getNumPasses() << " passes" << endl;
+      return 0;
+    }
+
+    if (workload)
+    {
+      compareWorkloadPolicies(stateFileName, max(numWorkers, 1));
+      return 0;
+    }
+
+    if (check)
+    {
+      checkProtocol(stateFileName, max(numWorkers, 1));
+      return 0;
+    }
+
+    state.loadState(stateFileName);
+
+    if (not streamFileName.empty())
+    {
+      streamSnapshots(state, streamFileName);
+      return 0;
+    }
+
+    if (summary)
+    {
+      cout << state.summaryString();
+    }
+    else if (numFormatThreads > 0)
+    {
+      cout.flush();
+      state.writeState(STDOUT_FILENO, numFormatThreads);
+      cout << endl;
+    }
+    else
+    {
+      cout << state << endl;
+    }
+
+    vector<int> safeSequence;
+    UnsafeCertificate certificate;
+    bool safe = false;
+    if (explain)
+    {
+      safe = state.isSafe(safeSequence, certificate);
+    }
+    else if (not tuningFileName.empty())
+    {
+      EngineSelector selector;
+      if (ifstream(tuningFileName).is_open())
+      {
+        selector.loadTuning(tuningFileName);
+      }
+      else
+      {
+        selector.tune();
+        selector.saveTuning(tuningFileName);
+      }
+      safe = selector.isSafe(state);
+    }
+    else
+    {
+      safe = (numWorkers > 0) ? partitionedIsSafe(state, numWorkers) : state.isSafe();
+    }
+
+    if (safe)
+    {
+      cout << "State is safe" << endl;
+    }
+    else
+    {
+      cout << "State is unsafe" << endl;
+      if (explain)
+      {
+        cout << endl << certificateToString(certificate);
+      }
+    }
   }
   catch (const SimulatorException& e)
   {
@@ -12,9 +12,34 @@
  * loading of system state, modifying state, and determing if a state
  * is safe or not to make the allow/deny decision.
  */
+#include "AdmissionActor.hpp"
+#include "CompactState.hpp"
+#include "ExternalSafety.hpp"
+#include "ModelChecker.hpp"
+#include "ParallelSimulation.hpp"
+#include "NeedSummaryTree.hpp"
+#include "PackedState.hpp"
+#include "PartitionedSafety.hpp"
+#include "PolicySimulation.hpp"
+#include "Replication.hpp"
+#include "ResourceKernels.hpp"
+#include "SafetyEngine.hpp"
+#include "SafetyWorkspace.hpp"
 #include "SimulatorException.hpp"
+#include "SocketIO.hpp"
 #include "State.hpp"
+#include "StateArchive.hpp"
+#include "VectorOps.hpp"
 #include "catch.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
 
 using namespace std;
 
@@ -634,3 +659,1822 @@ TEST_CASE("Task 4: isSafe() member function", "[task4]")
   }
 }
 #endif
+
+/**
+ * @brief width specialized resource kernel tests
+ */
+TEST_CASE("Test width specialized resource kernels", "[kernels]")
+{
+  SECTION("Test kernel selection for common and uncommon widths", "[kernels]")
+  {
+    CHECK(selectResourceKernels(4)->width == 4);
+    CHECK(selectResourceKernels(8)->width == 8);
+    CHECK(selectResourceKernels(16)->width == 16);
+    CHECK(selectResourceKernels(0)->width == 0);
+    CHECK(selectResourceKernels(3)->width == 0);
+    CHECK(selectResourceKernels(MAX_RESOURCES)->width == 0);
+  }
+
+  SECTION("Test specialized kernels agree with the generic kernels", "[kernels]")
+  {
+    int widths[] = {4, 8, 16};
+    for (int width : widths)
+    {
+      const ResourceKernels* kernels = selectResourceKernels(width);
+      int need[MAX_RESOURCES];
+      int available[MAX_RESOURCES];
+      for (int resource = 0; resource < width; resource++)
+      {
+        need[resource] = resource % 3;
+        available[resource] = 2;
+      }
+      CHECK(kernels->needsAreMet(width, need, available) == genericNeedsAreMet(width, need, available));
+      CHECK(kernels->needsAreMet(width, need, available));
+
+      // one need in the last column that can not be met
+      need[width - 1] = 3;
+      CHECK(kernels->needsAreMet(width, need, available) == genericNeedsAreMet(width, need, available));
+      CHECK_FALSE(kernels->needsAreMet(width, need, available));
+
+      int copied[MAX_RESOURCES];
+      kernels->copy(width, need, copied);
+      kernels->accumulate(width, available, copied);
+      for (int resource = 0; resource < width; resource++)
+      {
+        CHECK(copied[resource] == need[resource] + 2);
+      }
+    }
+  }
+
+  SECTION("Test states using specialized kernels", "[kernels]")
+  {
+    State s;
+    s.loadState("simfiles/state-06.sim");
+    CHECK(s.getNumResources() == 4);
+
+    int currentAvailable[] = {1, 3, 1, 2};
+    CHECK_FALSE(s.needsAreMet(0, currentAvailable));
+    CHECK(s.needsAreMet(1, currentAvailable));
+
+    bool completed[] = {false, false, false, false, false};
+    CHECK(s.findCandidateProcess(completed, currentAvailable) == 1);
+    s.releaseAllocatedResources(1, currentAvailable);
+    CHECK(currentAvailable[0] == 3);
+    CHECK(currentAvailable[1] == 4);
+    CHECK(currentAvailable[2] == 2);
+    CHECK(currentAvailable[3] == 3);
+    CHECK(s.isSafe());
+  }
+}
+
+/**
+ * @brief serial and parallel inferStateInformation() tests
+ */
+TEST_CASE("Test State inferStateInformation() serial and parallel", "[infer]")
+{
+  State s;
+
+  SECTION("Test parallel inference matches serial inference", "[infer]")
+  {
+    const char* files[] = {"simfiles/state-01.sim", "simfiles/state-03.sim", "simfiles/state-06.sim"};
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      string serial = s.tostring();
+      bool serialSafe = s.isSafe();
+      for (int numThreads = 1; numThreads <= 8; numThreads++)
+      {
+        s.inferStateInformationParallel(numThreads);
+        CHECK(s.tostring() == serial);
+        CHECK(s.isSafe() == serialSafe);
+        CHECK(s.getNumNegativeValues() == 0);
+      }
+    }
+  }
+
+  SECTION("Test negative need and available values are flagged", "[infer]")
+  {
+    s.loadState("simfiles/state-07.sim");
+    CHECK(s.getNumNegativeValues() == 2);
+    s.inferStateInformationParallel(2);
+    CHECK(s.getNumNegativeValues() == 2);
+
+    // reloading a valid state clears the flags
+    s.loadState("simfiles/state-01.sim");
+    CHECK(s.getNumNegativeValues() == 0);
+  }
+}
+
+/**
+ * @brief State validateState() tests
+ */
+TEST_CASE("Test State validateState() functionality", "[validate]")
+{
+  State s;
+
+  SECTION("Test valid states have no violations", "[validate]")
+  {
+    const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-05.sim", "simfiles/state-06.sim"};
+    for (const char* file : files)
+    {
+      s.loadState(file, true);
+      CHECK(s.validateState().empty());
+    }
+  }
+
+  SECTION("Test all violations are reported with coordinates", "[validate]")
+  {
+    s.loadState("simfiles/state-07.sim");
+    vector<StateViolation> violations = s.validateState();
+    REQUIRE(violations.size() == 2);
+    CHECK(violations[0].type == ALLOCATION_EXCEEDS_CLAIM);
+    CHECK(violations[0].process == 0);
+    CHECK(violations[0].resource == 0);
+    CHECK(violations[0].value == -1);
+    CHECK(violations[1].type == RESOURCE_OVERSUBSCRIBED);
+    CHECK(violations[1].process == NO_CANDIDATE);
+    CHECK(violations[1].resource == 0);
+    CHECK(violations[1].value == -1);
+    CHECK(violationToString(violations[0]) == "allocation exceeds claim, need = -1 at P0 R0");
+    CHECK(violationToString(violations[1]) == "resource oversubscribed, available = -1 at R0");
+  }
+
+  SECTION("Test strict mode stops at the first violation", "[validate]")
+  {
+    s.loadState("simfiles/state-07.sim");
+    CHECK(s.validateState(true).size() == 1);
+    CHECK_THROWS_AS(s.loadState("simfiles/state-07.sim", true), SimulatorException);
+    CHECK(s.getNumProcesses() == 0);
+    CHECK(s.getNumResources() == 0);
+    CHECK(s.validateState(true).empty());
+  }
+}
+
+/**
+ * @brief State diff() and applyDelta() tests
+ */
+TEST_CASE("Test State diff() and applyDelta() functionality", "[delta]")
+{
+  State s1;
+  s1.loadState("simfiles/state-01.sim");
+  State s2;
+  s2.loadState("simfiles/state-02.sim");
+
+  SECTION("Test isSafe() returns a safe sequence", "[delta]")
+  {
+    vector<int> safeSequence;
+    CHECK(s1.isSafe(safeSequence));
+    CHECK(safeSequence == vector<int>({1, 0, 2, 3}));
+    CHECK_FALSE(s2.isSafe(safeSequence));
+    CHECK(safeSequence.empty());
+  }
+
+  SECTION("Test diff of two snapshots is sparse", "[delta]")
+  {
+    StateDelta delta = s1.diff(s2);
+    // P0 and P1 each changed R0 and R2 allocations
+    REQUIRE(delta.cells.size() == 4);
+    CHECK(delta.cells[0].process == 0);
+    CHECK(delta.cells[0].resource == 0);
+    CHECK(delta.cells[0].claimDelta == 0);
+    CHECK(delta.cells[0].allocationDelta == 1);
+    CHECK(delta.cells[3].process == 1);
+    CHECK(delta.cells[3].resource == 2);
+    CHECK(delta.cells[3].allocationDelta == -1);
+    CHECK(delta.totals.empty());
+    CHECK(s1.diff(s1).cells.empty());
+
+    State s3;
+    s3.loadState("simfiles/state-03.sim");
+    CHECK_THROWS_AS(s1.diff(s3), SimulatorException);
+  }
+
+  SECTION("Test applying deltas matches loading the snapshots", "[delta]")
+  {
+    vector<int> safeSequence;
+    CHECK(s1.isSafe(safeSequence));
+    StateDelta forward = s1.diff(s2);
+    StateDelta backward = s2.diff(s1);
+
+    CHECK_FALSE(s1.applyDelta(forward, safeSequence));
+    CHECK(s1.tostring() == s2.tostring());
+    CHECK(s1.isSafe() == s2.isSafe());
+
+    CHECK(s1.applyDelta(backward, safeSequence));
+    CHECK(safeSequence.size() == 4);
+    CHECK(s1.isSafe());
+
+    // growing a resource total keeps the state safe with the same
+    // sequence, shrinking it too far makes it unsafe
+    StateDelta grow;
+    grow.totals.push_back({0, 2});
+    CHECK(s1.applyDelta(grow, safeSequence));
+    CHECK(safeSequence == vector<int>({1, 0, 2, 3}));
+    StateDelta shrink;
+    shrink.totals.push_back({2, -1});
+    CHECK_FALSE(s1.applyDelta(shrink, safeSequence));
+    CHECK(s1.getNumNegativeValues() == 0);
+  }
+
+  SECTION("Test rejected deltas leave the state untouched", "[delta]")
+  {
+    // a valid change followed by a cell, then a total, out of bounds
+    string state01String = s1.tostring();
+    int numNonzeroNeeds = s1.getNumNonzeroNeeds();
+    StateDelta badCell = s1.diff(s2);
+    badCell.cells.push_back({4, 0, 1, 1});
+    CHECK_THROWS_AS(s1.applyDelta(badCell), SimulatorException);
+    CHECK(s1.tostring() == state01String);
+
+    StateDelta badTotal = s1.diff(s2);
+    badTotal.totals.push_back({0, 1});
+    badTotal.totals.push_back({3, 1});
+    CHECK_THROWS_AS(s1.applyDelta(badTotal), SimulatorException);
+    CHECK(s1.tostring() == state01String);
+    CHECK(s1.getNumNonzeroNeeds() == numNonzeroNeeds);
+    CHECK(s1.getNumNegativeValues() == 0);
+  }
+}
+
+/**
+ * @brief StateArchiveWriter and StateArchiveReader tests
+ */
+TEST_CASE("Test keyframe and delta state archives", "[archive]")
+{
+  SECTION("Test varint and zigzag encoding round trips", "[archive]")
+  {
+    int64_t values[] = {0, 1, -1, 63, -64, 64, 300, -300, 2147483647, -2147483648LL};
+    string buffer;
+    for (int64_t value : values)
+    {
+      writeVarint(buffer, zigzagEncode(value));
+    }
+    CHECK(zigzagEncode(-1) == 1);
+    CHECK(zigzagEncode(1) == 2);
+
+    const char* in = buffer.data();
+    for (int64_t value : values)
+    {
+      CHECK(zigzagDecode(readVarint(in, buffer.data() + buffer.size())) == value);
+    }
+    CHECK(in == buffer.data() + buffer.size());
+    CHECK_THROWS_AS(readVarint(in, buffer.data() + buffer.size()), SimulatorException);
+  }
+
+  SECTION("Test every snapshot of a series is reconstructed", "[archive]")
+  {
+    State s1;
+    s1.loadState("simfiles/state-01.sim");
+    State s2;
+    s2.loadState("simfiles/state-02.sim");
+
+    // build a series of snapshots, moving between state 01 and 02
+    // and growing one of the resource totals
+    vector<State> series;
+    State snapshot = s1;
+    StateDelta grow;
+    grow.totals.push_back({1, 1});
+    for (int index = 0; index < 7; index++)
+    {
+      series.push_back(snapshot);
+      snapshot.applyDelta(index % 2 == 0 ? s1.diff(s2) : s2.diff(s1));
+      snapshot.applyDelta(grow);
+    }
+
+    string filename = "state-archive-test.sima";
+    {
+      StateArchiveWriter writer(filename, 3);
+      for (const State& state : series)
+      {
+        writer.append(state);
+      }
+      CHECK(writer.getNumSnapshots() == 7);
+
+      State s3;
+      s3.loadState("simfiles/state-03.sim");
+      CHECK_THROWS_AS(writer.append(s3), SimulatorException);
+    }
+
+    StateArchiveReader reader(filename);
+    REQUIRE(reader.getNumSnapshots() == 7);
+    State state;
+    // read them out of order, to seek back and forth in the archive
+    int order[] = {6, 0, 4, 1, 5, 3, 2};
+    for (int index : order)
+    {
+      reader.readSnapshot(index, state);
+      CHECK(state.tostring() == series[index].tostring());
+      CHECK(state.isSafe() == series[index].isSafe());
+    }
+    CHECK_THROWS_AS(reader.readSnapshot(7, state), SimulatorException);
+    remove(filename.c_str());
+
+    CHECK_THROWS_AS(StateArchiveReader("simfiles/state-01.sim"), SimulatorException);
+  }
+
+  SECTION("Test corrupt archives and encoded states are rejected", "[archive]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    string filename = "state-archive-test.sima";
+    {
+      StateArchiveWriter writer(filename, 3);
+      writer.append(s);
+    }
+
+    // zero the keyframe interval, which follows the 4 byte magic
+    {
+      fstream archive(filename, ios::binary | ios::in | ios::out);
+      archive.seekp(4);
+      archive.write("\0\0\0\0", 4);
+    }
+    CHECK_THROWS_AS(StateArchiveReader(filename), SimulatorException);
+    remove(filename.c_str());
+
+    // trailers whose snapshot count or index offset do not match the
+    // size of the file, the trailer is the last 20 bytes
+    auto corruptTrailer = [&s, &filename](int position, uint64_t value) {
+      {
+        StateArchiveWriter writer(filename, 3);
+        writer.append(s);
+        writer.append(s);
+      }
+      fstream archive(filename, ios::binary | ios::in | ios::out);
+      archive.seekp(-20 + position, ios::end);
+      for (int byte = 0; byte < 8; byte++)
+      {
+        archive.put(static_cast<char>((value >> (8 * byte)) & 0xff));
+      }
+    };
+    corruptTrailer(0, 3);
+    CHECK_THROWS_AS(StateArchiveReader(filename), SimulatorException);
+    corruptTrailer(0, uint64_t(1) << 40);
+    CHECK_THROWS_AS(StateArchiveReader(filename), SimulatorException);
+    corruptTrailer(8, 4);
+    CHECK_THROWS_AS(StateArchiveReader(filename), SimulatorException);
+    corruptTrailer(8, uint64_t(1) << 62);
+    CHECK_THROWS_AS(StateArchiveReader(filename), SimulatorException);
+    corruptTrailer(0, 2);
+    {
+      StateArchiveReader reader(filename);
+      CHECK(reader.getNumSnapshots() == 2);
+    }
+
+    // truncate the delta of the second snapshot, the 3 bytes before
+    // its index, to one cell with no claim or allocation change, a
+    // failed read must leave the state it was reading into untouched
+    {
+      fstream archive(filename, ios::binary | ios::in | ios::out);
+      archive.seekp(-20 - 16 - 3, ios::end);
+      archive.write("D\x01\x40", 3);
+    }
+    StateArchiveReader reader(filename);
+    State target;
+    target.loadState("simfiles/state-02.sim");
+    string state02String = target.tostring();
+    CHECK_THROWS_AS(reader.readSnapshot(1, target), SimulatorException);
+    CHECK(target.tostring() == state02String);
+    reader.readSnapshot(0, target);
+    CHECK(target.tostring() == s.tostring());
+    remove(filename.c_str());
+
+    // a negative number of processes, then resources
+    string negativeProcesses;
+    writeVarint(negativeProcesses, static_cast<uint32_t>(-1));
+    writeVarint(negativeProcesses, 3);
+    const char* in = negativeProcesses.data();
+    CHECK_THROWS_AS(decodeState(in, in + negativeProcesses.size(), s), SimulatorException);
+
+    string negativeResources;
+    writeVarint(negativeResources, 2);
+    writeVarint(negativeResources, static_cast<uint32_t>(-5));
+    in = negativeResources.data();
+    CHECK_THROWS_AS(decodeState(in, in + negativeResources.size(), s), SimulatorException);
+  }
+
+  SECTION("Test archive write errors are reported without terminating", "[archive]")
+  {
+    // /dev/full fails every write once the stream buffer is flushed,
+    // the failing append throws and the writer is then destroyed
+    // during the unwind with a failed stream
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    auto appendUntilFull = [&s]() {
+      StateArchiveWriter writer("/dev/full", 1);
+      for (int snapshot = 0; snapshot < 100000; snapshot++)
+      {
+        writer.append(s);
+      }
+    };
+    CHECK_THROWS_AS(appendUntilFull(), SimulatorException);
+
+    StateArchiveWriter writer("/dev/full");
+    writer.append(s);
+    CHECK_THROWS_AS(writer.close(), SimulatorException);
+  }
+}
+
+/**
+ * @brief State summaryString() tests
+ */
+TEST_CASE("Test State summaryString() functionality", "[summary]")
+{
+  State s;
+  s.loadState("simfiles/state-01.sim");
+
+  string state01Summary = "State summary: 4 processes, 3 resources\n"
+                          "\n"
+                          "Resource vector R\n"
+                          "    R0  R1  R2  \n"
+                          "    9   3   6   \n"
+                          "\n"
+                          "Allocated vector\n"
+                          "    R0  R1  R2  \n"
+                          "    9   2   5   \n"
+                          "\n"
+                          "Available vector V\n"
+                          "    R0  R1  R2  \n"
+                          "    0   1   1   \n"
+                          "\n"
+                          "Blocked processes per resource\n"
+                          "    R0  R1  R2  \n"
+                          "    3   2   2   \n"
+                          "\n"
+                          "Top 2 processes by need\n"
+                          "P0  6\n"
+                          "P3  6\n"
+                          "\n"
+                          "Top 2 processes by allocation held\n"
+                          "P1  9\n"
+                          "P2  4\n"
+                          "\n";
+  CHECK(s.summaryString(2) == state01Summary);
+
+  // asking for more than there are processes lists them all
+  string summary = s.summaryString();
+  CHECK(summary.find("Top 4 processes by need\nP0  6\nP3  6\nP2  4\nP1  1\n") != string::npos);
+}
+
+/**
+ * @brief partitionedIsSafe() tests
+ */
+TEST_CASE("Test partitioned multi-process safety check", "[partitioned]")
+{
+  const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+    "simfiles/state-05.sim", "simfiles/state-06.sim"};
+  State s;
+  for (const char* file : files)
+  {
+    s.loadState(file);
+    for (int numWorkers = 1; numWorkers <= 4; numWorkers++)
+    {
+      CHECK(partitionedIsSafe(s, numWorkers) == s.isSafe());
+    }
+  }
+
+  // a worker count below one still checks the state with one worker
+  s.loadState("simfiles/state-02.sim");
+  REQUIRE_FALSE(s.isSafe());
+  CHECK_FALSE(partitionedIsSafe(s, 0));
+  CHECK_FALSE(partitionedIsSafe(s, -3));
+}
+
+/**
+ * @brief State requestResources() and releaseResources() tests
+ */
+TEST_CASE("Test State requestResources() and releaseResources()", "[request]")
+{
+  State s;
+  s.loadState("simfiles/state-01.sim");
+  string state01String = s.tostring();
+
+  SECTION("Test requests leading to unsafe states are denied", "[request]")
+  {
+    // granting P0 the last R2 leaves no process able to complete
+    int request[] = {0, 0, 1};
+    CHECK_FALSE(s.requestResources(0, request));
+    CHECK(s.tostring() == state01String);
+  }
+
+  SECTION("Test requests that can not be met right now are denied", "[request]")
+  {
+    int request[] = {1, 0, 0};
+    CHECK_FALSE(s.requestResources(2, request));
+    CHECK(s.tostring() == state01String);
+  }
+
+  SECTION("Test safe requests are granted and can be released", "[request]")
+  {
+    int request[] = {0, 0, 1};
+    CHECK(s.requestResources(1, request));
+    CHECK(s.getAllocation(1, 2) == 3);
+    CHECK(s.getNeed(1, 2) == 0);
+    CHECK(s.getResourceAvailable(2) == 0);
+    CHECK(s.isSafe());
+
+    s.releaseResources(1, request);
+    CHECK(s.tostring() == state01String);
+  }
+
+  SECTION("Test requests beyond need and releases beyond allocation throw", "[request]")
+  {
+    int tooMuch[] = {0, 0, 2};
+    CHECK_THROWS_AS(s.requestResources(1, tooMuch), SimulatorException);
+    int release[] = {2, 0, 0};
+    CHECK_THROWS_AS(s.releaseResources(0, release), SimulatorException);
+    CHECK_THROWS_AS(s.releaseResources(4, release), SimulatorException);
+    CHECK(s.tostring() == state01String);
+  }
+}
+
+/**
+ * @brief ReplicationPrimary and ReplicationStandby tests
+ */
+TEST_CASE("Test primary/backup replication by log shipping", "[replication]")
+{
+  State primaryState;
+  primaryState.loadState("simfiles/state-03.sim");
+
+  int sockets[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  ReplicationStandby standby(sockets[1]);
+  thread standbyThread([&standby]() {
+    while (standby.receiveBatch())
+    {
+    }
+  });
+
+  {
+    ReplicationPrimary primary(primaryState, sockets[0]);
+    int request[] = {1, 0, 0, 0};
+    int denied = 0;
+    for (int round = 0; round < 20; round++)
+    {
+      for (int process = 0; process < primaryState.getNumProcesses(); process++)
+      {
+        // request one unit of the resource a process needs most
+        request[0] = request[1] = request[2] = request[3] = 0;
+        int resource = (process + round) % primaryState.getNumResources();
+        if (primaryState.getNeed(process, resource) > 0)
+        {
+          request[resource] = 1;
+          if (not primary.requestResources(process, request))
+          {
+            denied++;
+          }
+        }
+        else if (primaryState.getAllocation(process, resource) > 0)
+        {
+          request[resource] = 1;
+          primary.releaseResources(process, request);
+        }
+      }
+    }
+    CHECK(primary.flush());
+    CHECK(primaryState.isSafe());
+    CHECK(denied > 0);
+  }
+  standbyThread.join();
+
+  CHECK(standby.getNumApplied() > 1);
+  CHECK(standby.getState().tostring() == primaryState.tostring());
+}
+
+/**
+ * @brief Unix socket path helper tests
+ */
+TEST_CASE("Test Unix domain socket helpers", "[replication]")
+{
+  string path = "socket-io-test.sock";
+  int listener = listenUnixSocket(path);
+  int client = connectUnixSocket(path);
+  int server = acceptUnixSocket(listener);
+
+  int sent[] = {1, -2, 3};
+  int received[3];
+  CHECK(writeBytes(client, sent, sizeof(sent)));
+  CHECK(readBytes(server, received, sizeof(received)));
+  CHECK(received[1] == -2);
+
+  close(client);
+  CHECK_FALSE(readBytes(server, received, sizeof(received)));
+  close(server);
+  close(listener);
+  remove(path.c_str());
+  CHECK_THROWS_AS(connectUnixSocket(path), SimulatorException);
+}
+
+/**
+ * @brief AdmissionQueue and AdmissionActor tests
+ */
+TEST_CASE("Test lock free admission queue and admission actor", "[actor]")
+{
+  SECTION("Test items from many producers are all popped in order", "[actor]")
+  {
+    AdmissionQueue queue;
+    CHECK(queue.pop() == nullptr);
+
+    const int numProducers = 4;
+    const int numItems = 1000;
+    vector<AdmissionItem> items(numProducers * numItems);
+    vector<thread> producers;
+    for (int producer = 0; producer < numProducers; producer++)
+    {
+      producers.push_back(thread([&items, &queue, producer]() {
+        for (int item = 0; item < numItems; item++)
+        {
+          items[producer * numItems + item].process = producer;
+          items[producer * numItems + item].resources[0] = item;
+          queue.push(&items[producer * numItems + item]);
+        }
+      }));
+    }
+
+    // each producer's items must come out in the order pushed
+    vector<int> nextItem(numProducers, 0);
+    int numPopped = 0;
+    while (numPopped < numProducers * numItems)
+    {
+      AdmissionItem* item = queue.pop();
+      if (item != nullptr)
+      {
+        CHECK(item->resources[0] == nextItem[item->process]);
+        nextItem[item->process]++;
+        numPopped++;
+      }
+    }
+    for (thread& producer : producers)
+    {
+      producer.join();
+    }
+    CHECK(queue.pop() == nullptr);
+  }
+
+  SECTION("Test the actor admits requests like the state itself", "[actor]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    AdmissionActor actor(s);
+
+    int request[] = {0, 0, 1};
+    CHECK_FALSE(actor.submitRequest(0, request).get());
+    CHECK(actor.submitRequest(1, request).get());
+    future<bool> tooMuch = actor.submitRequest(1, request);
+    CHECK_THROWS_AS(tooMuch.get(), SimulatorException);
+    CHECK(actor.submitRelease(1, request).get());
+
+    State final = actor.stop();
+    CHECK(final.tostring() == s.tostring());
+
+    future<bool> late = actor.submitRequest(1, request);
+    CHECK_THROWS_AS(late.get(), SimulatorException);
+  }
+
+  SECTION("Test stop handles every item submitted before it", "[actor]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    AdmissionActor actor(s);
+
+    // clients race the stop, every future must complete either with
+    // the admission result or with a rejection
+    const int numClients = 4;
+    const int numItems = 200;
+    vector<vector<future<bool>>> results(numClients);
+    vector<thread> clients;
+    for (int client = 0; client < numClients; client++)
+    {
+      clients.push_back(thread([&actor, &results, client]() {
+        int request[] = {0, 0, 0};
+        for (int item = 0; item < numItems; item++)
+        {
+          results[client].push_back(actor.submitRequest(1, request));
+        }
+      }));
+    }
+    actor.stop();
+    for (thread& client : clients)
+    {
+      client.join();
+    }
+
+    for (vector<future<bool>>& clientResults : results)
+    {
+      for (future<bool>& result : clientResults)
+      {
+        CHECK(result.wait_for(chrono::seconds(0)) == future_status::ready);
+      }
+    }
+  }
+}
+
+/**
+ * @brief SafetyWorkspace and isSafe(SafetyWorkspace&) tests
+ */
+TEST_CASE("Test reusable SafetyWorkspace safety checks", "[workspace]")
+{
+  const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+    "simfiles/state-05.sim", "simfiles/state-06.sim"};
+
+  SECTION("Test one workspace reused across states", "[workspace]")
+  {
+    SafetyWorkspace workspace;
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      vector<int> safeSequence;
+      bool safe = s.isSafe(safeSequence);
+      CHECK(s.isSafe(workspace) == safe);
+      CHECK(s.isSafe() == safe);
+      CHECK(vector<int>(workspace.sequence, workspace.sequence + workspace.sequenceLength) == safeSequence);
+    }
+  }
+
+  SECTION("Test completed bitmap", "[workspace]")
+  {
+    SafetyWorkspace workspace;
+    workspace.markCompleted(0);
+    workspace.markCompleted(MAX_PROCESSES - 1);
+    CHECK(workspace.isCompleted(0));
+    CHECK_FALSE(workspace.isCompleted(1));
+    CHECK(workspace.isCompleted(MAX_PROCESSES - 1));
+  }
+
+  SECTION("Test concurrent checks of a shared const state", "[workspace]")
+  {
+    State s3;
+    s3.loadState("simfiles/state-03.sim");
+    State s4;
+    s4.loadState("simfiles/state-04.sim");
+    const State& safeState = s3;
+    const State& unsafeState = s4;
+
+    vector<int> mismatches(4, 0);
+    vector<thread> checkers;
+    for (int checker = 0; checker < 4; checker++)
+    {
+      checkers.push_back(thread([&, checker]() {
+        SafetyWorkspace workspace;
+        for (int check = 0; check < 1000; check++)
+        {
+          mismatches[checker] += not safeState.isSafe(workspace);
+          mismatches[checker] += unsafeState.isSafe(workspace);
+        }
+      }));
+    }
+    for (int checker = 0; checker < 4; checker++)
+    {
+      checkers[checker].join();
+      CHECK(mismatches[checker] == 0);
+    }
+  }
+}
+
+/**
+ * @brief isSafe() unsafe certificate tests
+ */
+TEST_CASE("Test State isSafe() unsafe certificates", "[certificate]")
+{
+  SECTION("Test certificate of a safe state is empty", "[certificate]")
+  {
+    State s;
+    s.loadState("simfiles/state-03.sim");
+    vector<int> safeSequence;
+    UnsafeCertificate certificate;
+    CHECK(s.isSafe(safeSequence, certificate));
+    CHECK(certificate.blockedProcesses.empty());
+    CHECK(certificate.shortfall.empty());
+    CHECK(certificate.bottleneckResources.empty());
+    CHECK(certificateToString(certificate) == "No blocked processes, state is safe\n");
+  }
+
+  SECTION("Test certificate of an unsafe state", "[certificate]")
+  {
+    State s;
+    s.loadState("simfiles/state-04.sim");
+    vector<int> safeSequence;
+    UnsafeCertificate certificate;
+    CHECK_FALSE(s.isSafe(safeSequence, certificate));
+    CHECK(safeSequence.empty());
+
+    CHECK(certificate.available == vector<int>({3, 1, 2, 1}));
+    CHECK(certificate.blockedProcesses == vector<int>({0, 1, 2, 3, 4, 5}));
+    CHECK(vector<int>(certificate.shortfall.begin() + 4, certificate.shortfall.begin() + 8) == vector<int>({0, 0, 0, 1}));
+    CHECK(certificate.blockedCount == vector<int>({2, 4, 3, 3}));
+    CHECK(certificate.bottleneckResources == vector<int>({1, 2, 3, 0}));
+  }
+
+  SECTION("Test certificate matches the verdict and blocks every process left", "[certificate]")
+  {
+    const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim", "simfiles/state-06.sim"};
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      vector<int> safeSequence;
+      UnsafeCertificate certificate;
+      bool safe = s.isSafe(safeSequence, certificate);
+      CHECK(safe == s.isSafe());
+      CHECK(safeSequence.size() + certificate.blockedProcesses.size() == static_cast<size_t>(s.getNumProcesses()));
+
+      // every blocked process is short of at least one resource
+      int numResources = s.getNumResources();
+      for (size_t row = 0; row < certificate.blockedProcesses.size(); row++)
+      {
+        int shortResources = 0;
+        for (int resource = 0; resource < numResources; resource++)
+        {
+          shortResources += certificate.shortfall[row * numResources + resource] > 0;
+        }
+        CHECK(shortResources > 0);
+      }
+    }
+  }
+}
+
+/**
+ * @brief NeedSummaryTree and isSafe(NeedSummaryTree&) tests
+ */
+TEST_CASE("Test minimum need summary tree candidate search", "[tree]")
+{
+  SECTION("Test summary tree finds the same safe sequences", "[tree]")
+  {
+    const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim", "simfiles/state-06.sim"};
+    NeedSummaryTree tree;
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      vector<int> expected;
+      bool safe = s.isSafe(expected);
+      vector<int> safeSequence;
+      CHECK(s.isSafe(tree, safeSequence) == safe);
+      CHECK(safeSequence == expected);
+    }
+  }
+
+  SECTION("Test blocks that can not run are skipped", "[tree]")
+  {
+    // every process but the last needs more than exists, so only the
+    // last block can hold a candidate
+    int numProcesses = MAX_PROCESSES;
+    vector<int> total = {1, 1};
+    vector<int> claims(numProcesses * 2, 2);
+    vector<int> allocations(numProcesses * 2, 0);
+    claims[(numProcesses - 1) * 2] = 1;
+    claims[(numProcesses - 1) * 2 + 1] = 0;
+
+    State s;
+    s.loadState(numProcesses, 2, total, claims, allocations);
+    NeedSummaryTree tree;
+    tree.reset(s);
+    int available[] = {1, 1};
+    CHECK(tree.findCandidateProcess(available) == numProcesses - 1);
+    tree.markCompleted(numProcesses - 1);
+    CHECK(tree.isCompleted(numProcesses - 1));
+    CHECK(tree.findCandidateProcess(available) == NO_CANDIDATE);
+
+    int plenty[] = {2, 2};
+    CHECK(tree.findCandidateProcess(plenty) == 0);
+    tree.markCompleted(0);
+    CHECK(tree.findCandidateProcess(plenty) == 1);
+
+    vector<int> safeSequence;
+    CHECK_FALSE(s.isSafe(tree, safeSequence));
+    CHECK(safeSequence == vector<int>({numProcesses - 1}));
+  }
+}
+
+/**
+ * @brief State loadAllocationSnapshot() tests
+ */
+TEST_CASE("Test streaming allocation snapshots against cached claims", "[stream]")
+{
+  SECTION("Test snapshots replace only the allocations", "[stream]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    State original = s;
+
+    stringstream snapshots;
+    snapshots << "# snapshot 0, the allocations of the loaded state" << endl
+              << "1 0 0" << endl
+              << "6 1 2" << endl
+              << "2 1 1" << endl
+              << "0 0 2" << endl
+              << endl
+              << "# snapshot 1, nothing allocated" << endl
+              << "0 0 0 0 0 0" << endl
+              << "0 0 0 0 0 0" << endl
+              << "# snapshot 2, P3 is allocated more than exists" << endl
+              << "0 0 0  0 0 0  0 0 0  10 0 0" << endl
+              << "# no more snapshots" << endl;
+
+    CHECK(s.loadAllocationSnapshot(snapshots));
+    CHECK(s.tostring() == original.tostring());
+    CHECK(s.isSafe());
+
+    CHECK(s.loadAllocationSnapshot(snapshots));
+    CHECK(s.getNumNegativeValues() == 0);
+    CHECK(s.getResourceAvailable(0) == 9);
+    CHECK(s.getNeed(1, 0) == 6);
+    CHECK(s.getClaim(1, 0) == 6);
+    CHECK(s.isSafe());
+
+    CHECK(s.loadAllocationSnapshot(snapshots));
+    CHECK(s.getNumNegativeValues() == 2);
+    CHECK(s.getResourceAvailable(0) == -1);
+
+    CHECK_FALSE(s.loadAllocationSnapshot(snapshots));
+    CHECK_FALSE(s.loadAllocationSnapshot(snapshots));
+  }
+
+  SECTION("Test truncated snapshots throw", "[stream]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    State original = s;
+    stringstream snapshots("0 0 0\n0 0 0\n2 1");
+    CHECK_THROWS_AS(s.loadAllocationSnapshot(snapshots), SimulatorException);
+    CHECK(s.tostring() == original.tostring());
+
+    stringstream malformed("0 0 x\n");
+    CHECK_THROWS_AS(s.loadAllocationSnapshot(malformed), SimulatorException);
+    CHECK(s.tostring() == original.tostring());
+
+    // a failed compact snapshot also leaves every row as it was
+    CompactState compact(original);
+    stringstream compactSnapshots("0 0 0\n0 0 0\n2 1");
+    CHECK_THROWS_AS(compact.loadAllocationSnapshot(compactSnapshots), SimulatorException);
+    for (int process = 0; process < original.getNumProcesses(); process++)
+    {
+      for (int resource = 0; resource < original.getNumResources(); resource++)
+      {
+        CHECK(compact.getAllocation(process, resource) == original.getAllocation(process, resource));
+      }
+    }
+    for (int resource = 0; resource < original.getNumResources(); resource++)
+    {
+      CHECK(compact.getResourceAvailable(resource) == original.getResourceAvailable(resource));
+    }
+
+    stringstream empty("");
+    CHECK_FALSE(s.loadAllocationSnapshot(empty));
+  }
+}
+
+/**
+ * @brief Process Initiation Denial and policy simulation tests
+ */
+TEST_CASE("Test Process Initiation Denial admission", "[initiation]")
+{
+  SECTION("Test claim sums are inferred and kept up to date", "[initiation]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    CHECK(s.getClaimSum(0) == 16);
+    CHECK(s.getClaimSum(1) == 6);
+    CHECK(s.getClaimSum(2) == 11);
+
+    // the claims of state-01 already exceed the total resources
+    int claim[] = {0, 0, 0};
+    CHECK_FALSE(s.canInitiateProcess(claim));
+    CHECK(s.canInitiateProcess(claim, RESOURCE_ALLOCATION_DENIAL));
+
+    // terminating P1 frees its claims and allocations, and P3 takes
+    // its place
+    s.terminateProcess(1);
+    CHECK(s.getNumProcesses() == 3);
+    CHECK(s.getClaimSum(0) == 10);
+    CHECK(s.getResourceAvailable(0) == 6);
+    CHECK(s.getClaim(1, 0) == 4);
+    CHECK(s.getAllocation(1, 2) == 2);
+    CHECK_THROWS_AS(s.terminateProcess(3), SimulatorException);
+  }
+
+  SECTION("Test initiating and terminating processes", "[initiation]")
+  {
+    State s;
+    s.loadState(0, 2, vector<int>({4, 2}), vector<int>(), vector<int>());
+    int first[] = {3, 1};
+    int second[] = {2, 1};
+    int third[] = {1, 1};
+    CHECK(s.initiateProcess(first) == 0);
+    CHECK(s.getNeed(0, 0) == 3);
+    CHECK(s.initiateProcess(second) == NO_CANDIDATE);
+    CHECK(s.initiateProcess(third) == 1);
+    CHECK(s.getClaimSum(0) == 4);
+    CHECK(s.getClaimSum(1) == 2);
+
+    // processes admitted under process initiation denial can never
+    // deadlock, so requests for available resources are granted
+    int request[] = {2, 1};
+    CHECK(s.requestResources(0, request, PROCESS_INITIATION_DENIAL));
+    CHECK(s.requestResources(1, third, PROCESS_INITIATION_DENIAL));
+    CHECK(s.isSafe());
+
+    s.terminateProcess(0);
+    CHECK(s.getClaimSum(0) == 1);
+    CHECK(s.initiateProcess(second) == 1);
+    CHECK(s.getResourceAvailable(0) == 3);
+  }
+
+  SECTION("Test both policies complete every job of a trace", "[initiation]")
+  {
+    PolicyTrace trace = loadPolicyTrace("simfiles/trace-01.trace");
+    CHECK(trace.jobs.size() == 12);
+    CHECK(trace.total == vector<int>({9, 3, 6}));
+
+    PolicyResult rad = simulatePolicy(trace, RESOURCE_ALLOCATION_DENIAL);
+    PolicyResult pid = simulatePolicy(trace, PROCESS_INITIATION_DENIAL);
+    CHECK(rad.numCompleted == 12);
+    CHECK(pid.numCompleted == 12);
+    CHECK(pid.numDeniedRequests == 0);
+    CHECK(rad.totalWait <= pid.totalWait);
+    CHECK(rad.utilization > 0.0);
+    CHECK(pid.utilization <= 1.0);
+
+    CHECK_THROWS_AS(loadPolicyTrace("simfiles/no-such.trace"), SimulatorException);
+  }
+}
+
+/**
+ * @brief SafetyEngine and EngineSelector tests
+ */
+TEST_CASE("Test safety engines and autotuning engine selector", "[engine]")
+{
+  const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+    "simfiles/state-05.sim", "simfiles/state-06.sim"};
+
+  SECTION("Test every engine agrees with isSafe()", "[engine]")
+  {
+    EngineSelector selector;
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      for (int engine = 0; engine < selector.getNumEngines(); engine++)
+      {
+        CHECK(selector.getEngine(engine).isSafe(s) == s.isSafe());
+      }
+      CHECK(selector.isSafe(s) == s.isSafe());
+    }
+  }
+
+  SECTION("Test shape buckets", "[engine]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    // 4 processes, 3 resources, 8 of 12 needs nonzero, claims up to 6
+    int expected = ((2 * SIZE_BUCKETS + 2) * DENSITY_BUCKETS + 2) * VALUE_WIDTH_BUCKETS + 1;
+    CHECK(shapeBucket(s) == expected);
+
+    for (int bucket = 0; bucket < SHAPE_BUCKETS; bucket += 37)
+    {
+      State representative = representativeState(bucket);
+      CHECK(representative.getNumNegativeValues() == 0);
+      CHECK(representative.isSafe());
+      CHECK(shapeBucket(representative) / (DENSITY_BUCKETS * VALUE_WIDTH_BUCKETS) ==
+            bucket / (DENSITY_BUCKETS * VALUE_WIDTH_BUCKETS));
+    }
+  }
+
+  SECTION("Test shape statistics are kept up to date", "[engine]")
+  {
+    // count the nonzero needs and find the largest claim the slow way
+    auto checkShape = [](const State& state) {
+      int nonzeroNeeds = 0;
+      int maxClaim = 0;
+      for (int process = 0; process < state.getNumProcesses(); process++)
+      {
+        for (int resource = 0; resource < state.getNumResources(); resource++)
+        {
+          nonzeroNeeds += (state.getNeed(process, resource) != 0);
+          maxClaim = max(maxClaim, state.getClaim(process, resource));
+        }
+      }
+      CHECK(state.getNumNonzeroNeeds() == nonzeroNeeds);
+      // terminating a process or lowering a claim may leave the
+      // largest claim as an upper bound until the next inference
+      CHECK(state.getMaxClaim() >= maxClaim);
+      return maxClaim;
+    };
+
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    CHECK(s.getNumNonzeroNeeds() == 8);
+    CHECK(s.getMaxClaim() == checkShape(s));
+
+    int request[] = {0, 0, 1};
+    CHECK(s.requestResources(1, request));
+    checkShape(s);
+    s.releaseResources(1, request);
+    checkShape(s);
+    int denied[] = {0, 0, 1};
+    CHECK_FALSE(s.requestResources(0, denied));
+    checkShape(s);
+
+    int processClaim[] = {9, 0, 1};
+    int process = s.initiateProcess(processClaim, RESOURCE_ALLOCATION_DENIAL);
+    REQUIRE(process != NO_CANDIDATE);
+    CHECK(s.getMaxClaim() == checkShape(s));
+    CHECK(s.getMaxClaim() == 9);
+    s.terminateProcess(process);
+    checkShape(s);
+
+    State grown = s;
+    int grant[] = {0, 0, 1};
+    CHECK(grown.requestResources(1, grant));
+    s.applyDelta(s.diff(grown));
+    checkShape(s);
+
+    State p;
+    p.loadState("simfiles/state-03.sim");
+    State parallel = p;
+    parallel.inferStateInformationParallel(3);
+    CHECK(parallel.getNumNonzeroNeeds() == p.getNumNonzeroNeeds());
+    CHECK(parallel.getMaxClaim() == p.getMaxClaim());
+    CHECK(p.getMaxClaim() == checkShape(p));
+  }
+
+  SECTION("Test tuning is saved and loaded", "[engine]")
+  {
+    EngineSelector tuned;
+    tuned.tune(1);
+    string filename = "engine-tuning-test.txt";
+    tuned.saveTuning(filename);
+
+    EngineSelector loaded;
+    loaded.loadTuning(filename);
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      CHECK(loaded.select(s).getName() == tuned.select(s).getName());
+      CHECK(loaded.isSafe(s) == s.isSafe());
+    }
+    remove(filename.c_str());
+    CHECK_THROWS_AS(loaded.loadTuning(filename), SimulatorException);
+  }
+}
+
+/**
+ * @brief CompactState tests
+ */
+TEST_CASE("Test compact claim/allocation state", "[compact]")
+{
+  SECTION("Test compact states are at least a third smaller", "[compact]")
+  {
+    size_t matrixBytes = sizeof(int) * MAX_PROCESSES * MAX_RESOURCES;
+    CHECK(sizeof(State) - sizeof(CompactState) >= matrixBytes);
+    CHECK(3 * sizeof(CompactState) <= 2 * sizeof(State) + 3 * sizeof(int) * MAX_RESOURCES);
+  }
+
+  SECTION("Test compact states check safety like State", "[compact]")
+  {
+    const char* files[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim", "simfiles/state-06.sim"};
+    State s;
+    for (const char* file : files)
+    {
+      s.loadState(file);
+      CompactState compact(s);
+      CHECK(compact.getNumProcesses() == s.getNumProcesses());
+      for (int process = 0; process < s.getNumProcesses(); process++)
+      {
+        for (int resource = 0; resource < s.getNumResources(); resource++)
+        {
+          CHECK(compact.getNeed(process, resource) == s.getNeed(process, resource));
+        }
+      }
+
+      vector<int> expected;
+      vector<int> safeSequence;
+      CHECK(compact.isSafe(safeSequence) == s.isSafe(expected));
+      CHECK(safeSequence == expected);
+      CHECK(compact.isSafe() == s.isSafe());
+    }
+  }
+
+  SECTION("Test claim needs kernels of every width", "[compact]")
+  {
+    int claim[16];
+    int allocation[16];
+    int available[16];
+    for (int resource = 0; resource < 16; resource++)
+    {
+      claim[resource] = resource + 2;
+      allocation[resource] = 2;
+      available[resource] = resource;
+    }
+    int widths[] = {1, 3, 4, 8, 16};
+    for (int width : widths)
+    {
+      const ResourceKernels* kernels = selectResourceKernels(width);
+      CHECK(kernels->claimNeedsAreMet(width, claim, allocation, available));
+      allocation[width - 1] = 1;
+      CHECK_FALSE(kernels->claimNeedsAreMet(width, claim, allocation, available));
+      allocation[width - 1] = 2;
+    }
+  }
+
+  SECTION("Test streaming snapshots into a compact state", "[compact]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    CompactState compact(s);
+    stringstream snapshots("0 0 0  0 0 0  0 0 0  0 0 0\n# unsafe, nothing is available\n3 2 0  4 1 0  2 0 4  0 0 2\n");
+
+    CHECK(compact.loadAllocationSnapshot(snapshots));
+    CHECK(compact.getResourceAvailable(0) == 9);
+    CHECK(compact.getClaim(1, 0) == 6);
+    CHECK(compact.isSafe());
+
+    CHECK(compact.loadAllocationSnapshot(snapshots));
+    CHECK(compact.getResourceAvailable(0) == 0);
+    CHECK(compact.getResourceAvailable(1) == 0);
+    CHECK(compact.getResourceAvailable(2) == 0);
+    CHECK_FALSE(compact.isSafe());
+    CHECK_FALSE(compact.loadAllocationSnapshot(snapshots));
+  }
+}
+
+/**
+ * @brief ModelChecker and VisitedSet tests
+ */
+TEST_CASE("Test explicit state model checking of request protocols", "[model]")
+{
+  SECTION("Test finding a deadlock and its shortest trace", "[model]")
+  {
+    ProcessScript script = loadProcessScript("simfiles/script-01.script");
+    ModelCheckResult result = ModelChecker(script, false).check();
+    CHECK(result.deadlockFound);
+    CHECK(result.trace == vector<int>({0, 1}));
+    CHECK(result.deadlockCounters == vector<int>({1, 1, 0}));
+
+    // the Banker's algorithm never admits the second lock
+    result = ModelChecker(script, true).check();
+    CHECK_FALSE(result.deadlockFound);
+    CHECK(result.trace.empty());
+    CHECK(result.numStates == 44);
+  }
+
+  SECTION("Test parallel frontiers explore the same state space", "[model]")
+  {
+    // dining philosophers, each takes its left then its right fork
+    // and eats twice
+    ProcessScript script;
+    int numPhilosophers = 6;
+    script.total.assign(numPhilosophers, 1);
+    script.steps.resize(numPhilosophers);
+    for (int philosopher = 0; philosopher < numPhilosophers; philosopher++)
+    {
+      vector<int> left(numPhilosophers, 0);
+      vector<int> right(numPhilosophers, 0);
+      vector<int> both(numPhilosophers, 0);
+      left[philosopher] = 1;
+      right[(philosopher + 1) % numPhilosophers] = 1;
+      both[philosopher] = both[(philosopher + 1) % numPhilosophers] = 1;
+      for (int meal = 0; meal < 2; meal++)
+      {
+        script.steps[philosopher].push_back({REQUEST_STEP, left});
+        script.steps[philosopher].push_back({REQUEST_STEP, right});
+        script.steps[philosopher].push_back({RELEASE_STEP, both});
+      }
+    }
+
+    ModelCheckResult serial = ModelChecker(script, true, 1).check();
+    ModelCheckResult parallel = ModelChecker(script, true, 4).check();
+    CHECK_FALSE(serial.deadlockFound);
+    CHECK_FALSE(parallel.deadlockFound);
+    CHECK(parallel.numStates == serial.numStates);
+    CHECK(parallel.numTransitions == serial.numTransitions);
+    CHECK(parallel.depth == serial.depth);
+
+    // every philosopher holding their left fork is the only deadlock,
+    // and replaying any shortest trace must reach it
+    parallel = ModelChecker(script, false, 4).check();
+    CHECK(parallel.deadlockFound);
+    CHECK(parallel.trace.size() == static_cast<size_t>(numPhilosophers));
+    vector<int> counters(numPhilosophers, 0);
+    for (int process : parallel.trace)
+    {
+      counters[process]++;
+    }
+    CHECK(counters == parallel.deadlockCounters);
+    CHECK(counters == vector<int>(numPhilosophers, 1));
+  }
+
+  SECTION("Test the visited set", "[model]")
+  {
+    VisitedSet visited(100);
+    CHECK(visited.insert(0, 0));
+    CHECK(visited.insert(5, 0));
+    CHECK_FALSE(visited.insert(5, 3));
+    CHECK(visited.contains(5));
+    CHECK_FALSE(visited.contains(6));
+    CHECK(visited.getParent(5) == 0);
+    CHECK(visited.size() == 2);
+    CHECK_THROWS_AS(visited.getParent(6), SimulatorException);
+
+    VisitedSet tiny(8);
+    CHECK_THROWS_AS(
+      [&tiny]() {
+        for (uint64_t key = 0; key < 8; key++)
+        {
+          tiny.insert(key, 0);
+        }
+      }(),
+      SimulatorException);
+  }
+
+  SECTION("Test invalid process scripts", "[model]")
+  {
+    ProcessScript script;
+    script.total = {1};
+    script.steps.resize(1);
+    script.steps[0].push_back({RELEASE_STEP, {1}});
+    CHECK_THROWS_AS(ModelChecker(script, false), SimulatorException);
+
+    script.steps[0][0] = {REQUEST_STEP, {2}};
+    CHECK_THROWS_AS(ModelChecker(script, false), SimulatorException);
+    CHECK_THROWS_AS(loadProcessScript("simfiles/no-such-script.script"), SimulatorException);
+  }
+}
+
+/**
+ * @brief ParallelSimulation tests
+ */
+TEST_CASE("Test parallel discrete event workload simulation", "[parallel-sim]")
+{
+  SECTION("Test simulating a workload file", "[parallel-sim]")
+  {
+    Workload workload = loadWorkload("simfiles/workload-01.workload");
+    CHECK(workload.groupTotal.size() == 2);
+    CHECK(workload.transferDelay == 3);
+    CHECK(workload.jobs.size() == 8);
+    CHECK(workload.jobs[3].stages.size() == 3);
+    CHECK(workload.jobs[3].stages[2].claim == vector<int>({1, 1}));
+
+    WorkloadResult rad = simulateWorkload(workload, RESOURCE_ALLOCATION_DENIAL);
+    WorkloadResult pid = simulateWorkload(workload, PROCESS_INITIATION_DENIAL);
+    CHECK(rad.numCompleted == 8);
+    CHECK(pid.numCompleted == 8);
+    CHECK(rad.numEvents == pid.numEvents);
+    CHECK(rad.makespan == 26);
+    CHECK(pid.makespan == 34);
+    CHECK(pid.numDeniedRequests == 0);
+  }
+
+  SECTION("Test results do not depend on the number of threads", "[parallel-sim]")
+  {
+    Workload workload = generateWorkload(16, 3, 20000, 42);
+    WorkloadResult serial = simulateWorkload(workload, RESOURCE_ALLOCATION_DENIAL, 1);
+    CHECK(serial.numCompleted == 20000);
+    int threadCounts[] = {2, 5, 16};
+    for (int numThreads : threadCounts)
+    {
+      WorkloadResult parallel = simulateWorkload(workload, RESOURCE_ALLOCATION_DENIAL, numThreads);
+      CHECK(parallel.numEvents == serial.numEvents);
+      CHECK(parallel.numWindows == serial.numWindows);
+      CHECK(parallel.numCompleted == serial.numCompleted);
+      CHECK(parallel.makespan == serial.makespan);
+      CHECK(parallel.totalWait == serial.totalWait);
+      CHECK(parallel.totalResponse == serial.totalResponse);
+      CHECK(parallel.numDeniedRequests == serial.numDeniedRequests);
+      CHECK(parallel.utilization == serial.utilization);
+    }
+  }
+
+  SECTION("Test invalid workloads", "[parallel-sim]")
+  {
+    Workload workload = generateWorkload(2, 2, 10, 7);
+    workload.transferDelay = 0;
+    CHECK_THROWS_AS(simulateWorkload(workload, RESOURCE_ALLOCATION_DENIAL), SimulatorException);
+
+    workload.transferDelay = 5;
+    workload.jobs[0].stages[0].claim[0] = workload.groupTotal[workload.jobs[0].stages[0].group][0] + 1;
+    CHECK_THROWS_AS(simulateWorkload(workload, RESOURCE_ALLOCATION_DENIAL), SimulatorException);
+    CHECK_THROWS_AS(loadWorkload("simfiles/no-such-workload.workload"), SimulatorException);
+  }
+}
+
+/**
+ * @brief State adjustCapacity() tests
+ */
+TEST_CASE("Test State adjustCapacity() functionality", "[capacity]")
+{
+  SECTION("Test growing and shrinking capacity matches a full check", "[capacity]")
+  {
+    State s;
+    s.loadState("simfiles/state-02.sim");
+    vector<int> safeSequence;
+    bool safe = s.isSafe(safeSequence);
+
+    int resources[] = {0, 2, 1, 0, 2, 0, 1, 2};
+    int deltas[] = {3, -2, 1, -5, 4, 2, -1, -3};
+    for (int step = 0; step < 8; step++)
+    {
+      int total = s.getResourceTotal(resources[step]);
+      int available = s.getResourceAvailable(resources[step]);
+      vector<int> infeasible;
+      safe = s.adjustCapacity(resources[step], deltas[step], safeSequence, infeasible);
+      CHECK(s.getResourceTotal(resources[step]) == total + deltas[step]);
+      CHECK(s.getResourceAvailable(resources[step]) == available + deltas[step]);
+
+      vector<int> expected;
+      CHECK(safe == s.isSafe(expected));
+      CHECK(safe == (safeSequence.size() == static_cast<size_t>(s.getNumProcesses())));
+    }
+  }
+
+  SECTION("Test reporting processes that became infeasible", "[capacity]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    vector<int> safeSequence;
+    s.isSafe(safeSequence);
+    vector<int> infeasible;
+
+    // only P1 claims more than 5 of R0, and P3 more than 3
+    s.adjustCapacity(0, -4, safeSequence, infeasible);
+    CHECK(infeasible == vector<int>({1}));
+    s.adjustCapacity(0, -2, safeSequence, infeasible);
+    CHECK(infeasible == vector<int>({3}));
+    CHECK(s.getNumNegativeValues() == 1);
+    CHECK_FALSE(s.isSafe());
+
+    s.adjustCapacity(0, 6, safeSequence, infeasible);
+    CHECK(infeasible.empty());
+    CHECK(s.getNumNegativeValues() == 0);
+
+    CHECK_THROWS_AS(s.adjustCapacity(3, 1), SimulatorException);
+    CHECK_THROWS_AS(s.adjustCapacity(0, -10), SimulatorException);
+  }
+}
+
+/**
+ * @brief VectorOps tests
+ */
+TEST_CASE("Test element-wise vector operations", "[vector-ops]")
+{
+  // every width up to MAX_RESOURCES, so both the vector loop and the
+  // scalar remainder are covered
+  mt19937 generator(97);
+  uniform_int_distribution<int> valueDistribution(-50, 50);
+  for (int numItems = 0; numItems <= MAX_RESOURCES; numItems++)
+  {
+    int first[MAX_RESOURCES];
+    int second[MAX_RESOURCES];
+    int result[MAX_RESOURCES];
+    int expected[MAX_RESOURCES];
+    for (int item = 0; item < MAX_RESOURCES; item++)
+    {
+      first[item] = valueDistribution(generator);
+      second[item] = valueDistribution(generator);
+    }
+
+    vectorCopy(numItems, first, result);
+    CHECK(equal(first, first + numItems, result));
+
+    copy(second, second + MAX_RESOURCES, result);
+    vectorAdd(numItems, first, result);
+    transform(first, first + numItems, second, expected, plus<int>());
+    CHECK(equal(expected, expected + numItems, result));
+
+    vectorSubtract(numItems, first, second, result);
+    transform(first, first + numItems, second, expected, minus<int>());
+    CHECK(equal(expected, expected + numItems, result));
+    CHECK(vectorCountNegative(numItems, result) == count_if(expected, expected + numItems, [](int value) { return value < 0; }));
+    CHECK(vectorCountNonzero(numItems, result) == count_if(expected, expected + numItems, [](int value) { return value != 0; }));
+
+    vectorMin(numItems, first, second, result);
+    transform(first, first + numItems, second, expected, [](int a, int b) { return min(a, b); });
+    CHECK(equal(expected, expected + numItems, result));
+    CHECK(vectorLessEqual(numItems, result, first));
+    CHECK(vectorLessEqual(numItems, result, second));
+
+    vectorMax(numItems, first, second, result);
+    transform(first, first + numItems, second, expected, [](int a, int b) { return max(a, b); });
+    CHECK(equal(expected, expected + numItems, result));
+
+    bool lessEqual = equal(first, first + numItems, second, [](int a, int b) { return a <= b; });
+    CHECK(vectorLessEqual(numItems, first, second) == lessEqual);
+    if (numItems > 0)
+    {
+      // a single failing value, in the last position, must be found
+      copy(first, first + numItems, result);
+      CHECK(vectorLessEqual(numItems, first, result));
+      result[numItems - 1]--;
+      CHECK_FALSE(vectorLessEqual(numItems, first, result));
+
+      vectorSubtract(numItems, first, second, result);
+      CHECK(vectorDifferenceLessEqual(numItems, first, second, result));
+      result[numItems - 1]--;
+      CHECK_FALSE(vectorDifferenceLessEqual(numItems, first, second, result));
+    }
+
+    int need[MAX_RESOURCES];
+    int allocationSum[MAX_RESOURCES] = {0};
+    int claimSum[MAX_RESOURCES] = {0};
+    int negativeNeeds = vectorInferRow(numItems, first, second, need, allocationSum, claimSum);
+    transform(first, first + numItems, second, expected, minus<int>());
+    CHECK(equal(expected, expected + numItems, need));
+    CHECK(equal(second, second + numItems, allocationSum));
+    CHECK(equal(first, first + numItems, claimSum));
+    CHECK(negativeNeeds == count_if(expected, expected + numItems, [](int value) { return value < 0; }));
+  }
+}
+
+/**
+ * @brief ExternalSafetyChecker tests
+ */
+TEST_CASE("Test out-of-core safety evaluation", "[external]")
+{
+  const string filename = "external-test.bin";
+
+  SECTION("Test external verdicts match the in memory verdicts", "[external]")
+  {
+    string simfiles[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim"};
+    for (const string& simfile : simfiles)
+    {
+      State s;
+      s.loadState(simfile);
+      writeExternalState(s, filename);
+      ExternalSafetyChecker checker(filename, 2);
+      CHECK(checker.getNumProcesses() == s.getNumProcesses());
+      CHECK(checker.getNumResources() == s.getNumResources());
+      for (int resource = 0; resource < s.getNumResources(); resource++)
+      {
+        CHECK(checker.getResourceAvailable(resource) == s.getResourceAvailable(resource));
+      }
+      CHECK(checker.isSafe() == s.isSafe());
+    }
+  }
+
+  SECTION("Test passes repeat until a fixed point", "[external]")
+  {
+    // process p needs numProcesses - p units, and holds one, so only
+    // the last process can run first and each pass completes just one
+    int numProcesses = 50;
+    {
+      ExternalStateWriter writer(filename, {numProcesses});
+      for (int process = 0; process < numProcesses; process++)
+      {
+        int claim = numProcesses - process + 1;
+        int allocation = 1;
+        writer.appendProcess(&claim, &allocation);
+      }
+    }
+    ExternalSafetyChecker chain(filename, 7);
+    CHECK(chain.getResourceAvailable(0) == 0);
+    CHECK_FALSE(chain.isSafe());
+    CHECK(chain.getNumPasses() == 1);
+
+    {
+      ExternalStateWriter writer(filename, {numProcesses + 1});
+      for (int process = 0; process < numProcesses; process++)
+      {
+        int claim = numProcesses - process + 1;
+        int allocation = 1;
+        writer.appendProcess(&claim, &allocation);
+      }
+      CHECK(writer.getNumProcesses() == numProcesses);
+    }
+    ExternalSafetyChecker reversed(filename, 7);
+    CHECK(reversed.isSafe());
+    CHECK(reversed.getNumPasses() == numProcesses);
+  }
+
+  SECTION("Test streaming many blocks", "[external]")
+  {
+    int numProcesses = 100000;
+    {
+      ExternalStateWriter writer(filename, {3, 3, 3});
+      int claim[] = {2, 1, 2};
+      int allocation[] = {0, 0, 0};
+      for (int process = 0; process < numProcesses; process++)
+      {
+        writer.appendProcess(claim, allocation);
+      }
+    }
+    ExternalSafetyChecker checker(filename, 4096);
+    CHECK(checker.getNumProcesses() == numProcesses);
+    CHECK(checker.isSafe());
+    CHECK(checker.getNumPasses() == 1);
+  }
+
+  SECTION("Test invalid external state files", "[external]")
+  {
+    CHECK_THROWS_AS(ExternalSafetyChecker("simfiles/no-such-file.bin"), SimulatorException);
+    CHECK_THROWS_AS(ExternalSafetyChecker("simfiles/state-01.sim"), SimulatorException);
+    CHECK_THROWS_AS(ExternalStateWriter(filename, {}), SimulatorException);
+  }
+
+  SECTION("Test write errors are reported without terminating", "[external]")
+  {
+    // /dev/full fails every write once the stream buffer is flushed,
+    // the failing append throws and the writer is then destroyed
+    // during the unwind with a failed stream
+    auto appendUntilFull = []() {
+      ExternalStateWriter writer("/dev/full", {1});
+      int claim = 1;
+      int allocation = 0;
+      for (int process = 0; process < 1000000; process++)
+      {
+        writer.appendProcess(&claim, &allocation);
+      }
+    };
+    CHECK_THROWS_AS(appendUntilFull(), SimulatorException);
+
+    ExternalStateWriter writer("/dev/full", {1});
+    CHECK_THROWS_AS(writer.close(), SimulatorException);
+  }
+
+  remove(filename.c_str());
+}
+
+/**
+ * @brief PackedState tests
+ */
+TEST_CASE("Test frame-of-reference bit packed state", "[packed]")
+{
+  SECTION("Test packed needs, allocations and safe sequences match State", "[packed]")
+  {
+    string simfiles[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim"};
+    for (const string& simfile : simfiles)
+    {
+      State s;
+      s.loadState(simfile);
+      PackedState packed(s);
+      CHECK(packed.getNumProcesses() == s.getNumProcesses());
+      CHECK(packed.getNumResources() == s.getNumResources());
+      for (int resource = 0; resource < s.getNumResources(); resource++)
+      {
+        CHECK(packed.getResourceTotal(resource) == s.getResourceTotal(resource));
+        CHECK(packed.getResourceAvailable(resource) == s.getResourceAvailable(resource));
+      }
+      for (int process = 0; process < s.getNumProcesses(); process++)
+      {
+        for (int resource = 0; resource < s.getNumResources(); resource++)
+        {
+          CHECK(packed.getNeed(process, resource) == s.getNeed(process, resource));
+          CHECK(packed.getAllocation(process, resource) == s.getAllocation(process, resource));
+        }
+      }
+
+      vector<int> expected;
+      vector<int> sequence;
+      CHECK(packed.isSafe(sequence) == s.isSafe(expected));
+      CHECK(sequence == expected);
+    }
+  }
+
+  SECTION("Test packing wide, negative and straddling values", "[packed]")
+  {
+    // 3 * 21 bit offsets in column 0 straddle a word, and column 1
+    // spans the full int range
+    int numProcesses = 40;
+    vector<int> total = {4000000, 0, 7};
+    vector<int> claims;
+    vector<int> allocations;
+    for (int process = 0; process < numProcesses; process++)
+    {
+      int wide = (process * 104729) % 2000000;
+      int extreme = (process % 2 == 0) ? numeric_limits<int>::min() : numeric_limits<int>::max();
+      claims.insert(claims.end(), {wide, extreme, 3});
+      allocations.insert(allocations.end(), {0, 0, (process == 5) ? 1 : 0});
+    }
+    PackedState packed;
+    packed.loadState(numProcesses, 3, total, claims, allocations);
+    CHECK(packed.getResourceAvailable(2) == 6);
+    for (int process = 0; process < numProcesses; process++)
+    {
+      CHECK(packed.getNeed(process, 0) == claims[process * 3]);
+      CHECK(packed.getNeed(process, 1) == claims[process * 3 + 1]);
+      CHECK(packed.getNeed(process, 2) == claims[process * 3 + 2] - allocations[process * 3 + 2]);
+      CHECK(packed.getAllocation(process, 2) == allocations[process * 3 + 2]);
+    }
+    CHECK_FALSE(packed.isSafe());
+
+    CHECK_THROWS_AS(packed.loadState(1, MAX_RESOURCES + 1, vector<int>(MAX_RESOURCES + 1), {}, {}), SimulatorException);
+    CHECK_THROWS_AS(packed.loadState(2, 1, {1}, {1}, {0}), SimulatorException);
+  }
+
+  SECTION("Test large clustered states pack into a fraction of the ints", "[packed]")
+  {
+    // needs between 0 and 3 and allocations of 0 or 1 take 2 and 1
+    // bits, against 32 bits each as ints, and once the last process
+    // claims more than the total it can never run
+    int numProcesses = 20000;
+    int numResources = 4;
+    vector<int> total(numResources, numProcesses + 3);
+    vector<int> claims(numProcesses * numResources);
+    vector<int> allocations(numProcesses * numResources);
+    for (int process = 0; process < numProcesses; process++)
+    {
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        allocations[process * numResources + resource] = (process + resource) % 2;
+        claims[process * numResources + resource] = allocations[process * numResources + resource] + (process * 7 + resource) % 4;
+      }
+    }
+    PackedState packed;
+    packed.loadState(numProcesses, numResources, total, claims, allocations);
+    size_t unpackedBytes = 2 * sizeof(int) * numProcesses * numResources;
+    CHECK(packed.getPackedBytes() < unpackedBytes / 4);
+
+    vector<int> sequence;
+    CHECK(packed.isSafe(sequence));
+    CHECK(static_cast<int>(sequence.size()) == numProcesses);
+    CHECK(sequence[0] == 0);
+
+    claims[(numProcesses - 1) * numResources] = total[0] + 1;
+    packed.loadState(numProcesses, numResources, total, claims, allocations);
+    CHECK_FALSE(packed.isSafe(sequence));
+    CHECK(static_cast<int>(sequence.size()) == numProcesses - 1);
+  }
+}
+
+/**
+ * @brief State writeState() tests
+ */
+TEST_CASE("Test State writeState() parallel row formatting", "[format]")
+{
+  const string filename = "format-test.txt";
+
+  SECTION("Test written state is byte identical to tostring()", "[format]")
+  {
+    // the full 20 x 20 state splits unevenly across 3 and 7 threads,
+    // and more threads than processes fall back to one per process
+    State full;
+    vector<int> claims(MAX_PROCESSES * MAX_RESOURCES);
+    vector<int> allocations(MAX_PROCESSES * MAX_RESOURCES);
+    for (size_t cell = 0; cell < claims.size(); cell++)
+    {
+      allocations[cell] = cell % 13;
+      claims[cell] = allocations[cell] + (cell * 7) % 1000;
+    }
+    full.loadState(MAX_PROCESSES, MAX_RESOURCES, vector<int>(MAX_RESOURCES, 10000), claims, allocations);
+
+    vector<State> states(6);
+    string simfiles[] = {"simfiles/state-01.sim", "simfiles/state-02.sim", "simfiles/state-03.sim", "simfiles/state-04.sim",
+      "simfiles/state-05.sim"};
+    for (int index = 0; index < 5; index++)
+    {
+      states[index].loadState(simfiles[index]);
+    }
+    states[5] = full;
+
+    for (const State& s : states)
+    {
+      for (int numThreads : {1, 2, 3, 7, 50})
+      {
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(fd >= 0);
+        s.writeState(fd, numThreads);
+        close(fd);
+
+        ifstream written(filename);
+        stringstream contents;
+        contents << written.rdbuf();
+        CHECK(contents.str() == s.tostring());
+      }
+    }
+  }
+
+  SECTION("Test matrix rows concatenate to the whole matrix", "[format]")
+  {
+    State s;
+    s.loadState("simfiles/state-02.sim");
+    int numProcesses = s.getNumProcesses();
+    int numResources = s.getNumResources();
+    int matrix[MAX_PROCESSES][MAX_RESOURCES];
+    for (int process = 0; process < numProcesses; process++)
+    {
+      for (int resource = 0; resource < numResources; resource++)
+      {
+        matrix[process][resource] = s.getClaim(process, resource);
+      }
+    }
+    int middle = numProcesses / 2;
+    CHECK(matrixHeaderToString(numResources) + matrixRowsToString(0, middle, numResources, matrix) +
+            matrixRowsToString(middle, numProcesses, numResources, matrix) ==
+          matrixToString(numProcesses, numResources, matrix));
+    CHECK(matrixRowsToString(middle, middle, numResources, matrix) == "");
+  }
+
+  SECTION("Test writing to a bad file descriptor", "[format]")
+  {
+    State s;
+    s.loadState("simfiles/state-01.sim");
+    CHECK_THROWS_AS(s.writeState(-1, 2), SimulatorException);
+  }
+
+  remove(filename.c_str());
+}